@@ -4,9 +4,12 @@
 #include <string.h>
 #include <math.h>
 
+#include "../common/log.h"
+#include "../common/matrix.h"
+
 // Структура для передачи данных в поток
 typedef struct {
-    double **matrix;     // Указатель на матрицу
+    const Matrix *matrix;  // Матрица (один блок, см. matrix.h)
     int n;               // Размер матрицы
     int thread_id;       // ID потока (от 0 до p-1)
     int total_threads;   // Общее количество потоков
@@ -19,7 +22,7 @@ void* check_symmetry(void* arg) {
     int n = data->n;
     int thread_id = data->thread_id;
     int total_threads = data->total_threads;
-    double **matrix = data->matrix;
+    const Matrix *matrix = data->matrix;
     
     // Изначально предполагаем, что часть матрицы симметрична
     data->result = 1;
@@ -29,95 +32,58 @@ void* check_symmetry(void* arg) {
     for (int i = thread_id; i < n; i += total_threads) {
         // Проверяем только элементы выше главной диагонали
         // (нижние будут проверены другими потоками)
+        // Строка i идёт подряд, столбец i — с постоянным шагом ld
+        const double *row = matrix_row(matrix, i);
         for (int j = i + 1; j < n; j++) {
             // Сравниваем с заданной точностью (для вещественных чисел)
-            if (fabs(matrix[i][j] - matrix[j][i]) > 1e-9) {
+            if (fabs(row[j] - MAT(matrix, j, i)) > 1e-9) {
                 data->result = 0;
-                printf("Поток %d: Найдена несимметричность: "
+                log_debug("Поток %d: Найдена несимметричность: "
                        "a[%d][%d] = %.6f != a[%d][%d] = %.6f\n",
-                       thread_id, i, j, matrix[i][j], j, i, matrix[j][i]);
+                       thread_id, i, j, row[j], j, i, MAT(matrix, j, i));
                 pthread_exit(NULL);
             }
         }
     }
     
-    printf("Поток %d: Проверенная часть матрицы симметрична\n", thread_id);
+    log_debug("Поток %d: Проверенная часть матрицы симметрична\n", thread_id);
     pthread_exit(NULL);
 }
 
-// Функция для чтения матрицы из файла
-double** read_matrix_from_file(const char* filename, int* n, int* p) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Ошибка открытия файла");
-        return NULL;
-    }
-    
-    // Читаем размерность и количество потоков
-    if (fscanf(file, "%d %d", n, p) != 2) {
-        fprintf(stderr, "Ошибка чтения размерности матрицы и количества потоков\n");
-        fclose(file);
-        return NULL;
-    }
-    
-    // Выделяем память под матрицу
-    double** matrix = (double**)malloc(*n * sizeof(double*));
-    for (int i = 0; i < *n; i++) {
-        matrix[i] = (double*)malloc(*n * sizeof(double));
-    }
-    
-    // Читаем элементы матрицы
-    for (int i = 0; i < *n; i++) {
-        for (int j = 0; j < *n; j++) {
-            if (fscanf(file, "%lf", &matrix[i][j]) != 1) {
-                fprintf(stderr, "Ошибка чтения элемента [%d][%d]\n", i, j);
-                // Освобождаем память
-                for (int k = 0; k <= i; k++) {
-                    free(matrix[k]);
-                }
-                free(matrix);
-                fclose(file);
-                return NULL;
-            }
-        }
-    }
-    
-    fclose(file);
-    return matrix;
-}
-
 // Функция для генерации тестовой матрицы
-double** generate_test_matrix(int n, int is_symmetric) {
-    double** matrix = (double**)malloc(n * sizeof(double*));
+int generate_test_matrix(Matrix *matrix, int n, int is_symmetric) {
+    if (!matrix_alloc(matrix, n, MATRIX_DEFAULT)) return 0;
     for (int i = 0; i < n; i++) {
-        matrix[i] = (double*)malloc(n * sizeof(double));
+        double *row = matrix_row(matrix, i);
         for (int j = 0; j < n; j++) {
             if (is_symmetric) {
                 // Симметричная матрица: a[i][j] = i + j
-                matrix[i][j] = i + j;
+                row[j] = i + j;
             } else {
                 // Несимметричная матрица: a[i][j] = i * n + j
-                matrix[i][j] = i * n + j;
+                row[j] = i * n + j;
             }
         }
     }
-    return matrix;
+    return 1;
 }
 
 // Функция для вывода матрицы
-void print_matrix(double** matrix, int n) {
-    printf("Матрица %dx%d:\n", n, n);
+// Только на уровне отладки: для больших матриц вывод дороже самой проверки
+void print_matrix(const Matrix *matrix, int n) {
+    if (!log_enabled(LOG_DEBUG)) return;
+    log_debug("Матрица %dx%d:\n", n, n);
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
-            printf("%8.2f ", matrix[i][j]);
+            log_debug("%8.2f ", MAT(matrix, i, j));
         }
-        printf("\n");
+        log_debug("\n");
     }
 }
 
 // Основная функция
 int main(int argc, char* argv[]) {
-    double** matrix = NULL;
+    Matrix matrix;
     int n, p;
     
     // Проверяем аргументы командной строки
@@ -134,16 +100,19 @@ int main(int argc, char* argv[]) {
         printf("\nИспользуем тестовую матрицу 4x4\n");
         n = 4;
         p = 2;
-        matrix = generate_test_matrix(n, 1); // Симметричная матрица
-        print_matrix(matrix, n);
+        if (!generate_test_matrix(&matrix, n, 1)) { // Симметричная матрица
+            perror("Ошибка выделения памяти");
+            return 1;
+        }
+        print_matrix(&matrix, n);
     } else {
         // Читаем матрицу из файла
-        matrix = read_matrix_from_file(argv[1], &n, &p);
-        if (!matrix) {
+        if (!matrix_read(argv[1], &matrix, &p, MATRIX_DEFAULT)) {
             fprintf(stderr, "Не удалось прочитать матрицу из файла\n");
             return 1;
         }
-        print_matrix(matrix, n);
+        n = matrix.n;
+        print_matrix(&matrix, n);
     }
     
     printf("\nПроверка симметричности матрицы %dx%d с использованием %d потоков\n", 
@@ -160,7 +129,7 @@ int main(int argc, char* argv[]) {
     
     // Инициализируем данные для потоков
     for (int i = 0; i < p; i++) {
-        thread_data[i].matrix = matrix;
+        thread_data[i].matrix = &matrix;
         thread_data[i].n = n;
         thread_data[i].thread_id = i;
         thread_data[i].total_threads = p;
@@ -195,10 +164,7 @@ int main(int argc, char* argv[]) {
     }
     
     // Освобождаем память
-    for (int i = 0; i < n; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
+    matrix_free(&matrix);
     free(threads);
     free(thread_data);
     
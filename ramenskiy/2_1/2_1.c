@@ -3,86 +3,42 @@
 #include <omp.h>
 #include <math.h>
 
-// Функция для чтения матрицы из файла
-double** read_matrix_from_file(const char* filename, int* n, int* p) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Ошибка открытия файла");
-        return NULL;
-    }
-    
-    // Читаем размерность и количество потоков
-    if (fscanf(file, "%d %d", n, p) != 2) {
-        fprintf(stderr, "Ошибка чтения размерности матрицы и количества потоков\n");
-        fclose(file);
-        return NULL;
-    }
-    
-    // Выделяем память под матрицу
-    double** matrix = (double**)malloc(*n * sizeof(double*));
-    for (int i = 0; i < *n; i++) {
-        matrix[i] = (double*)malloc(*n * sizeof(double));
-    }
-    
-    // Читаем элементы матрицы
-    for (int i = 0; i < *n; i++) {
-        for (int j = 0; j < *n; j++) {
-            if (fscanf(file, "%lf", &matrix[i][j]) != 1) {
-                fprintf(stderr, "Ошибка чтения элемента [%d][%d]\n", i, j);
-                // Освобождаем память
-                for (int k = 0; k <= i; k++) {
-                    free(matrix[k]);
-                }
-                free(matrix);
-                fclose(file);
-                return NULL;
-            }
-        }
-    }
-    
-    fclose(file);
-    return matrix;
-}
+#include "../common/log.h"
+#include "../common/matrix.h"
 
 // Функция для генерации тестовой матрицы
-double** generate_test_matrix(int n, int is_symmetric) {
-    double** matrix = (double**)malloc(n * sizeof(double*));
+int generate_test_matrix(Matrix *matrix, int n, int is_symmetric) {
+    if (!matrix_alloc(matrix, n, MATRIX_DEFAULT)) return 0;
     for (int i = 0; i < n; i++) {
-        matrix[i] = (double*)malloc(n * sizeof(double));
+        double *row = matrix_row(matrix, i);
         for (int j = 0; j < n; j++) {
             if (is_symmetric) {
                 // Симметричная матрица: a[i][j] = i + j
-                matrix[i][j] = i + j;
+                row[j] = i + j;
             } else {
                 // Несимметричная матрица: a[i][j] = i * n + j
-                matrix[i][j] = i * n + j;
+                row[j] = i * n + j;
             }
         }
     }
-    return matrix;
+    return 1;
 }
 
 // Функция для вывода матрицы
-void print_matrix(double** matrix, int n) {
-    printf("Матрица %dx%d:\n", n, n);
+// Только на уровне отладки: для больших матриц вывод дороже самой проверки
+void print_matrix(const Matrix *matrix, int n) {
+    if (!log_enabled(LOG_DEBUG)) return;
+    log_debug("Матрица %dx%d:\n", n, n);
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
-            printf("%8.2f ", matrix[i][j]);
+            log_debug("%8.2f ", MAT(matrix, i, j));
         }
-        printf("\n");
+        log_debug("\n");
     }
 }
 
-// Функция для освобождения памяти матрицы
-void free_matrix(double** matrix, int n) {
-    for (int i = 0; i < n; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
-}
-
 // Функция проверки симметричности с использованием OpenMP
-int check_symmetric_omp(double** matrix, int n, int num_threads) {
+int check_symmetric_omp(const Matrix *matrix, int n, int num_threads) {
     int is_symmetric = 1;  // Предполагаем, что матрица симметрична
     
     // Устанавливаем количество потоков
@@ -97,18 +53,19 @@ int check_symmetric_omp(double** matrix, int n, int num_threads) {
         
         // Равномерно распределяем строки между потоками
         for (int i = thread_id; i < n; i += total_threads) {
+            const double *row = matrix_row(matrix, i);
             for (int j = i + 1; j < n; j++) {
                 // Сравниваем с плавающей точкой
-                if (fabs(matrix[i][j] - matrix[j][i]) > 1e-9) {
-                    // гарантирует, что только один поток за раз может выполнять этот блок
-                    #pragma omp critical
-                    {
-                        if (is_symmetric) {
-                            printf("Поток %d: Найдена несимметричность: "
-                                   "a[%d][%d] = %.6f != a[%d][%d] = %.6f\n",
-                                   thread_id, i, j, matrix[i][j], j, i, matrix[j][i]);
-                            is_symmetric = 0;
-                        }
+                if (fabs(row[j] - MAT(matrix, j, i)) > 1e-9) {
+                    // Флаг сбрасывается атомарно, без критической секции;
+                    // о несимметричности сообщает только первый нашедший
+                    int was_symmetric;
+                    #pragma omp atomic capture
+                    { was_symmetric = is_symmetric; is_symmetric = 0; }
+                    if (was_symmetric) {
+                        log_debug("Поток %d: Найдена несимметричность: "
+                                  "a[%d][%d] = %.6f != a[%d][%d] = %.6f\n",
+                                  thread_id, i, j, row[j], j, i, MAT(matrix, j, i));
                     }
                     // Можно досрочно выйти, но в OpenMP нет прямого break для параллельных циклов
                 }
@@ -120,15 +77,16 @@ int check_symmetric_omp(double** matrix, int n, int num_threads) {
 }
 
 // Альтернативная версия с использованием reduction и shared переменной
-int check_symmetric_omp_reduction(double** matrix, int n, int num_threads) {
+int check_symmetric_omp_reduction(const Matrix *matrix, int n, int num_threads) {
     int is_symmetric = 1;
     omp_set_num_threads(num_threads);
     
     // Используем reduction для безопасного обновления флага
     #pragma omp parallel for reduction(&&:is_symmetric)
     for (int i = 0; i < n; i++) {
+        const double *row = matrix_row(matrix, i);
         for (int j = i + 1; j < n; j++) {
-            if (fabs(matrix[i][j] - matrix[j][i]) > 1e-9) {
+            if (fabs(row[j] - MAT(matrix, j, i)) > 1e-9) {
                 is_symmetric = 0;
             }
         }
@@ -138,7 +96,7 @@ int check_symmetric_omp_reduction(double** matrix, int n, int num_threads) {
 }
 
 int main(int argc, char* argv[]) {
-    double** matrix = NULL;
+    Matrix matrix;
     int n, p;
     double start_time, end_time;
     
@@ -157,16 +115,19 @@ int main(int argc, char* argv[]) {
         printf("\nИспользуем тестовую матрицу 4x4\n");
         n = 4;
         p = 4;  // 4 потока
-        matrix = generate_test_matrix(n, 1);  // Симметричная матрица
-        print_matrix(matrix, n);
+        if (!generate_test_matrix(&matrix, n, 1)) {  // Симметричная матрица
+            perror("Ошибка выделения памяти");
+            return 1;
+        }
+        print_matrix(&matrix, n);
     } else {
         // Читаем матрицу из файла
-        matrix = read_matrix_from_file(argv[1], &n, &p);
-        if (!matrix) {
+        if (!matrix_read(argv[1], &matrix, &p, MATRIX_DEFAULT)) {
             fprintf(stderr, "Не удалось прочитать матрицу из файла\n");
             return 1;
         }
-        print_matrix(matrix, n);
+        n = matrix.n;
+        print_matrix(&matrix, n);
     }
     
     printf("\n========================================\n");
@@ -178,7 +139,7 @@ int main(int argc, char* argv[]) {
     start_time = omp_get_wtime();
     
     // Вызываем функцию проверки
-    int result = check_symmetric_omp(matrix, n, p);
+    int result = check_symmetric_omp(&matrix, n, p);
     
     end_time = omp_get_wtime();
     
@@ -192,9 +153,7 @@ int main(int argc, char* argv[]) {
     printf("Время выполнения: %.6f секунд\n", end_time - start_time);
     
     // Освобождаем память
-    if (matrix) {
-        free_matrix(matrix, n);
-    }
+    matrix_free(&matrix);
     
     return result ? 0 : 1;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <math.h>
 #include <unistd.h>
 
+#include "../common/log.h"
+
 // Функция для проверки симметричности блока матрицы
 int check_symmetry_block(double* block, int n, int k, int p, int block_size, int remainder, int local_rows, int start_row) {
     // Проверяем симметричность для элементов в блоке процесса
@@ -32,7 +34,7 @@ int check_symmetry_block(double* block, int n, int k, int p, int block_size, int
                 if (local_j >= 0 && local_j < local_rows) {
                     double aji = block[local_j * n + i];
                     if (fabs(aij - aji) > 1e-10) {
-                        printf("Процесс %d: обнаружено несоответствие a[%d][%d]=%f != a[%d][%d]=%f\n", 
+                        log_debug("Процесс %d: обнаружено несоответствие a[%d][%d]=%f != a[%d][%d]=%f\n", 
                                k, i, j, aij, j, i, aji);
                         return 0;
                     }
@@ -48,7 +50,7 @@ int check_symmetry_block(double* block, int n, int k, int p, int block_size, int
                 MPI_Recv(&aji, 1, MPI_DOUBLE, target_proc, 2, MPI_COMM_WORLD, &status);
                 
                 if (fabs(aij - aji) > 1e-10) {
-                    printf("Процесс %d: обнаружено несоответствие a[%d][%d]=%f != a[%d][%d]=%f (из процесса %d)\n", 
+                    log_debug("Процесс %d: обнаружено несоответствие a[%d][%d]=%f != a[%d][%d]=%f (из процесса %d)\n", 
                            k, i, j, aij, j, i, aji, target_proc);
                     return 0;
                 }
@@ -91,7 +93,7 @@ void handle_requests(double* block, int n, int k, int local_rows, int start_row)
     }
     
     if (received > 0) {
-        printf("Процесс %d обработал %d запросов\n", k, received);
+        log_debug("Процесс %d обработал %d запросов\n", k, received);
     }
 }
 
@@ -99,13 +101,13 @@ void handle_requests(double* block, int n, int k, int local_rows, int start_row)
 double* read_matrix_from_file(const char* filename, int* n) {
     FILE* file = fopen(filename, "r");
     if (file == NULL) {
-        printf("Ошибка открытия файла %s\n", filename);
+        log_error("Ошибка открытия файла %s\n", filename);
         return NULL;
     }
     
     // Читаем размерность матрицы
     if (fscanf(file, "%d", n) != 1) {
-        printf("Ошибка чтения размерности матрицы\n");
+        log_error("Ошибка чтения размерности матрицы\n");
         fclose(file);
         return NULL;
     }
@@ -113,7 +115,7 @@ double* read_matrix_from_file(const char* filename, int* n) {
     // Выделяем память под матрицу
     double* matrix = (double*)malloc((*n) * (*n) * sizeof(double));
     if (matrix == NULL) {
-        printf("Ошибка выделения памяти\n");
+        log_error("Ошибка выделения памяти\n");
         fclose(file);
         return NULL;
     }
@@ -121,7 +123,7 @@ double* read_matrix_from_file(const char* filename, int* n) {
     // Читаем данные матрицы
     for (int i = 0; i < (*n) * (*n); i++) {
         if (fscanf(file, "%lf", &matrix[i]) != 1) {
-            printf("Ошибка чтения элемента матрицы %d\n", i);
+            log_error("Ошибка чтения элемента матрицы %d\n", i);
             free(matrix);
             fclose(file);
             return NULL;
@@ -159,13 +161,16 @@ int main(int argc, char* argv[]) {
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
         
-        printf("Размер матрицы: %d x %d\n", n, n);
-        printf("Матрица:\n");
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                printf("%.1f ", full_matrix[i * n + j]);
+        log_info("Размер матрицы: %d x %d\n", n, n);
+        // Матрица целиком — только на уровне отладки
+        if (log_enabled(LOG_DEBUG)) {
+            log_debug("Матрица:\n");
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    log_debug("%.1f ", full_matrix[i * n + j]);
+                }
+                log_debug("\n");
             }
-            printf("\n");
         }
     }
     
@@ -174,7 +179,7 @@ int main(int argc, char* argv[]) {
     
     if (n == 0) {
         if (rank == 0) {
-            printf("Ошибка: нулевой размер матрицы\n");
+            log_error("Ошибка: нулевой размер матрицы\n");
         }
         MPI_Finalize();
         return 1;
@@ -206,13 +211,13 @@ int main(int argc, char* argv[]) {
         local_rows = n - start_row;
     }
     
-    printf("Процесс %d: local_rows=%d, start_row=%d\n", rank, local_rows, start_row);
+    log_debug("Процесс %d: local_rows=%d, start_row=%d\n", rank, local_rows, start_row);
     
     // Выделяем память под локальный блок
     if (local_rows > 0) {
         local_block = (double*)malloc(local_rows * n * sizeof(double));
         if (local_block == NULL) {
-            printf("Процесс %d: ошибка выделения памяти\n", rank);
+            log_error("Процесс %d: ошибка выделения памяти\n", rank);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
@@ -240,7 +245,7 @@ int main(int argc, char* argv[]) {
             displs[i] = offset;
             offset += sendcounts[i];
             
-            printf("Процесс %d: rows=%d, offset=%d, count=%d\n", i, rows, displs[i], sendcounts[i]);
+            log_debug("Процесс %d: rows=%d, offset=%d, count=%d\n", i, rows, displs[i], sendcounts[i]);
         }
     }
     
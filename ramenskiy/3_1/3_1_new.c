@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <mpi.h>
 
+#include "../common/log.h"
+
 int check_symmetry(double *matrix, int n, int start, int end) {
     
     int is_sym = 1;
@@ -43,7 +45,7 @@ int main(int argc, char *argv[]) {
         
         FILE *file = fopen(filename, "r");
         if (!file) {
-            printf("Ошибка открытия файла %s\n", filename);
+            log_error("Ошибка открытия файла %s\n", filename);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
@@ -51,7 +53,7 @@ int main(int argc, char *argv[]) {
 
         matrix = (double *)malloc(n * n * sizeof(double));
         if (!matrix) {
-            printf("Ошибка выделения памяти для матрицы\n");
+            log_error("Ошибка выделения памяти для матрицы\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
@@ -71,7 +73,7 @@ int main(int argc, char *argv[]) {
         
         matrix = (double *)malloc(n * n * sizeof(double));
         if (!matrix) {
-            printf("Ошибка выделения памяти в процессе %d\n", rank);
+            log_error("Ошибка выделения памяти в процессе %d\n", rank);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
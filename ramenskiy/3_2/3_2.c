@@ -3,6 +3,8 @@
 #include <mpi.h>
 #include <math.h>
 
+#include "../common/log.h"
+
 // Функция для симметризации матрицы (упрощенная версия)
 void symmetrize_matrix(double* local_block, int n, int rank, int size, int local_rows, int start_row) {
     // Проходим по всем элементам в локальном блоке
@@ -100,18 +102,21 @@ int main(int argc, char* argv[]) {
     if (rank == 0) {
         full_matrix = read_matrix(argv[1], &n);
         if (!full_matrix) {
-            printf("Ошибка чтения файла\n");
+            log_error("Ошибка чтения файла\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
         
-        printf("Исходная матрица %dx%d:\n", n, n);
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                printf("%7.2f ", full_matrix[i*n + j]);
+        // Исходная матрица — только на уровне отладки
+        if (log_enabled(LOG_DEBUG)) {
+            log_debug("Исходная матрица %dx%d:\n", n, n);
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    log_debug("%7.2f ", full_matrix[i*n + j]);
+                }
+                log_debug("\n");
             }
-            printf("\n");
+            log_debug("\n");
         }
-        printf("\n");
     }
     
     // Рассылаем размер
@@ -127,7 +132,7 @@ int main(int argc, char* argv[]) {
         start_row = rank;
     }
     
-    printf("Процесс %d: строк=%d, начало=%d\n", rank, local_rows, start_row);
+    log_debug("Процесс %d: строк=%d, начало=%d\n", rank, local_rows, start_row);
     
     // Выделяем память
     if (local_rows > 0) {
@@ -194,7 +199,7 @@ int main(int argc, char* argv[]) {
         
         // Если есть строки, которые не были обработаны (при size < n)
         for (int i = size; i < n; i++) {
-            printf("Строка %d не была обработана (недостаточно процессов)\n", i);
+            log_warn("Строка %d не была обработана (недостаточно процессов)\n", i);
         }
         
     } else {
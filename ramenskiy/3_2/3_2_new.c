@@ -3,6 +3,8 @@
 #include <mpi.h>
 #include <string.h>
 
+#include "../common/log.h"
+
 void symmetrize(double *matrix, int n, int start, int end) {
     
     for (int i = start; i < end; i++) {
@@ -45,24 +47,24 @@ int main(int argc, char *argv[]) {
     if (rank == 0) {
         FILE *file = fopen(input_filename, "r");
         if (!file) {
-            fprintf(stderr, "Ошибка открытия файла %s\n", input_filename);
+            log_error("Ошибка открытия файла %s\n", input_filename);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
         if (fscanf(file, "%d", &n) != 1) {
-            fprintf(stderr, "Ошибка чтения размера матрицы\n");
+            log_error("Ошибка чтения размера матрицы\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
         matrix = (double *)malloc(n * n * sizeof(double));
         if (!matrix) {
-            fprintf(stderr, "Ошибка выделения памяти для матрицы\n");
+            log_error("Ошибка выделения памяти для матрицы\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
         for (int i = 0; i < n * n; i++) {
             if (fscanf(file, "%lf", &matrix[i]) != 1) {
-                fprintf(stderr, "Ошибка чтения элемента матрицы\n");
+                log_error("Ошибка чтения элемента матрицы\n");
                 MPI_Abort(MPI_COMM_WORLD, 1);
             }
         }
@@ -75,7 +77,7 @@ int main(int argc, char *argv[]) {
     /*Локальная копия матрицы для каждого процесса*/
     local_matrix = (double *)malloc(n * n * sizeof(double));
     if (!local_matrix) {
-        fprintf(stderr, "Ошибка выделения памяти в процессе %d\n", rank);
+        log_error("Ошибка выделения памяти в процессе %d\n", rank);
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
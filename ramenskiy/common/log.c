@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include "log.h"
+
+#define LOG_BUF (1 << 16)
+
+int log_level = LOG_INFO;
+
+/* Буфер одного потока. Все буферы в общем списке, чтобы при выходе
+   из программы сбросить и те, чьи потоки ещё живы (пул OpenMP) */
+typedef struct LogSink {
+    pthread_mutex_t lock;
+    char *buf;
+    size_t len;
+    struct LogSink *prev, *next;
+} LogSink;
+
+static pthread_mutex_t sinks_lock = PTHREAD_MUTEX_INITIALIZER;
+static LogSink *sinks = NULL;
+static pthread_key_t sink_key;
+static __thread LogSink *my_sink = NULL;
+
+/* Запись накопленного. whole == 0 — только целые строки, хвост остаётся,
+   чтобы строки разных потоков не перемешивались */
+static void sink_flush(LogSink *s, int whole) {
+    size_t n = s->len;
+    if (!whole) {
+        while (n > 0 && s->buf[n - 1] != '\n') n--;
+    }
+    if (n == 0) return;
+    fwrite(s->buf, 1, n, stderr);
+    memmove(s->buf, s->buf + n, s->len - n);
+    s->len -= n;
+}
+
+static void sink_destroy(void *p) {
+    LogSink *s = (LogSink *)p;
+    pthread_mutex_lock(&sinks_lock);
+    if (s->prev) s->prev->next = s->next;
+    else sinks = s->next;
+    if (s->next) s->next->prev = s->prev;
+    pthread_mutex_unlock(&sinks_lock);
+
+    pthread_mutex_lock(&s->lock);
+    sink_flush(s, 1);
+    pthread_mutex_unlock(&s->lock);
+    pthread_mutex_destroy(&s->lock);
+    free(s->buf);
+    free(s);
+}
+
+static void log_flush_all(void) {
+    pthread_mutex_lock(&sinks_lock);
+    for (LogSink *s = sinks; s; s = s->next) {
+        pthread_mutex_lock(&s->lock);
+        sink_flush(s, 1);
+        pthread_mutex_unlock(&s->lock);
+    }
+    pthread_mutex_unlock(&sinks_lock);
+}
+
+__attribute__((constructor))
+static void log_init(void) {
+    static const char *names[] = {"error", "warn", "info", "debug"};
+    const char *env = getenv("LOG_LEVEL");
+    if (env) {
+        for (int i = 0; i < 4; i++) {
+            if (strcmp(env, names[i]) == 0) log_level = i;
+        }
+    }
+    pthread_key_create(&sink_key, sink_destroy);
+    atexit(log_flush_all);
+}
+
+/* Буфер текущего потока, создаётся при первой записи; NULL — нет памяти */
+static LogSink *sink_get(void) {
+    if (my_sink) return my_sink;
+    LogSink *s = (LogSink *)calloc(1, sizeof(LogSink));
+    if (!s) return NULL;
+    s->buf = (char *)malloc(LOG_BUF);
+    if (!s->buf) {
+        free(s);
+        return NULL;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+
+    pthread_mutex_lock(&sinks_lock);
+    s->next = sinks;
+    if (sinks) sinks->prev = s;
+    sinks = s;
+    pthread_mutex_unlock(&sinks_lock);
+
+    pthread_setspecific(sink_key, s);
+    my_sink = s;
+    return s;
+}
+
+/* ----------------------------------------- */
+void log_write(const char *fmt, ...) {
+    va_list ap;
+    LogSink *s = sink_get();
+    if (!s) {
+        va_start(ap, fmt);
+        vfprintf(stderr, fmt, ap);
+        va_end(ap);
+        return;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    va_start(ap, fmt);
+    int n = vsnprintf(s->buf + s->len, LOG_BUF - s->len, fmt, ap);
+    va_end(ap);
+    if (n > 0 && (size_t)n >= LOG_BUF - s->len) {
+        // Не поместилось: сначала целые строки, при нехватке — всё
+        sink_flush(s, 0);
+        if ((size_t)n >= LOG_BUF - s->len) sink_flush(s, 1);
+        va_start(ap, fmt);
+        if ((size_t)n < LOG_BUF) {
+            vsnprintf(s->buf + s->len, LOG_BUF - s->len, fmt, ap);
+            s->len += (size_t)n;
+        } else {
+            // Сообщение длиннее буфера идёт напрямую
+            vfprintf(stderr, fmt, ap);
+        }
+        va_end(ap);
+    } else if (n > 0) {
+        s->len += (size_t)n;
+    }
+    if (s->len >= LOG_BUF / 2) sink_flush(s, 0);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void log_write_now(const char *fmt, ...) {
+    LogSink *s = my_sink;
+    va_list ap;
+    va_start(ap, fmt);
+    if (s) {
+        // Под замком буфера: из другого потока его сбрасывает только
+        // log_flush_all при выходе
+        pthread_mutex_lock(&s->lock);
+        sink_flush(s, 1);
+        vfprintf(stderr, fmt, ap);
+        pthread_mutex_unlock(&s->lock);
+    } else {
+        vfprintf(stderr, fmt, ap);
+    }
+    va_end(ap);
+}
+
+void log_flush(void) {
+    LogSink *s = my_sink;
+    if (!s) return;
+    pthread_mutex_lock(&s->lock);
+    sink_flush(s, 1);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void log_set_level(int level) {
+    log_level = level;
+}
@@ -0,0 +1,56 @@
+#ifndef LOG_H
+#define LOG_H
+
+/* Общий журнал диагностики для всех программ.
+   Сообщения пишутся в буфер своего потока и уходят в stderr крупными
+   блоками целыми строками — потоки не ждут друг друга и не ставят
+   критических секций ради отладочной печати */
+
+/* Уровни сообщений */
+#define LOG_ERROR 0
+#define LOG_WARN  1
+#define LOG_INFO  2
+#define LOG_DEBUG 3
+
+/* Самый подробный уровень, который остаётся в программе. В сборке
+   с -DNDEBUG это LOG_INFO: вызовы log_debug исчезают при компиляции
+   вместе с вычислением аргументов. Можно задать явно:
+   -DLOG_COMPILE_LEVEL=LOG_WARN */
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL LOG_INFO
+#else
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+#endif
+
+/* Уровень во время работы: LOG_INFO или из переменной окружения
+   LOG_LEVEL=error|warn|info|debug при запуске */
+extern int log_level;
+
+#define log_enabled(level) ((level) <= LOG_COMPILE_LEVEL && (level) <= log_level)
+
+/* Запись как printf, перевод строки — в формате */
+void log_write(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+/* То же сразу в stderr: сначала сбрасывается буфер потока, чтобы
+   сообщение не обогнало записанное до него. Ошибки и предупреждения
+   идут так — в долгоживущем процессе (сервер, пакетный режим) они
+   не должны ждать заполнения буфера */
+void log_write_now(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+/* Сброс буфера текущего потока */
+void log_flush(void);
+void log_set_level(int level);
+
+#define LOG_AT(level, ...) \
+    do { \
+        if (!log_enabled(level)) break; \
+        if ((level) <= LOG_WARN) log_write_now(__VA_ARGS__); \
+        else log_write(__VA_ARGS__); \
+    } while (0)
+
+#define log_error(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+#define log_warn(...)  LOG_AT(LOG_WARN, __VA_ARGS__)
+#define log_info(...)  LOG_AT(LOG_INFO, __VA_ARGS__)
+#define log_debug(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include "matrix.h"
+
+#define LINE_DOUBLES (MATRIX_ALIGN / sizeof(double))
+
+static size_t round_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+/* Шаг строки: до целых строк кэша и не кратный 4 КБ */
+static size_t padded_ld(int n) {
+    size_t ld = round_up((size_t)n, LINE_DOUBLES);
+    if (ld * sizeof(double) % 4096 == 0) ld += LINE_DOUBLES;
+    return ld;
+}
+
+/* Блок на больших страницах. Заранее выделенных обычно нет: тогда
+   отображение берётся с запасом, обрезается до границы большой страницы
+   и помечается для прозрачных больших страниц */
+static void *map_huge(size_t bytes) {
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) return p;
+
+    size_t len = bytes + MATRIX_HUGE_PAGE;
+    char *raw = (char *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    char *start = (char *)round_up((uintptr_t)raw, MATRIX_HUGE_PAGE);
+    if (start > raw) munmap(raw, (size_t)(start - raw));
+    size_t tail = (size_t)(raw + len - (start + bytes));
+    if (tail) munmap(start + bytes, tail);
+#ifdef MADV_HUGEPAGE
+    madvise(start, bytes, MADV_HUGEPAGE);   // без поддержки ядра — просто обычные страницы
+#endif
+    return start;
+}
+
+static int alloc_ld(Matrix *m, int n, size_t ld, int flags) {
+    memset(m, 0, sizeof(*m));
+    if (n <= 0) return 0;
+    size_t bytes = round_up((size_t)n * ld * sizeof(double), MATRIX_ALIGN);
+    void *p = NULL;
+    if ((flags & MATRIX_HUGE) && bytes >= MATRIX_HUGE_MIN) {
+        bytes = round_up(bytes, MATRIX_HUGE_PAGE);
+        p = map_huge(bytes);
+        m->mapped = p != NULL;
+    }
+    if (!p && posix_memalign(&p, MATRIX_ALIGN, bytes) != 0) return 0;
+    m->data = (double *)p;
+    m->n = n;
+    m->ld = ld;
+    m->bytes = bytes;
+    return 1;
+}
+
+int matrix_alloc(Matrix *m, int n, int flags) {
+    return alloc_ld(m, n, (flags & MATRIX_PADDED) ? padded_ld(n) : (size_t)n, flags);
+}
+
+void matrix_free(Matrix *m) {
+    if (m->mapped) munmap(m->data, m->bytes);
+    else free(m->data);
+    memset(m, 0, sizeof(*m));
+}
+
+int matrix_copy(Matrix *dst, const Matrix *src) {
+    if (!alloc_ld(dst, src->n, src->ld, src->mapped ? MATRIX_HUGE : 0)) return 0;
+    memcpy(dst->data, src->data, (size_t)src->n * src->ld * sizeof(double));
+    return 1;
+}
+
+/* ----------------------------------------- */
+int matrix_read(const char *filename, Matrix *m, int *p, int flags) {
+    memset(m, 0, sizeof(*m));
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        perror("Ошибка открытия файла");
+        return 0;
+    }
+
+    // Размерность и количество потоков
+    int n;
+    if (fscanf(file, "%d %d", &n, p) != 2) {
+        fprintf(stderr, "Ошибка чтения размерности матрицы и количества потоков\n");
+        fclose(file);
+        return 0;
+    }
+    if (n <= 0 || !matrix_alloc(m, n, flags)) {
+        fprintf(stderr, "Неверная размерность матрицы или недостаточно памяти: %d\n", n);
+        fclose(file);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        double *row = matrix_row(m, i);
+        for (int j = 0; j < n; j++) {
+            if (fscanf(file, "%lf", &row[j]) != 1) {
+                fprintf(stderr, "Ошибка чтения элемента [%d][%d]\n", i, j);
+                matrix_free(m);
+                fclose(file);
+                return 0;
+            }
+        }
+    }
+
+    fclose(file);
+    return 1;
+}
@@ -0,0 +1,54 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stddef.h>
+
+/* Квадратная матрица вещественных чисел одним блоком по строкам.
+   Начало блока выровнено на 64 байта (строка кэша), строка i начинается
+   с data + i * ld. Обход столбца (a[j][i] при проверке симметричности)
+   идёт с постоянным шагом ld по одному блоку, а не по отдельным
+   выделениям на каждую строку */
+
+#define MATRIX_ALIGN 64
+
+/* Шаг строки дополняется до целых строк кэша; если он кратен 4 КБ,
+   добавляется ещё одна строка кэша — иначе элементы одного столбца
+   попадают в одни и те же наборы кэша и вытесняют друг друга */
+#define MATRIX_PADDED 1
+/* Большая матрица (от MATRIX_HUGE_MIN байт) размещается на больших
+   страницах: заранее выделенных (MAP_HUGETLB), если их нет — на обычных
+   с подсказкой ядру (прозрачные большие страницы) */
+#define MATRIX_HUGE   2
+#define MATRIX_DEFAULT (MATRIX_PADDED | MATRIX_HUGE)
+
+#define MATRIX_HUGE_PAGE (2u << 20)
+#define MATRIX_HUGE_MIN  (4u << 20)
+
+typedef struct {
+    double *data;
+    int n;
+    size_t ld;        // шаг строки в элементах, ld >= n
+    size_t bytes;     // размер выделенного блока
+    int mapped;       // блок получен mmap (большие страницы)
+} Matrix;
+
+/* Элемент [i][j] */
+#define MAT(m, i, j) ((m)->data[(size_t)(i) * (m)->ld + (size_t)(j)])
+
+static inline double *matrix_row(const Matrix *m, int i) {
+    return m->data + (size_t)i * m->ld;
+}
+
+/* Выделение матрицы n x n (элементы не заполнены), flags — MATRIX_*.
+   Возвращает 1 при успехе */
+int matrix_alloc(Matrix *m, int n, int flags);
+void matrix_free(Matrix *m);
+
+/* Копия с той же раскладкой. Возвращает 1 при успехе */
+int matrix_copy(Matrix *dst, const Matrix *src);
+
+/* Чтение файла "размерность количество_потоков элементы_по_строкам".
+   Ошибки печатаются в stderr. Возвращает 1 при успехе */
+int matrix_read(const char *filename, Matrix *m, int *p, int flags);
+
+#endif
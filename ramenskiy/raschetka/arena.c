@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+/* Добавочный блок — не меньше этого */
+#define ARENA_EXTRA_MIN (1 << 20)
+
+static size_t round_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/* Блок берётся calloc: большой блок приходит прямо от системы
+   нулевыми страницами, и обнулять его при первой выдаче не нужно */
+static ArenaBlock *block_new(size_t size) {
+    ArenaBlock *b = (ArenaBlock *)calloc(1, sizeof(ArenaBlock) + ARENA_ALIGN + size);
+    if (!b) return NULL;
+    uintptr_t data = ((uintptr_t)(b + 1) + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    b->next = NULL;
+    b->data = (char *)data;
+    b->size = size;
+    b->used = 0;
+    b->dirty = 0;
+    return b;
+}
+
+int arena_init(Arena *a, size_t size) {
+    memset(a, 0, sizeof(*a));
+    pthread_mutex_init(&a->lock, NULL);
+    if (size == 0) return 1;
+    a->blocks = block_new(round_up(size));
+    return a->blocks != NULL;
+}
+
+void arena_free(Arena *a) {
+    while (a->blocks) {
+        ArenaBlock *next = a->blocks->next;
+        free(a->blocks);
+        a->blocks = next;
+    }
+    pthread_mutex_destroy(&a->lock);
+    memset(a, 0, sizeof(*a));
+}
+
+int arena_reset(Arena *a, size_t size) {
+    // Добавочные блоки стоят в начале списка
+    while (a->blocks && a->blocks->next) {
+        ArenaBlock *next = a->blocks->next;
+        free(a->blocks);
+        a->blocks = next;
+    }
+    size_t want = round_up(size > a->peak ? size : a->peak);
+    if (a->blocks && a->blocks->size < want) {
+        free(a->blocks);
+        a->blocks = NULL;
+    }
+    if (!a->blocks && want > 0) a->blocks = block_new(want);
+    if (a->blocks) a->blocks->used = 0;
+    a->used = 0;
+    a->last = NULL;
+    return want == 0 || a->blocks != NULL;
+}
+
+/* Выдача под замком. *reused — длина начала выдачи, которое уже
+   выдавалось до сброса; дальше блок нулевой */
+static void *alloc_locked(Arena *a, size_t n, size_t *reused) {
+    n = round_up(n ? n : 1);
+    ArenaBlock *b = a->blocks;
+    if (!b || b->size - b->used < n) {
+        size_t size = b ? b->size / 2 : 0;
+        if (size < ARENA_EXTRA_MIN) size = ARENA_EXTRA_MIN;
+        if (size < n) size = n;
+        ArenaBlock *extra = block_new(size);
+        if (!extra) return NULL;
+        extra->next = b;
+        a->blocks = b = extra;
+    }
+    void *p = b->data + b->used;
+    *reused = b->dirty > b->used ? b->dirty - b->used : 0;
+    b->used += n;
+    if (b->used > b->dirty) b->dirty = b->used;
+    a->used += n;
+    if (a->used > a->peak) a->peak = a->used;
+    a->last = p;
+    return p;
+}
+
+void *arena_alloc(Arena *a, size_t n) {
+    size_t reused;
+    pthread_mutex_lock(&a->lock);
+    void *p = alloc_locked(a, n, &reused);
+    pthread_mutex_unlock(&a->lock);
+    return p;
+}
+
+void *arena_calloc(Arena *a, size_t n, size_t size) {
+    if (size && n > SIZE_MAX / size) return NULL;
+    size_t bytes = n * size, reused;
+    pthread_mutex_lock(&a->lock);
+    void *p = alloc_locked(a, bytes, &reused);
+    pthread_mutex_unlock(&a->lock);
+    // Нулевой хвост выдачи не трогается: его страницы остаются незанятыми
+    if (p) memset(p, 0, reused < bytes ? reused : bytes);
+    return p;
+}
+
+void *arena_grow(Arena *a, void *p, size_t old_n, size_t new_n) {
+    pthread_mutex_lock(&a->lock);
+    ArenaBlock *b = a->blocks;
+    if (p && p == a->last && b) {
+        size_t off = (size_t)((char *)p - b->data);
+        size_t old_r = b->used - off;
+        size_t new_r = round_up(new_n ? new_n : 1);
+        if (new_r <= old_r || new_r - old_r <= b->size - b->used) {
+            if (new_r > old_r) {
+                b->used += new_r - old_r;
+                if (b->used > b->dirty) b->dirty = b->used;
+                a->used += new_r - old_r;
+                if (a->used > a->peak) a->peak = a->used;
+            }
+            pthread_mutex_unlock(&a->lock);
+            return p;
+        }
+    }
+    size_t reused;
+    void *q = alloc_locked(a, new_n, &reused);
+    pthread_mutex_unlock(&a->lock);
+    if (q && p) memcpy(q, p, old_n < new_n ? old_n : new_n);
+    return q;
+}
+
+void *arena_or_malloc(Arena *a, size_t n) {
+    return a ? arena_alloc(a, n) : malloc(n ? n : 1);
+}
+
+void *arena_or_calloc(Arena *a, size_t n, size_t size) {
+    return a ? arena_calloc(a, n, size) : calloc(n ? n : 1, size);
+}
+
+void arena_or_free(Arena *a, void *p) {
+    if (!a) free(p);
+}
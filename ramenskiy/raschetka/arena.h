@@ -0,0 +1,63 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+/* Арена одного восстановления: буферы видов, индексов и результатов
+   выдаются подряд из одного большого блока и освобождаются разом
+   (arena_reset перед следующим чертежом или arena_free).
+   Блок заказывается по оценке из размера файла; страницы, до которых
+   дело не дошло, память не занимают. Если оценки не хватило, берутся
+   добавочные блоки, а при следующем сбросе основной блок вырастает до
+   наибольшего расхода — в пакете чертежей память перестаёт
+   перераспределяться после первых запусков.
+   Выдача безопасна из нескольких потоков, адреса выровнены на 64 байта */
+
+#define ARENA_ALIGN 64
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    char *data;
+    size_t size, used;
+    size_t dirty;          // выше этой границы в блок ещё не писали — там нули
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks;    // текущий блок первым, основной — последним
+    size_t used;           // выдано с последнего сброса
+    size_t peak;           // наибольшее used за всё время
+    void *last;            // последняя выдача — её можно нарастить на месте
+    pthread_mutex_t lock;
+} Arena;
+
+/* size — оценка расхода, байт (0 — блок заводится при первой выдаче).
+   Возвращает 1 при успехе */
+int arena_init(Arena *a, size_t size);
+void arena_free(Arena *a);
+
+/* Всё выданное возвращается арене. Основной блок растёт до
+   max(size, наибольший расход), добавочные освобождаются.
+   Возвращает 0, если блок нужного размера не выделился (арена
+   при этом пуста, но пригодна) */
+int arena_reset(Arena *a, size_t size);
+
+/* NULL — нет памяти */
+void *arena_alloc(Arena *a, size_t n);
+/* Обнулённая память. Явно обнуляется только уже бывшая в деле часть
+   блока: редко заполняемые хеш-таблицы, как и с calloc, не занимают
+   страниц, до которых не дошла запись */
+void *arena_calloc(Arena *a, size_t n, size_t size);
+/* Увеличение буфера p с old_n до new_n байт: последняя выдача растёт
+   на месте, иначе — новая выдача с копированием (старая остаётся
+   в арене до сброса). Для однопоточного заполнения массивов */
+void *arena_grow(Arena *a, void *p, size_t old_n, size_t new_n);
+
+/* Выделение из арены или, при a == NULL, обычным malloc/calloc —
+   для функций, которые работают в обоих режимах */
+void *arena_or_malloc(Arena *a, size_t n);
+void *arena_or_calloc(Arena *a, size_t n, size_t size);
+/* Освобождение того, что выдала arena_or_*: при a != NULL ничего */
+void arena_or_free(Arena *a, void *p);
+
+#endif
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include "batch.h"
+#include "filelist.h"
+#include "pool.h"
+#include "recon.h"
+#include "timing.h"
+#include "writer.h"
+#include "../common/log.h"
+
+/* Текстовый буфер потока, растёт вдвое и не освобождается между чертежами */
+typedef struct {
+    char *p;
+    size_t len, cap;
+    int ok;
+} TextBuf;
+
+static void text_reserve(TextBuf *b, size_t extra) {
+    if (!b->ok || b->len + extra <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 1 << 16;
+    while (cap < b->len + extra) cap *= 2;
+    char *resized = (char *)realloc(b->p, cap);
+    if (!resized) {
+        b->ok = 0;
+        return;
+    }
+    b->p = resized;
+    b->cap = cap;
+}
+
+static void text_printf(TextBuf *b, const char *fmt, ...) {
+    text_reserve(b, 128);
+    if (!b->ok) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(b->p + b->len, b->cap - b->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        b->ok = 0;
+        return;
+    }
+    if ((size_t)n >= b->cap - b->len) {
+        text_reserve(b, (size_t)n + 1);
+        if (!b->ok) return;
+        va_start(ap, fmt);
+        vsnprintf(b->p + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+    }
+    b->len += (size_t)n;
+}
+
+/* ----------------------------------------- */
+/* Итог одного чертежа до вывода по порядку */
+typedef struct {
+    int done;
+    int ok;
+    StageTimes times;
+    RunStats stats;
+    char *text;            // результаты, если чертёж ждёт очереди на вывод
+    size_t len;
+} BatchSlot;
+
+typedef struct {
+    const BatchOptions *opt;
+    FileList files;
+    WorkerPool *inner;     // пул внутри этапов или NULL
+    int threads_per_drawing;
+    Reconstruction *recs;  // по одному на поток
+    TextBuf *bufs;
+    size_t next;           // следующий невыданный чертёж
+    BatchSlot *slots;
+    size_t next_flush;     // следующий чертёж для вывода
+    pthread_mutex_t lock;
+    FILE *out, *json, *csv;
+    size_t failed;
+    size_t points, edges, input;
+    double stage_sum[STAGE_COUNT];
+} BatchJob;
+
+static const char *base_name(const char *path) {
+    const char *s = strrchr(path, '/');
+    return s ? s + 1 : path;
+}
+
+/* Вывод итогов чертежа i: результаты, строка отчёта, JSON/CSV.
+   Вызывается под мьютексом строго по порядку */
+static void emit(BatchJob *job, size_t i, const char *text, size_t len) {
+    BatchSlot *s = &job->slots[i];
+    if (job->out && len) fwrite(text, 1, len, job->out);
+
+    if (s->ok) {
+        printf("%-40s %8zu %8zu %8zu %10.4f\n", base_name(job->files.names[i]),
+               s->stats.nxy + s->stats.nxz + s->stats.nyz, s->stats.points,
+               s->stats.edges, s->times.total);
+        job->points += s->stats.points;
+        job->edges += s->stats.edges;
+        job->input += s->stats.nxy + s->stats.nxz + s->stats.nyz;
+        for (int k = 0; k < STAGE_COUNT; k++) job->stage_sum[k] += s->times.sec[k];
+        if (job->json) timing_write_json(job->json, &s->times, &s->stats);
+        if (job->csv) timing_write_csv(job->csv, &s->times, &s->stats);
+    } else {
+        printf("%-40s ошибка восстановления\n", base_name(job->files.names[i]));
+        job->failed++;
+    }
+}
+
+static void commit(BatchJob *job, size_t i, int ok, const Reconstruction *r, TextBuf *tb) {
+    pthread_mutex_lock(&job->lock);
+    BatchSlot *s = &job->slots[i];
+    s->ok = ok;
+    s->times = r->times;
+    s->stats = (RunStats){job->files.names[i], job->threads_per_drawing,
+                          r->nxy, r->nxz, r->nyz, r->found, r->verts.n, r->nedges};
+
+    if (i == job->next_flush) {
+        // Своя очередь — буфер потока выводится без копирования
+        emit(job, i, tb->p, tb->len);
+        job->next_flush++;
+        while (job->next_flush < job->files.n && job->slots[job->next_flush].done) {
+            BatchSlot *w = &job->slots[job->next_flush];
+            emit(job, job->next_flush, w->text, w->len);
+            free(w->text);
+            w->text = NULL;
+            job->next_flush++;
+        }
+    } else {
+        s->text = tb->len ? (char *)malloc(tb->len) : NULL;
+        if (s->text) memcpy(s->text, tb->p, tb->len);
+        s->len = s->text ? tb->len : 0;
+        s->done = 1;
+    }
+    pthread_mutex_unlock(&job->lock);
+}
+
+static void format_result(TextBuf *tb, const char *file, int ok, const Reconstruction *r) {
+    tb->len = 0;
+    tb->ok = 1;
+    text_printf(tb, "drawing %s\n", file);
+    if (!ok) {
+        text_printf(tb, "error\n");
+        return;
+    }
+    text_printf(tb, "points %zu\n", r->verts.n);
+    // Координаты — через format_fixed: тот же текст, что у "%.6f", без printf
+    for (size_t i = 0; i < r->verts.n; i++) {
+        const PointXYZ *p = &r->verts.pts[i];
+        text_reserve(tb, 3 * FIXED_MAX + 3);
+        if (!tb->ok) break;
+        char *dst = tb->p + tb->len;
+        size_t n = format_fixed(dst, p->x, 6, '.');
+        dst[n++] = ' ';
+        n += format_fixed(dst + n, p->y, 6, '.');
+        dst[n++] = ' ';
+        n += format_fixed(dst + n, p->z, 6, '.');
+        dst[n++] = '\n';
+        tb->len += n;
+    }
+    text_printf(tb, "edges %zu\n", r->nedges);
+    for (size_t e = 0; e < r->nedges; e++)
+        text_printf(tb, "%zu %zu\n", r->edges[e].a + 1, r->edges[e].b + 1);
+    if (!tb->ok) tb->len = 0;
+}
+
+/* Поток берёт чертежи по одному, пока они есть */
+static void batch_worker(void *arg, size_t worker) {
+    BatchJob *job = (BatchJob *)arg;
+    Reconstruction *r = &job->recs[worker];
+    TextBuf *tb = &job->bufs[worker];
+
+    for (;;) {
+        size_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (i >= job->files.n) break;
+
+        const char *file = job->files.names[i];
+        int ok = recon_run(r, job->inner, file, job->opt->use_cache);
+        tb->len = 0;
+        if (job->out) format_result(tb, file, ok, r);
+        commit(job, i, ok, r, tb);
+    }
+}
+
+/* ----------------------------------------- */
+static FILE *open_report(const char *name, const char *mode) {
+    if (!name) return NULL;
+    FILE *f = fopen(name, mode);
+    if (!f) log_error("%s: %s\n", name, strerror(errno));
+    return f;
+}
+
+int batch_run(const BatchOptions *o) {
+    BatchJob job;
+    memset(&job, 0, sizeof(job));
+    job.opt = o;
+
+    if (!file_list_from_path(&job.files, o->source, "2D.txt")) {
+        file_list_free(&job.files);
+        return 1;
+    }
+    if (job.files.n == 0) {
+        log_error("Нет чертежей в %s\n", o->source);
+        file_list_free(&job.files);
+        return 1;
+    }
+
+    WorkerPool pool;
+    if (!pool_init(&pool, o->nthreads)) {
+        log_error("Ошибка создания пула потоков\n");
+        file_list_free(&job.files);
+        return 1;
+    }
+    int parallel = job.files.n >= (size_t)pool.nthreads && pool.nthreads > 1;
+    size_t nworkers = parallel ? (size_t)pool.nthreads : 1;
+    job.inner = parallel ? NULL : &pool;
+    job.threads_per_drawing = parallel ? 1 : pool.nthreads;
+
+    job.recs = (Reconstruction *)calloc(nworkers, sizeof(Reconstruction));
+    job.bufs = (TextBuf *)calloc(nworkers, sizeof(TextBuf));
+    job.slots = (BatchSlot *)calloc(job.files.n, sizeof(BatchSlot));
+    int ok = job.recs && job.bufs && job.slots;
+    for (size_t w = 0; w < nworkers && ok; w++) ok = recon_init(&job.recs[w]);
+    pthread_mutex_init(&job.lock, NULL);
+
+    job.out = open_report(o->out_file, "w");
+    job.json = open_report(o->json_file, "a");
+    job.csv = open_report(o->csv_file, "a");
+    if ((o->out_file && !job.out) || (o->json_file && !job.json) ||
+        (o->csv_file && !job.csv))
+        ok = 0;
+
+    double started = timing_now();
+    if (ok) {
+        printf("Чертежей: %zu, потоков: %d, %s\n\n", job.files.n, pool.nthreads,
+               parallel ? "чертежи распределяются между потоками"
+                        : "чертежи по очереди, потоки внутри этапов");
+        printf("%-40s %8s %8s %8s %10s\n", "чертёж", "точек", "вершин", "рёбер", "время, с");
+        if (parallel) pool_run(&pool, batch_worker, &job, nworkers);
+        else batch_worker(&job, 0);
+    } else {
+        log_error("Ошибка подготовки пакетного режима\n");
+    }
+    double wall = timing_now() - started;
+
+    if (ok) {
+        printf("\n========================================================\n");
+        printf("ИТОГО: чертежей %zu, с ошибками %zu\n", job.files.n, job.failed);
+        printf("  Вершин: %zu, рёбер: %zu\n", job.points, job.edges);
+        printf("  Время: %.3f с, %.1f чертежей/с, %.0f точек чертежей/с\n", wall,
+               wall > 0.0 ? (double)job.files.n / wall : 0.0,
+               wall > 0.0 ? (double)job.input / wall : 0.0);
+        printf("  Сумма по этапам (с): read %.3f, sort %.3f, join %.3f, dedup %.3f, wires %.3f\n",
+               job.stage_sum[STAGE_READ], job.stage_sum[STAGE_SORT], job.stage_sum[STAGE_JOIN],
+               job.stage_sum[STAGE_DEDUP], job.stage_sum[STAGE_WIRES]);
+        printf("  Пиковая память: %ld КБ\n", timing_peak_rss_kb());
+        printf("========================================================\n");
+    }
+
+    if (job.out && fclose(job.out) != 0) ok = 0;
+    if (job.json) fclose(job.json);
+    if (job.csv) fclose(job.csv);
+    pthread_mutex_destroy(&job.lock);
+    for (size_t w = 0; w < nworkers; w++) {
+        if (job.recs) recon_free(&job.recs[w]);
+        if (job.bufs) free(job.bufs[w].p);
+    }
+    if (job.slots) {
+        for (size_t i = 0; i < job.files.n; i++) free(job.slots[i].text);
+    }
+    free(job.recs);
+    free(job.bufs);
+    free(job.slots);
+    pool_destroy(&pool);
+    file_list_free(&job.files);
+    return ok && job.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/* Пакетное восстановление многих чертежей в одном процессе */
+typedef struct {
+    const char *source;      // каталог (файлы *2D.txt) или файл-список
+    int nthreads;
+    int use_cache;
+    const char *out_file;    // вершины и рёбра всех чертежей; NULL — не писать
+    const char *json_file;   // время этапов по чертежам (timing.h); NULL — нет
+    const char *csv_file;
+} BatchOptions;
+
+/* Чертежей не меньше, чем потоков, — каждый чертёж целиком достаётся
+   одному потоку общего пула, у потока свои переиспользуемые буферы.
+   Иначе чертежи идут по очереди, и пул работает внутри этапов.
+   Результаты и отчёт пишутся в порядке списка.
+   Возвращает 0, если все чертежи восстановлены, иначе 1 */
+int batch_run(const BatchOptions *o);
+
+#endif
@@ -0,0 +1,982 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "filelist.h"
+#include "geom.h"
+#include "parse.h"
+#include "pointset.h"
+#include "pool.h"
+#include "recon.h"
+#include "timing.h"
+#include "wires.h"
+#include "writer.h"
+#include "../common/log.h"
+
+/* Регрессионная проверка и замер скорости восстановления.
+   Для каждого чертежа "X 2D.txt" восстановление запускается целиком
+   (чтение, сортировка, соединение, отбор, рёбра), вершины и рёбра
+   сравниваются с эталоном "X golden.obj". Эталон пишет bench -g
+   полным перебором, без сортировок, индексов и кода find_wires: вершины —
+   как в исходном try.c, рёбра — перебором пар вершин по правилу из
+   wires.h. Любая недостающая или лишняя вершина или ребро — ошибка,
+   программа завершается с кодом 1.
+   "X 3D.txt" в ../data — результат исходной программы. При записи
+   эталона проверяется, совпадают ли с ним вершины перебора как есть
+   или с отражённой осью y вида сбоку; найденный вариант записывается
+   в эталон, и вершины строго сверяются с "X 3D.txt" в нём. Если не
+   совпадает ни один (zvezdka, dodekaedr), сравнение только печатается,
+   вместе с числом "3d N" (у исходной программы это число вершин, рёбер
+   в этих файлах нет). Без golden вершины строго сверяются с "X 3D.txt"
+   как есть — так проверяются чертежи от gen */
+
+#define MAX_EXAMPLES 3
+
+/* Итог сравнения с "X 3D.txt" */
+typedef struct {
+    size_t ntruth;         // различных вершин эталона
+    size_t missing;        // вершины эталона, которых нет в результате
+    size_t extra;          // вершины результата, которых нет в эталоне
+    int sign[3];           // направления осей результата относительно эталона
+    double shift[3];
+    PointXYZ missing_ex[MAX_EXAMPLES];
+    PointXYZ extra_ex[MAX_EXAMPLES];
+} Compare;
+
+/* Эталон "X golden.obj" */
+typedef struct {
+    PointXYZ *pts;
+    size_t npts, cap;
+    Edge3D *edges;
+    size_t nedges, edges_cap;
+    double eps;            // точность, с которой он записан
+    int align;             // совпадение с "X 3D.txt", TRUTH_*
+} Golden;
+
+/* Итог сравнения с "X golden.obj" */
+typedef struct {
+    size_t vmissing, vextra;   // вершины
+    size_t emissing, eextra;   // рёбра
+    PointXYZ missing_ex[MAX_EXAMPLES];
+    PointXYZ extra_ex[MAX_EXAMPLES];
+} GoldenDiff;
+
+/* ----------------------------------------- */
+/* Повторы восстановления: результат последнего, время — лучшее */
+static int bench_file(WorkerPool *pool, const char *file, int repeats,
+                      Reconstruction *r, double *best_sec) {
+    *best_sec = 0.0;
+    for (int i = 0; i < repeats; i++) {
+        double start = timing_now();
+        if (!recon_run(r, pool, file, 0)) return 0;
+        double sec = timing_now() - start;
+        if (i == 0 || sec < *best_sec) *best_sec = sec;
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Сравнение с "X 3D.txt". Начало координат и направления осей эталона
+   могут отличаться от чертежа, поэтому для каждого из 8 вариантов знаков
+   осей результат сдвигается так, чтобы минимумы габаритов совпали,
+   и берётся вариант с наибольшим числом совпавших вершин */
+static void transform(const Compare *c, PointXYZ p, PointXYZ *q) {
+    q->x = c->sign[0] * p.x + c->shift[0];
+    q->y = c->sign[1] * p.y + c->shift[1];
+    q->z = c->sign[2] * p.z + c->shift[2];
+}
+
+static int compare_truth(const PointSet *truth, const PointSet *ours, Compare *c) {
+    memset(c, 0, sizeof(*c));
+    c->ntruth = truth->n;
+    if (truth->n == 0 || ours->n == 0) {
+        c->sign[0] = c->sign[1] = c->sign[2] = 1;
+        c->missing = truth->n;
+        c->extra = ours->n;
+        return 1;
+    }
+
+    double tmin[3] = {truth->pts[0].x, truth->pts[0].y, truth->pts[0].z};
+    for (size_t i = 1; i < truth->n; i++) {
+        if (truth->pts[i].x < tmin[0]) tmin[0] = truth->pts[i].x;
+        if (truth->pts[i].y < tmin[1]) tmin[1] = truth->pts[i].y;
+        if (truth->pts[i].z < tmin[2]) tmin[2] = truth->pts[i].z;
+    }
+
+    size_t best_hits = 0;
+    Compare cur = *c;
+    for (int mask = 0; mask < 8; mask++) {
+        for (int a = 0; a < 3; a++) cur.sign[a] = (mask >> a) & 1 ? -1 : 1;
+
+        double omin[3] = {cur.sign[0] * ours->pts[0].x, cur.sign[1] * ours->pts[0].y,
+                          cur.sign[2] * ours->pts[0].z};
+        for (size_t i = 1; i < ours->n; i++) {
+            double v[3] = {cur.sign[0] * ours->pts[i].x, cur.sign[1] * ours->pts[i].y,
+                           cur.sign[2] * ours->pts[i].z};
+            for (int a = 0; a < 3; a++)
+                if (v[a] < omin[a]) omin[a] = v[a];
+        }
+        for (int a = 0; a < 3; a++) cur.shift[a] = tmin[a] - omin[a];
+
+        size_t hits = 0;
+        for (size_t i = 0; i < ours->n; i++) {
+            PointXYZ q;
+            transform(&cur, ours->pts[i], &q);
+            hits += pointset_contains(truth, q);
+        }
+        if (mask == 0 || hits > best_hits) {
+            best_hits = hits;
+            memcpy(c->sign, cur.sign, sizeof(c->sign));
+            memcpy(c->shift, cur.shift, sizeof(c->shift));
+        }
+    }
+
+    // Лишние вершины — в координатах чертежа, недостающие — эталона
+    PointSet moved;
+    if (!pointset_init(&moved, ours->n)) return 0;
+    for (size_t i = 0; i < ours->n; i++) {
+        PointXYZ q;
+        transform(c, ours->pts[i], &q);
+        if (!pointset_contains(truth, q)) {
+            if (c->extra < MAX_EXAMPLES) c->extra_ex[c->extra] = ours->pts[i];
+            c->extra++;
+        }
+        if (pointset_insert(&moved, q) < 0) {
+            pointset_free(&moved);
+            return 0;
+        }
+    }
+    for (size_t i = 0; i < truth->n; i++) {
+        if (!pointset_contains(&moved, truth->pts[i])) {
+            if (c->missing < MAX_EXAMPLES) c->missing_ex[c->missing] = truth->pts[i];
+            c->missing++;
+        }
+    }
+    pointset_free(&moved);
+    return 1;
+}
+
+/* Эталон: различные точки секции "3D points" */
+static int load_truth(const char *file, PointSet *truth) {
+    PointXYZ *pts;
+    size_t n;
+    if (!parse_points3d(file, &pts, &n)) return 0;
+
+    int ok = pointset_init(truth, n);
+    for (size_t i = 0; i < n && ok; i++) {
+        ok = pointset_insert(truth, pts[i]) >= 0;
+    }
+    free(pts);
+    if (!ok) pointset_free(truth);
+    return ok;
+}
+
+/* Число из строки "3d N" эталона. У исходной программы это число вершин,
+   а не рёбер: секция "3D edges" в эталонах пустая, рёбер для сравнения
+   в них нет. 0 — строки нет */
+static size_t reference_count(const char *file) {
+    FILE *f = fopen(file, "r");
+    if (!f) return 0;
+    char line[256];
+    size_t n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "3d ", 3) == 0) {
+            n = (size_t)strtoull(line + 3, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+/* "X 2D.txt" -> "X<suffix>"; 0, если имя не оканчивается на "2D.txt" */
+static int sibling_name(const char *file, const char *suffix, char *out, size_t size) {
+    size_t len = strlen(file);
+    const char *own = "2D.txt";
+    size_t ol = strlen(own), sl = strlen(suffix);
+    if (len < ol || strcmp(file + len - ol, own) != 0 || len - ol + sl + 1 > size) return 0;
+    memcpy(out, file, len - ol);
+    memcpy(out + len - ol, suffix, sl + 1);
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Эталон "X golden.obj" */
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t edge_key(size_t a, size_t b) {
+    return a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+}
+
+
+/* Вершины полным перебором, как в исходном try.c: для каждой точки XY —
+   точки XZ с тем же x, для каждой — первая точка YZ с теми же y и z;
+   повтор отбрасывается сравнением со всеми найденными вершинами.
+   Без сортировки, индексов и хешей — независимая проверка быстрых путей */
+static int brute_vertices(const Projections *pr, PointXYZ **out, size_t *n) {
+    PointXYZ *pts = NULL;
+    size_t cnt = 0, cap = 0;
+    for (size_t i = 0; i < pr->nxy; i++) {
+        double x = pr->xy[i].x, y = pr->xy[i].y;
+        for (size_t j = 0; j < pr->nxz; j++) {
+            if (!approx_eq(pr->xz[j].x, x)) continue;
+            double z = pr->xz[j].z;
+            for (size_t k = 0; k < pr->nyz; k++) {
+                if (!approx_eq(pr->yz[k].y, y) || !approx_eq(pr->yz[k].z, z)) continue;
+                int exists = 0;
+                for (size_t t = 0; t < cnt && !exists; t++) {
+                    exists = approx_eq(pts[t].x, x) && approx_eq(pts[t].y, y) &&
+                             approx_eq(pts[t].z, z);
+                }
+                if (!exists) {
+                    if (cnt == cap) {
+                        size_t new_cap = cap ? cap * 2 : 1024;
+                        PointXYZ *resized = (PointXYZ *)realloc(pts, new_cap * sizeof(PointXYZ));
+                        if (!resized) {
+                            free(pts);
+                            return 0;
+                        }
+                        pts = resized;
+                        cap = new_cap;
+                    }
+                    pts[cnt++] = (PointXYZ){x, y, z};
+                }
+                break;
+            }
+        }
+    }
+    *out = pts;
+    *n = cnt;
+    return 1;
+}
+
+/* Рёбра полным перебором пар вершин, прямо по правилу из wires.h, без
+   индексов find_wires. Точки вида, совпадающие с точностью EPS,
+   сливаются: представитель — первая в порядке файла; отрезки — пары
+   точек подряд, проекция вершины — первый совпадающий с ней
+   представитель. В каждом виде проекции p и q совпадают или отрезки
+   чертежа, оба конца которых не дальше EPS от прямой p'q', своими
+   положениями вдоль p'q' без разрывов больше EPS закрывают весь
+   [0, |p'q'|]. Перебор пар отсекается по отрезкам, на которых лежат p'
+   и q': среди них должен быть отрезок той же прямой */
+typedef struct {
+    double u0, v0, u1, v1;
+} Seg2;
+
+typedef struct {
+    double *u, *v;         // представители точек вида
+    size_t nreps;
+    Seg2 *segs;
+    size_t nsegs;
+    long long *vrep;       // представитель проекции вершины или -1
+    size_t *begin;         // отрезки, на которых лежит проекция вершины, CSR
+    uint32_t *ids;
+} BruteView;
+
+static void brute_proj(int view, PointXYZ p, double *u, double *v) {
+    switch (view) {
+    case VIEW_FRONT:   *u = p.x; *v = p.z; break;
+    case VIEW_PROFILE: *u = p.y; *v = p.z; break;
+    default:           *u = p.x; *v = p.y; break;
+    }
+}
+
+static void brute_view_free(BruteView *bv) {
+    free(bv->u);
+    free(bv->v);
+    free(bv->segs);
+    free(bv->vrep);
+    free(bv->begin);
+    free(bv->ids);
+}
+
+/* Первый представитель, совпадающий с (u, v), или -1 */
+static long long brute_rep(const BruteView *bv, double u, double v) {
+    for (size_t r = 0; r < bv->nreps; r++) {
+        if (approx_eq(bv->u[r], u) && approx_eq(bv->v[r], v)) return (long long)r;
+    }
+    return -1;
+}
+
+/* Представители и отрезки вида; отрезок с одним представителем на обоих
+   концах пропускается */
+static int brute_segments(const Projections *pr, int view, BruteView *bv) {
+    size_t n = view == VIEW_FRONT ? pr->nxz : view == VIEW_PROFILE ? pr->nyz : pr->nxy;
+    bv->u = (double *)malloc((n + 1) * sizeof(double));
+    bv->v = (double *)malloc((n + 1) * sizeof(double));
+    bv->segs = (Seg2 *)malloc((n / 2 + 1) * sizeof(Seg2));
+    if (!bv->u || !bv->v || !bv->segs) return 0;
+    long long prev = -1;
+    for (size_t i = 0; i < n; i++) {
+        double u = view == VIEW_FRONT ? pr->xz[i].x : view == VIEW_PROFILE ? pr->yz[i].y : pr->xy[i].x;
+        double v = view == VIEW_FRONT ? pr->xz[i].z : view == VIEW_PROFILE ? pr->yz[i].z : pr->xy[i].y;
+        long long r = brute_rep(bv, u, v);
+        if (r < 0) {
+            r = (long long)bv->nreps;
+            bv->u[bv->nreps] = u;
+            bv->v[bv->nreps++] = v;
+        }
+        if (i % 2 == 1 && r != prev) {
+            bv->segs[bv->nsegs++] = (Seg2){bv->u[prev], bv->v[prev], bv->u[r], bv->v[r]};
+        }
+        prev = r;
+    }
+    return 1;
+}
+
+/* Точка лежит на отрезке с запасом 2*EPS — отсечение не должно терять пар */
+static int near_segment(const Seg2 *s, double u, double v) {
+    double du = s->u1 - s->u0, dv = s->v1 - s->v0;
+    double len = sqrt(du * du + dv * dv);
+    double t = ((u - s->u0) * du + (v - s->v0) * dv) / len;
+    if (t < -2.0 * EPS || t > len + 2.0 * EPS) return 0;
+    return fabs((u - s->u0) * dv - (v - s->v0) * du) <= 2.0 * EPS * len;
+}
+
+static int brute_incidence(BruteView *bv, int view, const PointXYZ *pts, size_t n) {
+    bv->vrep = (long long *)malloc((n + 1) * sizeof(long long));
+    bv->begin = (size_t *)calloc(n + 1, sizeof(size_t));
+    if (!bv->vrep || !bv->begin) return 0;
+    for (size_t i = 0; i < n; i++) {
+        double u, v;
+        brute_proj(view, pts[i], &u, &v);
+        bv->vrep[i] = brute_rep(bv, u, v);
+    }
+    size_t total = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        total = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (pass == 1) total = bv->begin[i];
+            for (size_t s = 0; s < bv->nsegs && bv->vrep[i] >= 0; s++) {
+                size_t r = (size_t)bv->vrep[i];
+                if (!near_segment(&bv->segs[s], bv->u[r], bv->v[r])) continue;
+                if (pass == 1) bv->ids[total] = (uint32_t)s;
+                total++;
+            }
+            if (pass == 0) bv->begin[i + 1] = total;
+        }
+        if (pass == 0) {
+            bv->ids = (uint32_t *)malloc((total + 1) * sizeof(uint32_t));
+            if (!bv->ids) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Оба конца отрезка не дальше EPS от прямой через p в направлении d длины len */
+static int on_line(const Seg2 *s, double pu, double pv, double du, double dv, double len) {
+    return fabs((s->u0 - pu) * dv - (s->v0 - pv) * du) <= EPS * len &&
+           fabs((s->u1 - pu) * dv - (s->v1 - pv) * du) <= EPS * len;
+}
+
+static int has_line_segment(const BruteView *bv, size_t i,
+                            double pu, double pv, double du, double dv, double len) {
+    for (size_t k = bv->begin[i]; k < bv->begin[i + 1]; k++) {
+        if (on_line(&bv->segs[bv->ids[k]], pu, pv, du, dv, len)) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    double t0, t1;
+} Span;
+
+static int cmp_span(const void *a, const void *b) {
+    double x = ((const Span *)a)->t0, y = ((const Span *)b)->t0;
+    return (x > y) - (x < y);
+}
+
+/* Проекция p-q в виде покрыта отрезками чертежа; spans — буфер на nsegs */
+static int brute_covered(const BruteView *bv, Span *spans,
+                         double pu, double pv, double qu, double qv) {
+    double du = qu - pu, dv = qv - pv;
+    double len = sqrt(du * du + dv * dv);
+    size_t n = 0;
+    for (size_t s = 0; s < bv->nsegs; s++) {
+        const Seg2 *g = &bv->segs[s];
+        if (!on_line(g, pu, pv, du, dv, len)) continue;
+        double t0 = ((g->u0 - pu) * du + (g->v0 - pv) * dv) / len;
+        double t1 = ((g->u1 - pu) * du + (g->v1 - pv) * dv) / len;
+        spans[n++] = t0 < t1 ? (Span){t0, t1} : (Span){t1, t0};
+    }
+    qsort(spans, n, sizeof(Span), cmp_span);
+    double reach = 0.0;
+    for (size_t i = 0; i < n && spans[i].t0 <= reach + EPS; i++) {
+        if (spans[i].t1 > reach) reach = spans[i].t1;
+    }
+    return reach >= len - EPS;
+}
+
+static int brute_inside(PointXYZ p, PointXYZ q, PointXYZ r) {
+    double d[3] = {q.x - p.x, q.y - p.y, q.z - p.z};
+    double w[3] = {r.x - p.x, r.y - p.y, r.z - p.z};
+    double len2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    if (len2 == 0.0) return 0;
+    double t = (w[0] * d[0] + w[1] * d[1] + w[2] * d[2]) / len2;
+    if (t <= 0.0 || t >= 1.0) return 0;
+    double c[3] = {w[1] * d[2] - w[2] * d[1], w[2] * d[0] - w[0] * d[2],
+                   w[0] * d[1] - w[1] * d[0]};
+    return sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]) <= EPS * sqrt(len2);
+}
+
+static int has_key(const uint64_t *keys, size_t n, uint64_t key) {
+    return bsearch(&key, keys, n, sizeof(uint64_t), cmp_u64) != NULL;
+}
+
+/* Пара p-q проходит вид: проекции совпадают или покрыты */
+static int brute_view_allows(const BruteView *bv, Span *spans, size_t i, size_t j) {
+    size_t a = (size_t)bv->vrep[i], b = (size_t)bv->vrep[j];
+    if (a == b) return 1;
+    double du = bv->u[b] - bv->u[a], dv = bv->v[b] - bv->v[a];
+    double len = sqrt(du * du + dv * dv);
+    if (!spans) {
+        return has_line_segment(bv, i, bv->u[a], bv->v[a], du, dv, len) &&
+               has_line_segment(bv, j, bv->u[a], bv->v[a], du, dv, len);
+    }
+    // Как в find_wires: прямая проверяется от точки с меньшим номером
+    if (a > b) {
+        size_t t = a;
+        a = b;
+        b = t;
+    }
+    return brute_covered(bv, spans, bv->u[a], bv->v[a], bv->u[b], bv->v[b]);
+}
+
+static int brute_edges(const Projections *pr, const PointXYZ *pts, size_t n,
+                       Edge3D **out, size_t *nout) {
+    BruteView views[VIEW_COUNT];
+    memset(views, 0, sizeof(views));
+    Span *spans = NULL;
+    uint64_t *keys = NULL;
+    size_t nkeys = 0, cap = 0;
+    Edge3D *edges = NULL;
+    int ok = 1;
+
+    size_t maxsegs = 0;
+    for (int v = 0; v < VIEW_COUNT && ok; v++) {
+        ok = brute_segments(pr, v, &views[v]) && brute_incidence(&views[v], v, pts, n);
+        if (ok && views[v].nsegs > maxsegs) maxsegs = views[v].nsegs;
+    }
+    if (ok) ok = (spans = (Span *)malloc((maxsegs + 1) * sizeof(Span))) != NULL;
+
+    // Сначала отсечение по отрезкам через концы, затем покрытие
+    for (size_t i = 0; i < n && ok; i++) {
+        for (size_t j = i + 1; j < n && ok; j++) {
+            int pass = 1;
+            for (int v = 0; v < VIEW_COUNT && pass; v++)
+                pass = views[v].vrep[i] >= 0 && views[v].vrep[j] >= 0 &&
+                       brute_view_allows(&views[v], NULL, i, j);
+            for (int v = 0; v < VIEW_COUNT && pass; v++)
+                pass = brute_view_allows(&views[v], spans, i, j);
+            if (!pass) continue;
+            if (nkeys == cap) {
+                size_t new_cap = cap ? cap * 2 : 1024;
+                uint64_t *resized = (uint64_t *)realloc(keys, new_cap * sizeof(uint64_t));
+                if (!resized) {
+                    ok = 0;
+                    break;
+                }
+                keys = resized;
+                cap = new_cap;
+            }
+            keys[nkeys++] = edge_key(i, j);
+        }
+    }
+
+    // Ребро, через которое проходит третья вершина с обоими найденными
+    // половинами, выбрасывается; проверка идёт по набору до выбрасывания.
+    // Ключи добавлялись по возрастанию — двоичный поиск без сортировки
+    size_t ne = 0;
+    if (ok) ok = (edges = (Edge3D *)malloc((nkeys + 1) * sizeof(Edge3D))) != NULL;
+    for (size_t e = 0; e < nkeys && ok; e++) {
+        size_t a = (size_t)(keys[e] >> 32), b = (size_t)(keys[e] & 0xffffffffu);
+        int composite = 0;
+        for (size_t r = 0; r < n && !composite; r++) {
+            composite = brute_inside(pts[a], pts[b], pts[r]) &&
+                        has_key(keys, nkeys, edge_key(a, r)) &&
+                        has_key(keys, nkeys, edge_key(r, b));
+        }
+        if (!composite) edges[ne++] = (Edge3D){a, b};
+    }
+
+    for (int v = 0; v < VIEW_COUNT; v++) brute_view_free(&views[v]);
+    free(spans);
+    free(keys);
+    if (!ok) {
+        free(edges);
+        return 0;
+    }
+    *out = edges;
+    *nout = ne;
+    return 1;
+}
+
+/* Совпадение вершин с "X 3D.txt" при записи эталона: ни при каком
+   варианте, как нарисовано, или с отражённой осью y вида сбоку (чертёж
+   polyhedral нарисован так, что исходная программа видит вид сбоку
+   зеркально). Записывается в эталон, и при проверке вершины сверяются
+   с "X 3D.txt" строго в этом варианте */
+enum { TRUTH_NONE, TRUTH_DIRECT, TRUTH_PROFILE_Y, TRUTH_COUNT };
+
+static const char *const truth_names[TRUTH_COUNT] = {"none", "direct", "profile-y"};
+
+static void flip_profile(Projections *pr) {
+    for (size_t i = 0; i < pr->nyz; i++) pr->yz[i].y = -pr->yz[i].y;
+}
+
+/* Вершины совпадают с "X 3D.txt" полностью */
+static int truth_matches(const PointSet *truth, const PointXYZ *pts, size_t n) {
+    PointSet ours;
+    Compare cmp;
+    if (!pointset_init(&ours, n)) return 0;
+    int ok = 1;
+    for (size_t i = 0; i < n && ok; i++) ok = pointset_insert(&ours, pts[i]) >= 0;
+    ok = ok && compare_truth(truth, &ours, &cmp) && cmp.missing == 0 && cmp.extra == 0;
+    pointset_free(&ours);
+    return ok;
+}
+
+/* Вариант совпадения с "X 3D.txt" рядом с file; вершины без отражения
+   уже найдены. Вершины с отражением ищутся тем же перебором */
+static int truth_align(const char *file, const PointXYZ *pts, size_t n, int *align) {
+    char tname[4096];
+    PointSet truth;
+    *align = TRUTH_NONE;
+    if (!sibling_name(file, "3D.txt", tname, sizeof(tname)) || access(tname, R_OK) != 0)
+        return 1;
+    if (!load_truth(tname, &truth)) return 0;
+
+    int ok = 1;
+    if (truth_matches(&truth, pts, n)) {
+        *align = TRUTH_DIRECT;
+    } else {
+        Projections pr;
+        PointXYZ *flipped = NULL;
+        size_t nf = 0;
+        ok = parse_projections(NULL, NULL, file, &pr);
+        if (ok) {
+            flip_profile(&pr);
+            ok = brute_vertices(&pr, &flipped, &nf);
+            projections_free(&pr);
+        }
+        if (ok && truth_matches(&truth, flipped, nf)) *align = TRUTH_PROFILE_Y;
+        free(flipped);
+    }
+    pointset_free(&truth);
+    return ok;
+}
+
+/* Запись эталона для чертежа file в gname */
+static int write_golden(const char *file, const char *gname,
+                        size_t *npts, size_t *nedges, int *align) {
+    Projections pr;
+    if (!parse_projections(NULL, NULL, file, &pr)) return 0;
+
+    // Точки видов — в порядке файла, отрезки — пары подряд
+    PointXYZ *pts = NULL;
+    Edge3D *edges = NULL;
+    size_t ne = 0;
+    int ok = brute_vertices(&pr, &pts, npts) &&
+             brute_edges(&pr, pts, *npts, &edges, &ne);
+    projections_free(&pr);
+    ok = ok && truth_align(file, pts, *npts, align);
+
+    Writer w;
+    if (ok && writer_open(&w, gname)) {
+        char head[160];
+        snprintf(head, sizeof(head), "# bench -g: eps %.17g\n# bench -g: 3D %s\n",
+                 EPS, truth_names[*align]);
+        writer_str(&w, head);
+        ResultData rd = {pts, *npts, edges, ne, NULL, NULL};
+        ok = write_result(&w, OUT_OBJ, &rd);
+        ok = writer_close(&w) && ok;
+    } else {
+        ok = 0;
+    }
+    *nedges = ne;
+    free(pts);
+    free(edges);
+    return ok;
+}
+
+static void golden_free(Golden *g) {
+    free(g->pts);
+    free(g->edges);
+    memset(g, 0, sizeof(*g));
+}
+
+/* Разбор "X golden.obj": строка "# bench -g: eps E", "v x y z", "l a b" */
+static int load_golden(const char *file, Golden *g) {
+    memset(g, 0, sizeof(*g));
+    FILE *f = fopen(file, "r");
+    if (!f) return 0;
+    char line[256];
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), f)) {
+        PointXYZ p;
+        unsigned long long a, b;
+        char word[16];
+        if (sscanf(line, "# bench -g: eps %lf", &g->eps) == 1) continue;
+        if (sscanf(line, "# bench -g: 3D %15s", word) == 1) {
+            for (int a = 0; a < TRUTH_COUNT; a++)
+                if (strcmp(word, truth_names[a]) == 0) g->align = a;
+            continue;
+        }
+        if (sscanf(line, "v %lf %lf %lf", &p.x, &p.y, &p.z) == 3) {
+            if (g->npts == g->cap) {
+                size_t cap = g->cap ? g->cap * 2 : 1024;
+                PointXYZ *resized = (PointXYZ *)realloc(g->pts, cap * sizeof(PointXYZ));
+                if (!resized) {
+                    ok = 0;
+                    break;
+                }
+                g->pts = resized;
+                g->cap = cap;
+            }
+            g->pts[g->npts++] = p;
+        } else if (sscanf(line, "l %llu %llu", &a, &b) == 2) {
+            // Номера вершин в OBJ — с единицы
+            if (a < 1 || b < 1 || a > g->npts || b > g->npts) {
+                ok = 0;
+                break;
+            }
+            if (g->nedges == g->edges_cap) {
+                size_t cap = g->edges_cap ? g->edges_cap * 2 : 1024;
+                Edge3D *resized = (Edge3D *)realloc(g->edges, cap * sizeof(Edge3D));
+                if (!resized) {
+                    ok = 0;
+                    break;
+                }
+                g->edges = resized;
+                g->edges_cap = cap;
+            }
+            g->edges[g->nedges++] = (Edge3D){(size_t)a - 1, (size_t)b - 1};
+        }
+    }
+    fclose(f);
+    if (!ok || g->eps <= 0.0) {
+        golden_free(g);
+        return 0;
+    }
+    return 1;
+}
+
+/* Вершины сравниваются с точностью EPS, рёбра — по номерам наших вершин,
+   совпавших с концами рёбер эталона */
+static int compare_golden(const Golden *g, const Reconstruction *r, GoldenDiff *d) {
+    memset(d, 0, sizeof(*d));
+    PointSet gold;
+    if (!pointset_init(&gold, g->npts)) return 0;
+    for (size_t i = 0; i < g->npts; i++) {
+        if (pointset_insert(&gold, g->pts[i]) < 0) {
+            pointset_free(&gold);
+            return 0;
+        }
+        if (!pointset_contains(&r->verts, g->pts[i])) {
+            if (d->vmissing < MAX_EXAMPLES) d->missing_ex[d->vmissing] = g->pts[i];
+            d->vmissing++;
+        }
+    }
+    for (size_t i = 0; i < r->verts.n; i++) {
+        if (!pointset_contains(&gold, r->verts.pts[i])) {
+            if (d->vextra < MAX_EXAMPLES) d->extra_ex[d->vextra] = r->verts.pts[i];
+            d->vextra++;
+        }
+    }
+    pointset_free(&gold);
+
+    uint64_t *ours = (uint64_t *)malloc((r->nedges + 1) * sizeof(uint64_t));
+    uint64_t *theirs = (uint64_t *)malloc((g->nedges + 1) * sizeof(uint64_t));
+    if (!ours || !theirs) {
+        free(ours);
+        free(theirs);
+        return 0;
+    }
+    for (size_t e = 0; e < r->nedges; e++) ours[e] = edge_key(r->edges[e].a, r->edges[e].b);
+    size_t nt = 0;
+    for (size_t e = 0; e < g->nedges; e++) {
+        long long a = pointset_find(&r->verts, g->pts[g->edges[e].a]);
+        long long b = pointset_find(&r->verts, g->pts[g->edges[e].b]);
+        if (a < 0 || b < 0) d->emissing++;
+        else theirs[nt++] = edge_key((size_t)a, (size_t)b);
+    }
+    qsort(ours, r->nedges, sizeof(uint64_t), cmp_u64);
+    qsort(theirs, nt, sizeof(uint64_t), cmp_u64);
+
+    size_t i = 0, j = 0;
+    while (i < r->nedges || j < nt) {
+        if (j == nt || (i < r->nedges && ours[i] < theirs[j])) {
+            d->eextra++;
+            i++;
+        } else if (i == r->nedges || theirs[j] < ours[i]) {
+            d->emissing++;
+            j++;
+        } else {
+            i++;
+            j++;
+        }
+    }
+    free(ours);
+    free(theirs);
+    return 1;
+}
+
+/* ----------------------------------------- */
+static void print_point(const char *what, PointXYZ p) {
+    printf("    %s: (%.6f, %.6f, %.6f)\n", what, p.x, p.y, p.z);
+}
+
+/* Строка сравнения с "X 3D.txt" исходной программы — только для сведения */
+static void print_truth(const char *file, const PointSet *ours) {
+    char tname[4096];
+    PointSet truth;
+    Compare cmp;
+    if (!sibling_name(file, "3D.txt", tname, sizeof(tname)) || access(tname, R_OK) != 0 ||
+        !load_truth(tname, &truth))
+        return;
+    if (compare_truth(&truth, ours, &cmp)) {
+        printf("    исходная программа: 3d %zu, различных вершин %zu, у нас нет %zu, "
+               "лишних %zu (не проверяется)\n",
+               reference_count(tname), cmp.ntruth, cmp.missing, cmp.extra);
+    }
+    pointset_free(&truth);
+}
+
+/* Строгая проверка по "X golden.obj". Эталон для другой точности
+   пропускается. В align — записанное в эталоне совпадение с "X 3D.txt".
+   Возвращает 0 при расхождении или ошибке */
+static int check_golden(const char *gname, const char *base, const Reconstruction *run,
+                        double best_sec, double rate, int *align) {
+    Golden gold;
+    GoldenDiff diff;
+    *align = TRUTH_NONE;
+    if (!load_golden(gname, &gold)) {
+        printf("%-28s ошибка чтения эталона\n", base);
+        return 0;
+    }
+    if (gold.eps != EPS) {
+        printf("%-28s %8zu %8zu %6s %6s %6s %10.4f %12.0f  эталон для eps %g\n",
+               base, run->verts.n, run->nedges, "golden", "-", "-", best_sec, rate, gold.eps);
+        golden_free(&gold);
+        return 1;
+    }
+    *align = gold.align;
+    if (!compare_golden(&gold, run, &diff)) {
+        printf("%-28s недостаточно памяти для сравнения\n", base);
+        golden_free(&gold);
+        return 0;
+    }
+
+    size_t missing = diff.vmissing + diff.emissing, extra = diff.vextra + diff.eextra;
+    int pass = missing == 0 && extra == 0;
+    printf("%-28s %8zu %8zu %6s %6zu %6zu %10.4f %12.0f  %s\n",
+           base, run->verts.n, run->nedges, "golden", missing, extra,
+           best_sec, rate, pass ? "OK" : "ОШИБКА");
+    if (!pass) {
+        printf("    эталон: вершин %zu, рёбер %zu; вершин нет %zu, лишних %zu; "
+               "рёбер нет %zu, лишних %zu\n",
+               gold.npts, gold.nedges, diff.vmissing, diff.vextra,
+               diff.emissing, diff.eextra);
+        for (size_t i = 0; i < diff.vmissing && i < MAX_EXAMPLES; i++)
+            print_point("нет", diff.missing_ex[i]);
+        for (size_t i = 0; i < diff.vextra && i < MAX_EXAMPLES; i++)
+            print_point("лишняя", diff.extra_ex[i]);
+    }
+    golden_free(&gold);
+    return pass;
+}
+
+/* Строгая проверка вершин по "X 3D.txt" в варианте из эталона. Для
+   TRUTH_PROFILE_Y чертёж восстанавливается заново с отражённой осью y
+   вида сбоку, run после этого держит этот результат */
+static int check_aligned(WorkerPool *pool, const char *file, int align, Reconstruction *run) {
+    char tname[4096];
+    PointSet truth;
+    Compare cmp;
+    if (align == TRUTH_NONE) {
+        print_truth(file, &run->verts);
+        return 1;
+    }
+    if (!sibling_name(file, "3D.txt", tname, sizeof(tname)) || !load_truth(tname, &truth)) {
+        printf("    ошибка чтения \"X 3D.txt\"\n");
+        return 0;
+    }
+
+    int ok = 1;
+    if (align == TRUTH_PROFILE_Y) {
+        Projections pr;
+        ok = parse_projections(NULL, NULL, file, &pr);
+        if (ok) {
+            flip_profile(&pr);
+            ok = recon_run_views(run, pool, pr.xy, pr.nxy, pr.xz, pr.nxz, pr.yz, pr.nyz);
+            projections_free(&pr);
+        }
+    }
+    if (!ok || !compare_truth(&truth, &run->verts, &cmp)) {
+        printf("    ошибка восстановления для сверки с \"X 3D.txt\"\n");
+        pointset_free(&truth);
+        return 0;
+    }
+
+    int pass = cmp.missing == 0 && cmp.extra == 0;
+    printf("    исходная программа (%s): различных вершин %zu, у нас нет %zu, "
+           "лишних %zu  %s\n",
+           align == TRUTH_PROFILE_Y ? "вид сбоку отражён по y" : "как нарисовано",
+           cmp.ntruth, cmp.missing, cmp.extra, pass ? "OK" : "ОШИБКА");
+    for (size_t i = 0; i < cmp.missing && i < MAX_EXAMPLES; i++)
+        print_point("нет", cmp.missing_ex[i]);
+    for (size_t i = 0; i < cmp.extra && i < MAX_EXAMPLES; i++)
+        print_point("лишняя", cmp.extra_ex[i]);
+    pointset_free(&truth);
+    return pass;
+}
+
+/* Строгая проверка вершин по "X 3D.txt" — для чертежей без golden,
+   например от gen, который пишет точный эталон */
+static int check_truth(const char *file, const char *base, const Reconstruction *run,
+                       double best_sec, double rate) {
+    char tname[4096];
+    PointSet truth;
+    Compare cmp;
+    if (!sibling_name(file, "3D.txt", tname, sizeof(tname)) || access(tname, R_OK) != 0) {
+        printf("%-28s %8zu %8zu %6s %6s %6s %10.4f %12.0f  нет эталона\n",
+               base, run->verts.n, run->nedges, "-", "-", "-", best_sec, rate);
+        return 1;
+    }
+    if (!load_truth(tname, &truth)) {
+        printf("%-28s ошибка чтения эталона\n", base);
+        return 0;
+    }
+    if (!compare_truth(&truth, &run->verts, &cmp)) {
+        printf("%-28s недостаточно памяти для сравнения\n", base);
+        pointset_free(&truth);
+        return 0;
+    }
+
+    int pass = cmp.missing == 0 && cmp.extra == 0;
+    printf("%-28s %8zu %8zu %6s %6zu %6zu %10.4f %12.0f  %s\n",
+           base, run->verts.n, run->nedges, "3D", cmp.missing, cmp.extra,
+           best_sec, rate, pass ? "OK" : "ОШИБКА");
+    if (!pass) {
+        printf("    оси (%+d, %+d, %+d), сдвиг (%.6f, %.6f, %.6f)\n",
+               cmp.sign[0], cmp.sign[1], cmp.sign[2],
+               cmp.shift[0], cmp.shift[1], cmp.shift[2]);
+        for (size_t i = 0; i < cmp.missing && i < MAX_EXAMPLES; i++)
+            print_point("нет", cmp.missing_ex[i]);
+        for (size_t i = 0; i < cmp.extra && i < MAX_EXAMPLES; i++)
+            print_point("лишняя", cmp.extra_ex[i]);
+    }
+    pointset_free(&truth);
+    return pass;
+}
+
+/* ----------------------------------------- */
+int main(int argc, char *argv[]) {
+    int nthreads = pool_default_threads();
+    int repeats = 3;
+    int make_golden = 0;
+    FileList files = {NULL, 0, 0};
+    int ok = 1;
+
+    for (int i = 1; i < argc && ok; i++) {
+        struct stat st;
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+            if (nthreads < 1) nthreads = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            ok = geom_set_eps(strtod(argv[++i], NULL));
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+            if (repeats < 1) repeats = 1;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            make_golden = 1;
+        } else if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            ok = file_list_scan_dir(&files, argv[i], "2D.txt");
+        } else {
+            ok = file_list_add(&files, argv[i]);
+        }
+    }
+    if (ok && files.n == 0) ok = file_list_scan_dir(&files, "../data", "2D.txt");
+    if (!ok || files.n == 0) {
+        fprintf(stderr, "Использование: %s [-t потоки] [-r повторы] [-e eps] [-g] [каталог | X 2D.txt ...]\n"
+                        "  -g — записать эталоны \"X golden.obj\" полным перебором\n", argv[0]);
+        file_list_free(&files);
+        return 1;
+    }
+
+    if (make_golden) {
+        size_t failed = 0;
+        for (size_t f = 0; f < files.n; f++) {
+            char gname[4096];
+            size_t npts = 0, nedges = 0;
+            int align = TRUTH_NONE;
+            double start = timing_now();
+            if (!sibling_name(files.names[f], "golden.obj", gname, sizeof(gname)) ||
+                !write_golden(files.names[f], gname, &npts, &nedges, &align)) {
+                printf("%s: ошибка записи эталона\n", files.names[f]);
+                failed++;
+                continue;
+            }
+            printf("%s: вершин %zu, рёбер %zu, X 3D.txt: %s, %.1f с\n", gname, npts, nedges,
+                   truth_names[align], timing_now() - start);
+        }
+        file_list_free(&files);
+        return failed ? 1 : 0;
+    }
+
+    WorkerPool pool;
+    if (!pool_init(&pool, nthreads)) {
+        log_error("Ошибка создания пула потоков\n");
+        file_list_free(&files);
+        return 1;
+    }
+    Reconstruction run;
+    if (!recon_init(&run)) {
+        log_error("Ошибка: недостаточно памяти\n");
+        pool_destroy(&pool);
+        file_list_free(&files);
+        return 1;
+    }
+    printf("Потоков: %d, повторов: %d\n\n", pool.nthreads, repeats);
+    printf("%-28s %8s %8s %6s %6s %6s %10s %12s  %s\n",
+           "чертёж", "вершин", "рёбер", "эталон", "нет", "лишних", "время, с", "точек/с", "итог");
+
+    size_t failed = 0;
+    for (size_t f = 0; f < files.n; f++) {
+        const char *file = files.names[f];
+        const char *base = strrchr(file, '/');
+        base = base ? base + 1 : file;
+
+        double best_sec;
+        if (!bench_file(&pool, file, repeats, &run, &best_sec)) {
+            printf("%-28s ошибка восстановления\n", base);
+            failed++;
+            continue;
+        }
+        size_t ninput = run.nxy + run.nxz + run.nyz;
+        double rate = best_sec > 0.0 ? (double)ninput / best_sec : 0.0;
+
+        char gname[4096];
+        if (sibling_name(file, "golden.obj", gname, sizeof(gname)) && access(gname, R_OK) == 0) {
+            int align;
+            int pass = check_golden(gname, base, &run, best_sec, rate, &align);
+            pass = check_aligned(&pool, file, align, &run) && pass;
+            failed += !pass;
+        } else {
+            failed += !check_truth(file, base, &run, best_sec, rate);
+        }
+    }
+
+    recon_free(&run);
+    pool_destroy(&pool);
+    printf("\nЧертежей: %zu, с ошибками: %zu\n", files.n, failed);
+    file_list_free(&files);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+#define CACHE_ALIGN 64
+
+static const size_t graph_elem_size[GRAPH_ARRAYS] = {
+    sizeof(Point2D), sizeof(size_t), sizeof(size_t), 2 * sizeof(long long),
+    sizeof(uint64_t), sizeof(uint64_t), sizeof(size_t), sizeof(uint32_t)
+};
+
+static size_t elem_size(int a) {
+    if (a == CACHE_XY) return sizeof(PointXY);
+    if (a == CACHE_XZ) return sizeof(PointXZ);
+    if (a == CACHE_YZ) return sizeof(PointYZ);
+    if (a < CACHE_GRAPHS) return sizeof(uint32_t);
+    return graph_elem_size[(a - CACHE_GRAPHS) % GRAPH_ARRAYS];
+}
+
+/* Поле графа вида, соответствующее массиву кэша */
+static void **graph_field(ViewGraph *g, int k) {
+    switch (k) {
+    case GRAPH_PTS:       return (void **)&g->pts;
+    case GRAPH_NEXT:      return (void **)&g->next;
+    case GRAPH_CELLS:     return (void **)&g->cells;
+    case GRAPH_CELL_KEYS: return (void **)&g->cell_keys;
+    case GRAPH_SEGS:      return (void **)&g->segs;
+    case GRAPH_SEG_LIST:  return (void **)&g->seg_list;
+    case GRAPH_ADJ_BEGIN: return (void **)&g->adj_begin;
+    default:              return (void **)&g->adj;
+    }
+}
+
+static void graph_counts(const ViewGraph *g, uint64_t *count) {
+    count[GRAPH_PTS] = g->npts;
+    count[GRAPH_NEXT] = g->npts;
+    count[GRAPH_CELLS] = g->cell_mask + 1;
+    count[GRAPH_CELL_KEYS] = g->cell_mask + 1;
+    count[GRAPH_SEGS] = g->seg_mask + 1;
+    count[GRAPH_SEG_LIST] = g->nsegs;
+    count[GRAPH_ADJ_BEGIN] = g->npts + 1;
+    count[GRAPH_ADJ] = 2 * g->nsegs;
+}
+
+void cache_path(const char *source, char *out, size_t size) {
+    snprintf(out, size, "%s.cache", source);
+}
+
+/* Отображение файла только для чтения; NULL — нет файла или он пуст */
+static const char *map_readonly(const char *path, size_t *len, struct stat *st) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, st) != 0 || st->st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    *len = (size_t)st->st_size;
+    void *map = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : (const char *)map;
+}
+
+static uint64_t fnv1a(const char *p, size_t len) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)p[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/* Хеш текста чертежа; 0 — файл не прочитан */
+static int source_hash(const char *source, uint64_t *hash) {
+    struct stat st;
+    size_t len;
+    const char *map = map_readonly(source, &len, &st);
+    if (!map) return 0;
+    *hash = fnv1a(map, len);
+    munmap((void *)map, len);
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Проверка заголовка и границ массивов */
+static int header_valid(const CacheHeader *h, size_t len, const struct stat *src,
+                        const char *source) {
+    if (memcmp(h->magic, CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != CACHE_VERSION || h->header_size != sizeof(CacheHeader) ||
+        h->eps != EPS || h->step != geom_step || h->src_size != (uint64_t)src->st_size)
+        return 0;
+
+    for (int a = 0; a < CACHE_ARRAYS; a++) {
+        if (h->offset[a] % CACHE_ALIGN != 0 || h->offset[a] > len ||
+            h->count[a] > (len - h->offset[a]) / elem_size(a))
+            return 0;
+    }
+
+    // Тот же mtime — текст не менялся; иначе решает хеш
+    if (h->src_mtime_sec == (int64_t)src->st_mtim.tv_sec &&
+        h->src_mtime_nsec == (int64_t)src->st_mtim.tv_nsec)
+        return 1;
+    uint64_t hash;
+    return source_hash(source, &hash) && hash == h->src_hash;
+}
+
+static int is_pow2(uint64_t v) {
+    return v && (v & (v - 1)) == 0;
+}
+
+/* Согласованность размеров массивов графа вида. Содержимое не
+   просматривается, чтобы не читать весь кэш при загрузке, — от чужих
+   и устаревших файлов защищают заголовок и проверка чертежа */
+static int graph_valid(const uint64_t *count) {
+    uint64_t n = count[GRAPH_PTS];
+    return count[GRAPH_NEXT] == n && count[GRAPH_ADJ_BEGIN] == n + 1 &&
+           count[GRAPH_CELLS] == count[GRAPH_CELL_KEYS] &&
+           is_pow2(count[GRAPH_CELLS]) && count[GRAPH_CELLS] > n &&
+           is_pow2(count[GRAPH_SEGS]) && count[GRAPH_SEGS] > count[GRAPH_SEG_LIST] &&
+           count[GRAPH_ADJ] == 2 * count[GRAPH_SEG_LIST] && n <= UINT32_MAX;
+}
+
+int cache_load(const char *path, const char *source, Projections *pr, WireIndex *w) {
+    memset(pr, 0, sizeof(*pr));
+    memset(w, 0, sizeof(*w));
+
+    struct stat src, st;
+    if (stat(source, &src) != 0) return 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    CacheHeader h;
+    int ok = fstat(fd, &st) == 0 &&
+             pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) &&
+             header_valid(&h, (size_t)st.st_size, &src, source);
+    ok = ok && h.count[CACHE_MXY] == h.count[CACHE_XY] &&
+         h.count[CACHE_MXZ] == h.count[CACHE_XZ] && h.count[CACHE_MYZ] == h.count[CACHE_YZ];
+    for (int v = 0; v < VIEW_COUNT && ok; v++)
+        ok = graph_valid(&h.count[CACHE_GRAPHS + v * GRAPH_ARRAYS]);
+    if (!ok) {
+        close(fd);
+        return 0;
+    }
+
+    // Массивы не копируются: проекции и графы указывают прямо в отображения
+    // файла (у проекций — своё, с копированием при записи)
+    size_t len = (size_t)st.st_size;
+    char *pmap = (char *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    char *wmap = (char *)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pmap == MAP_FAILED || wmap == MAP_FAILED) {
+        if (pmap != MAP_FAILED) munmap(pmap, len);
+        if (wmap != MAP_FAILED) munmap(wmap, len);
+        return 0;
+    }
+
+    pr->map = pmap;
+    pr->map_len = len;
+    memcpy(pr->lcs, h.lcs, sizeof(pr->lcs));
+    pr->near_boundary = (size_t)h.near_boundary;
+    pr->nxy = h.count[CACHE_XY];
+    pr->nxz = h.count[CACHE_XZ];
+    pr->nyz = h.count[CACHE_YZ];
+    pr->xy = (PointXY *)(pmap + h.offset[CACHE_XY]);
+    pr->xz = (PointXZ *)(pmap + h.offset[CACHE_XZ]);
+    pr->yz = (PointYZ *)(pmap + h.offset[CACHE_YZ]);
+    pr->mxy = (uint32_t *)(pmap + h.offset[CACHE_MXY]);
+    pr->mxz = (uint32_t *)(pmap + h.offset[CACHE_MXZ]);
+    pr->myz = (uint32_t *)(pmap + h.offset[CACHE_MYZ]);
+    pr->nxy_raw = h.raw_count[0];
+    pr->nxz_raw = h.raw_count[1];
+    pr->nyz_raw = h.raw_count[2];
+
+    w->map = wmap;
+    w->map_len = len;
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        ViewGraph *g = &w->views[v];
+        const uint64_t *count = &h.count[CACHE_GRAPHS + v * GRAPH_ARRAYS];
+        for (int k = 0; k < GRAPH_ARRAYS; k++)
+            *graph_field(g, k) = wmap + h.offset[CACHE_GRAPHS + v * GRAPH_ARRAYS + k];
+        g->npts = count[GRAPH_PTS];
+        g->nsegs = count[GRAPH_SEG_LIST];
+        g->cell_mask = count[GRAPH_CELLS] - 1;
+        g->seg_mask = count[GRAPH_SEGS] - 1;
+        g->inv_cell = grid_inv_cell();
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+static int write_padded(FILE *f, const void *p, size_t bytes, uint64_t *pos) {
+    static const char zeros[CACHE_ALIGN];
+    if (bytes && fwrite(p, 1, bytes, f) != bytes) return 0;
+    *pos += bytes;
+    size_t pad = (size_t)((CACHE_ALIGN - *pos % CACHE_ALIGN) % CACHE_ALIGN);
+    if (pad && fwrite(zeros, 1, pad, f) != pad) return 0;
+    *pos += pad;
+    return 1;
+}
+
+int cache_save(const char *path, const char *source, const Projections *pr,
+               WireIndex *w) {
+    struct stat src;
+    if (stat(source, &src) != 0) return 0;
+
+    // Таблицы графов при построении рассчитаны на все точки чертежа —
+    // в кэш они идут ужатыми
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        if (!w->map && !view_graph_compact(&w->views[v])) return 0;
+    }
+
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+    h.version = CACHE_VERSION;
+    h.header_size = sizeof(CacheHeader);
+    h.eps = EPS;
+    h.step = geom_step;
+    h.near_boundary = pr->near_boundary;
+    h.src_size = (uint64_t)src.st_size;
+    h.src_mtime_sec = (int64_t)src.st_mtim.tv_sec;
+    h.src_mtime_nsec = (int64_t)src.st_mtim.tv_nsec;
+    if (!source_hash(source, &h.src_hash)) return 0;
+    memcpy(h.lcs, pr->lcs, sizeof(h.lcs));
+    h.raw_count[0] = pr->nxy_raw;
+    h.raw_count[1] = pr->nxz_raw;
+    h.raw_count[2] = pr->nyz_raw;
+
+    const void *data[CACHE_ARRAYS] = {pr->xy, pr->xz, pr->yz, pr->mxy, pr->mxz, pr->myz};
+    h.count[CACHE_XY] = h.count[CACHE_MXY] = pr->nxy;
+    h.count[CACHE_XZ] = h.count[CACHE_MXZ] = pr->nxz;
+    h.count[CACHE_YZ] = h.count[CACHE_MYZ] = pr->nyz;
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        ViewGraph *g = &w->views[v];
+        graph_counts(g, &h.count[CACHE_GRAPHS + v * GRAPH_ARRAYS]);
+        for (int k = 0; k < GRAPH_ARRAYS; k++)
+            data[CACHE_GRAPHS + v * GRAPH_ARRAYS + k] = *graph_field(g, k);
+    }
+
+    uint64_t pos = sizeof(CacheHeader);
+    pos += (CACHE_ALIGN - pos % CACHE_ALIGN) % CACHE_ALIGN;
+    for (int a = 0; a < CACHE_ARRAYS; a++) {
+        h.offset[a] = pos;
+        size_t bytes = h.count[a] * elem_size(a);
+        pos += bytes + (CACHE_ALIGN - bytes % CACHE_ALIGN) % CACHE_ALIGN;
+    }
+
+    // Запись во временный файл: прерванная запись не оставит битый кэш
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        perror(tmp);
+        return 0;
+    }
+    pos = 0;
+    int ok = write_padded(f, &h, sizeof(h), &pos);
+    for (int a = 0; a < CACHE_ARRAYS && ok; a++) {
+        ok = pos == h.offset[a] && write_padded(f, data[a], h.count[a] * elem_size(a), &pos);
+    }
+    if (fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) {
+        perror(path);
+        ok = 0;
+    }
+    if (!ok) remove(tmp);
+    return ok;
+}
@@ -0,0 +1,83 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "geom.h"
+#include "parse.h"
+#include "wires.h"
+
+/* Двоичный кэш разобранного чертежа ("<чертёж>.cache" рядом с ним).
+   Хранит то, что получается после чтения, сортировки и сжатия: три
+   массива различных точек проекций в порядке сортировки с кратностями,
+   lcs видов и графы видов для рёбер
+   (слитые с точностью EPS точки, хеш-таблицы и смежность) — при загрузке
+   ничего не перестраивается и не копируется: массивы лежат по смещениям,
+   кратным 64 байтам, и используются прямо из отображённого файла.
+   Кэш устаревает при смене версии формата, EPS, режима квантования,
+   размера чертежа или его содержимого: при другом mtime сверяется хеш
+   текста */
+
+#define CACHE_MAGIC "RSCACHE"
+#define CACHE_VERSION 3
+
+/* Массивы графа вида (поля ViewGraph) */
+enum {
+    GRAPH_PTS,
+    GRAPH_NEXT,
+    GRAPH_CELLS,
+    GRAPH_CELL_KEYS,
+    GRAPH_SEGS,
+    GRAPH_SEG_LIST,
+    GRAPH_ADJ_BEGIN,
+    GRAPH_ADJ,
+    GRAPH_ARRAYS
+};
+
+/* Массивы кэша в порядке записи: проекции, кратности их точек,
+   затем графы трёх видов */
+enum {
+    CACHE_XY,
+    CACHE_XZ,
+    CACHE_YZ,
+    CACHE_MXY,
+    CACHE_MXZ,
+    CACHE_MYZ,
+    CACHE_GRAPHS,
+    CACHE_ARRAYS = CACHE_GRAPHS + VIEW_COUNT * GRAPH_ARRAYS
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    double eps;
+    double step;                  // шаг квантования проекций, 0 — без него
+    uint64_t near_boundary;
+    uint64_t src_size;
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    uint64_t src_hash;            // FNV-1a текста чертежа
+    double lcs[VIEW_COUNT][2];
+    uint64_t raw_count[3];        // точек XY, XZ, YZ в чертеже до сжатия
+    uint64_t count[CACHE_ARRAYS];
+    uint64_t offset[CACHE_ARRAYS];
+} CacheHeader;
+
+/* Имя кэша для чертежа */
+void cache_path(const char *source, char *out, size_t size);
+
+/* Загрузка действительного кэша: проекции (уже отсортированные)
+   и индекс отрезков. Освобождаются как обычно — projections_free
+   и wire_index_free. Возвращает 1 — загружен, 0 — нет кэша, он устарел
+   или повреждён (тогда чертёж читается как обычно) */
+int cache_load(const char *path, const char *source, Projections *pr, WireIndex *w);
+
+/* Запись кэша через временный файл и переименование. Проекции — уже
+   отсортированные и сжатые (compact_projections). Хеш-таблицы графов
+   видов при этом ужимаются (view_graph_compact).
+   Возвращает 1 при успехе */
+int cache_save(const char *path, const char *source, const Projections *pr,
+               WireIndex *w);
+
+#endif
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "proto.h"
+#include "timing.h"
+#include "writer.h"
+
+/* Клиент сервера восстановления (serve): один чертёж с выводом
+   результата или замер задержки — n запросов по j постоянным
+   соединениям, перцентили времени от отправки до полного ответа */
+
+typedef struct {
+    uint32_t status;
+    char *body;            // выровнен malloc — вершины читаются прямо из него
+    size_t len, cap;
+} Reply;
+
+/* Запрос и полный ответ. Возвращает 1, если обмен состоялся */
+static int roundtrip(int fd, uint32_t kind, const char *payload, size_t len, Reply *out) {
+    ProtoRequest rq = {PROTO_MAGIC, kind, len};
+    ProtoReply rp;
+    if (!proto_send(fd, &rq, sizeof(rq), payload, len) ||
+        !proto_read_all(fd, &rp, sizeof(rp)) || rp.magic != PROTO_MAGIC)
+        return 0;
+    if (rp.len + 1 > out->cap) {
+        char *resized = (char *)realloc(out->body, (size_t)rp.len + 1);
+        if (!resized) return 0;
+        out->body = resized;
+        out->cap = (size_t)rp.len + 1;
+    }
+    if (!proto_read_all(fd, out->body, (size_t)rp.len)) return 0;
+    out->body[rp.len] = '\0';
+    out->status = rp.status;
+    out->len = (size_t)rp.len;
+    return 1;
+}
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    size_t cap = 1 << 16;
+    char *buf = (char *)malloc(cap);
+    *len = 0;
+    size_t got;
+    while (buf && (got = fread(buf + *len, 1, cap - *len, f)) > 0) {
+        *len += got;
+        if (*len == cap) {
+            char *resized = (char *)realloc(buf, cap * 2);
+            if (!resized) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = resized;
+            cap *= 2;
+        }
+    }
+    if (!buf) fprintf(stderr, "Ошибка: недостаточно памяти\n");
+    fclose(f);
+    return buf;
+}
+
+/* ----------------------------------------- */
+/* Один чертёж: ответ выводится в выбранном формате */
+static int run_single(int fd, uint32_t kind, const char *payload, size_t len,
+                      const char *out_file, OutFormat format) {
+    Reply rep = {0, NULL, 0, 0};
+    if (!roundtrip(fd, kind, payload, len, &rep)) {
+        fprintf(stderr, "Ошибка обмена с сервером\n");
+        free(rep.body);
+        return 1;
+    }
+    if (rep.status != PROTO_OK) {
+        fprintf(stderr, "Сервер: %s\n", rep.body);
+        free(rep.body);
+        return 1;
+    }
+
+    const PointXYZ *pts;
+    const uint64_t *ab;
+    size_t npts, nedges;
+    if (!proto_parse_result(rep.body, rep.len, &pts, &npts, &ab, &nedges)) {
+        fprintf(stderr, "Неверный ответ сервера\n");
+        free(rep.body);
+        return 1;
+    }
+    Edge3D *edges = (Edge3D *)malloc((nedges ? nedges : 1) * sizeof(Edge3D));
+    int written = edges != NULL;
+    for (size_t e = 0; e < nedges && edges; e++) edges[e] = (Edge3D){ab[2 * e], ab[2 * e + 1]};
+
+    Writer w;
+    if (written && writer_open(&w, out_file)) {
+        ResultData rd = {pts, npts, edges, nedges, NULL, NULL};
+        written = write_result(&w, format, &rd);
+        written = writer_close(&w) && written;
+    } else {
+        written = 0;
+    }
+    if (!written) fprintf(stderr, "Ошибка записи результата\n");
+    free(edges);
+    free(rep.body);
+    return written ? 0 : 1;
+}
+
+/* ----------------------------------------- */
+/* Замер: поток на соединение, у каждого свой отрезок массива задержек */
+typedef struct {
+    const char *socket_path;
+    uint32_t kind;
+    const char *payload;
+    size_t len;
+    double *lat;           // задержки потока, с
+    size_t n;
+    size_t failed;
+    size_t expect;         // размер ответа, как у пробного запроса
+    int ok;
+} BenchConn;
+
+static void *bench_conn(void *arg) {
+    BenchConn *c = (BenchConn *)arg;
+    int fd = proto_connect(c->socket_path);
+    if (fd < 0) return NULL;
+    Reply rep = {0, NULL, 0, 0};
+    c->ok = 1;
+    for (size_t i = 0; i < c->n; i++) {
+        double t0 = timing_now();
+        if (!roundtrip(fd, c->kind, c->payload, c->len, &rep)) {
+            c->ok = 0;
+            break;
+        }
+        c->lat[i] = timing_now() - t0;
+        if (rep.status != PROTO_OK || rep.len != c->expect) c->failed++;
+    }
+    free(rep.body);
+    close(fd);
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double p) {
+    size_t k = (size_t)(p * (double)(n - 1) + 0.5);
+    return sorted[k];
+}
+
+static int run_bench(const char *socket_path, uint32_t kind, const char *payload,
+                     size_t len, size_t nreq, int nconn) {
+    // Пробный запрос: проверка ответа и прогрев соединения сервера
+    int fd = proto_connect(socket_path);
+    if (fd < 0) return 1;
+    Reply rep = {0, NULL, 0, 0};
+    int ok = roundtrip(fd, kind, payload, len, &rep);
+    close(fd);
+    if (!ok || rep.status != PROTO_OK) {
+        fprintf(stderr, "Пробный запрос не выполнен%s%s\n",
+                ok ? ": " : "", ok ? rep.body : "");
+        free(rep.body);
+        return 1;
+    }
+    size_t expect = rep.len;
+    free(rep.body);
+
+    double *lat = (double *)malloc(nreq * sizeof(double));
+    BenchConn *conns = (BenchConn *)calloc((size_t)nconn, sizeof(BenchConn));
+    pthread_t *threads = (pthread_t *)malloc((size_t)nconn * sizeof(pthread_t));
+    if (!lat || !conns || !threads) {
+        fprintf(stderr, "Ошибка: недостаточно памяти\n");
+        free(lat);
+        free(conns);
+        free(threads);
+        return 1;
+    }
+
+    double started = timing_now();
+    size_t off = 0;
+    int nthreads = 0;
+    for (int c = 0; c < nconn; c++) {
+        size_t n = nreq / (size_t)nconn + ((size_t)c < nreq % (size_t)nconn);
+        conns[c] = (BenchConn){socket_path, kind, payload, len, lat + off, n, 0, expect, 0};
+        off += n;
+        if (pthread_create(&threads[c], NULL, bench_conn, &conns[c]) != 0) break;
+        nthreads++;
+    }
+    for (int c = 0; c < nthreads; c++) pthread_join(threads[c], NULL);
+    double wall = timing_now() - started;
+
+    // Задержки собираются подряд; прерванные соединения не учитываются
+    size_t n = 0, failed = 0;
+    ok = nthreads == nconn;
+    for (int c = 0; c < nthreads; c++) {
+        if (!conns[c].ok) ok = 0;
+        else memmove(lat + n, conns[c].lat, conns[c].n * sizeof(double));
+        if (conns[c].ok) n += conns[c].n;
+        failed += conns[c].failed;
+    }
+    qsort(lat, n, sizeof(double), cmp_double);
+
+    printf("Запросов: %zu, соединений: %d, ответ %zu байт\n", n, nconn, expect);
+    if (n > 0) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) sum += lat[i];
+        printf("Задержка, мс: среднее %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, макс %.3f\n",
+               sum * 1000.0 / (double)n, percentile(lat, n, 0.50) * 1000.0,
+               percentile(lat, n, 0.90) * 1000.0, percentile(lat, n, 0.99) * 1000.0,
+               percentile(lat, n, 0.999) * 1000.0, lat[n - 1] * 1000.0);
+        printf("Пропускная способность: %.0f запросов/с\n", (double)n / wall);
+    }
+    if (failed) printf("Ошибочных ответов: %zu\n", failed);
+    if (!ok) fprintf(stderr, "Часть соединений прервана\n");
+
+    free(lat);
+    free(conns);
+    free(threads);
+    return ok && failed == 0 ? 0 : 1;
+}
+
+/* ----------------------------------------- */
+int main(int argc, char *argv[]) {
+    const char *socket_path = PROTO_SOCKET_DEFAULT;
+    const char *input_file = NULL;
+    const char *out_file = NULL;
+    const char *format_name = NULL;
+    uint32_t kind = PROTO_TEXT;
+    long nreq = 0;
+    int nconn = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0) {
+            kind = PROTO_PATH;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            nreq = atol(argv[++i]);
+            if (nreq < 1) nreq = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            nconn = atoi(argv[++i]);
+            if (nconn < 1) nconn = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            format_name = argv[++i];
+        } else if (argv[i][0] != '-' && !input_file) {
+            input_file = argv[i];
+        } else {
+            input_file = NULL;
+            break;
+        }
+    }
+    if (!input_file) {
+        fprintf(stderr, "Использование: %s [-s сокет] [-p] [-o файл] [-f формат] "
+                        "[-n запросов [-j соединений]] чертёж\n", argv[0]);
+        return 1;
+    }
+    OutFormat format = OUT_LIST;
+    if (format_name && !out_format_parse(format_name, &format)) {
+        fprintf(stderr, "Неизвестный формат: %s\n", format_name);
+        return 1;
+    }
+    if ((long)nconn > nreq && nreq > 0) nconn = (int)nreq;
+
+    // -p: сервер сам отображает файл, по сокету идёт только путь —
+    // полный, потому что текущий каталог у сервера свой
+    char *text = NULL;
+    const char *payload = NULL;
+    size_t len = 0;
+    if (kind == PROTO_PATH) {
+        text = realpath(input_file, NULL);
+        if (!text) {
+            perror(input_file);
+            return 1;
+        }
+        payload = text;
+        len = strlen(text);
+    } else {
+        text = read_file(input_file, &len);
+        if (!text) return 1;
+        payload = text;
+    }
+
+    int rc;
+    if (nreq > 0) {
+        rc = run_bench(socket_path, kind, payload, len, (size_t)nreq, nconn);
+    } else {
+        int fd = proto_connect(socket_path);
+        rc = fd < 0 ? 1 : run_single(fd, kind, payload, len, out_file, format);
+        if (fd >= 0) close(fd);
+    }
+    free(text);
+    return rc;
+}
@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "compact.h"
+
+/* Хеш точки вида по битам координат; -0.0 и 0.0 равны и хешируются
+   одинаково (прибавление 0.0 даёт +0.0) */
+static inline size_t hash_pair(double a, double b) {
+    uint64_t ba, bb;
+    a += 0.0;
+    b += 0.0;
+    memcpy(&ba, &a, sizeof(ba));
+    memcpy(&bb, &b, sizeof(bb));
+    uint64_t h = ba * 0x9E3779B97F4A7C15ULL;
+    h ^= bb * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+/* Сжатие одного вида */
+typedef struct {
+    void *pts;
+    size_t *n;
+    uint32_t **mult;
+    Arena *arena;          // кратности из арены видов (NULL — malloc)
+    int ok;
+} CompactView;
+
+/* Первое вхождение каждой точки сдвигается на место очередной
+   различной точки, повторы добавляют кратность. Кратность не
+   переполняется: при UINT32_MAX вхождений начинается новая запись */
+#define DEFINE_COMPACT(NAME, TYPE, A, B)                                      \
+static void NAME(CompactView *v) {                                           \
+    TYPE *a = (TYPE *)v->pts;                                                 \
+    size_t n = *v->n;                                                         \
+    size_t cap = 16;                                                          \
+    while (cap < 2 * n) cap *= 2;                                             \
+    size_t mask = cap - 1;                                                    \
+    size_t *table = (size_t *)calloc(cap, sizeof(size_t));                    \
+    uint32_t *mult = (uint32_t *)arena_or_malloc(v->arena, n * sizeof(uint32_t)); \
+    if (!table || !mult) {                                                    \
+        free(table);                                                          \
+        if (mult) arena_or_free(v->arena, mult);                              \
+        v->ok = 0;                                                            \
+        return;                                                               \
+    }                                                                         \
+    size_t m = 0;                                                             \
+    for (size_t i = 0; i < n; i++) {                                          \
+        TYPE p = a[i];                                                        \
+        size_t slot = hash_pair(p.A, p.B) & mask;                             \
+        size_t found = 0;                                                     \
+        while (table[slot]) {                                                 \
+            size_t k = table[slot] - 1;                                       \
+            if (a[k].A == p.A && a[k].B == p.B && mult[k] < UINT32_MAX) {     \
+                found = k + 1;                                                \
+                break;                                                        \
+            }                                                                 \
+            slot = (slot + 1) & mask;                                         \
+        }                                                                     \
+        if (found) {                                                          \
+            mult[found - 1]++;                                                \
+            continue;                                                         \
+        }                                                                     \
+        a[m] = p;                                                             \
+        mult[m] = 1;                                                          \
+        table[slot] = ++m;                                                    \
+    }                                                                         \
+    free(table);                                                              \
+    uint32_t *shrunk = v->arena ? NULL                                        \
+        : (uint32_t *)realloc(mult, (m ? m : 1) * sizeof(uint32_t));          \
+    *v->mult = shrunk ? shrunk : mult;                                        \
+    *v->n = m;                                                                \
+    v->ok = 1;                                                                \
+}
+
+DEFINE_COMPACT(compact_xy, PointXY, x, y)
+DEFINE_COMPACT(compact_xz, PointXZ, x, z)
+DEFINE_COMPACT(compact_yz, PointYZ, y, z)
+
+static void compact_task(void *arg, size_t task) {
+    CompactView *v = &((CompactView *)arg)[task];
+    if (task == 0) compact_xy(v);
+    else if (task == 1) compact_xz(v);
+    else compact_yz(v);
+}
+
+static CompactView compact_entry(Projections *pr, int view) {
+    if (view == VIEW_TOP) return (CompactView){pr->xy, &pr->nxy, &pr->mxy, pr->arena, 0};
+    if (view == VIEW_FRONT) return (CompactView){pr->xz, &pr->nxz, &pr->mxz, pr->arena, 0};
+    return (CompactView){pr->yz, &pr->nyz, &pr->myz, pr->arena, 0};
+}
+
+int compact_projections(WorkerPool *pool, Projections *pr) {
+    CompactView views[3] = {
+        compact_entry(pr, VIEW_TOP),
+        compact_entry(pr, VIEW_FRONT),
+        compact_entry(pr, VIEW_PROFILE),
+    };
+    if (pool) {
+        pool_run(pool, compact_task, views, 3);
+    } else {
+        for (size_t t = 0; t < 3; t++) compact_task(views, t);
+    }
+    return views[0].ok && views[1].ok && views[2].ok;
+}
+
+int compact_view(Projections *pr, int view) {
+    CompactView v = compact_entry(pr, view);
+    if (view == VIEW_TOP) compact_xy(&v);
+    else if (view == VIEW_FRONT) compact_xz(&v);
+    else compact_yz(&v);
+    return v.ok;
+}
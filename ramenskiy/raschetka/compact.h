@@ -0,0 +1,20 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include "parse.h"
+#include "pool.h"
+
+/* Сжатие отсортированных проекций перед соединением.
+   Каждый отрезок вида перечисляет оба конца, поэтому общие концы
+   отрезков повторяются в секции много раз. Точные повторы точки вида
+   сливаются в первое вхождение, число вхождений сохраняется в mxy/mxz/myz,
+   порядок оставшихся точек не меняется. Смежность точек к этому моменту
+   уже собрана в WireIndex по исходному порядку файла (wire_index_build),
+   так что восстановление рёбер от сжатия не зависит.
+   Виды сжимаются параллельно, если pool != NULL. Возвращает 1 при успехе */
+int compact_projections(WorkerPool *pool, Projections *pr);
+
+/* Сжатие одного вида (VIEW_*) в вызывающем потоке */
+int compact_view(Projections *pr, int view);
+
+#endif
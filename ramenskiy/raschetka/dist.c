@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <mpi.h>
+
+#include "compact.h"
+#include "geom.h"
+#include "join.h"
+#include "parse.h"
+#include "pointset.h"
+#include "pool.h"
+#include "sort.h"
+#include "timing.h"
+#include "wires.h"
+#include "writer.h"
+
+/* Распределённое восстановление чертежа на нескольких процессах MPI.
+   Процесс 0 читает и сортирует чертёж (как try), затем делит вид
+   сверху на непрерывные куски по x — поровну по числу точек — и раздаёт:
+   каждый процесс получает свой кусок XY, точки XZ с x в его диапазоне,
+   расширенном на EPS в обе стороны, и только те точки YZ, которые могут
+   совпасть с его кусками XY и XZ. Соединение и отбор
+   вершин идут на всех процессах параллельно (внутри процесса — на пуле
+   потоков), вершины собираются на процесс 0 по порядку процессов и
+   проходят общий отбор: повторяться могут только вершины у границ
+   кусков. Рёбра строятся на процессе 0 по индексу отрезков всего
+   чертежа. Порядок кандидатов тот же, что у try, поэтому и результат
+   тот же (в режиме -q — всегда; в обычном режиме отличие возможно
+   только для цепочек точек через EPS на самой границе кусков) */
+
+/* MPI считает элементы в int — большие массивы идут кусками */
+#define DIST_CHUNK (1 << 30)
+
+enum {
+    TAG_HEADER = 1,
+    TAG_DATA,
+    TAG_RESULT
+};
+
+/* Доля процесса: размеры его кусков видов */
+typedef struct {
+    uint64_t nxy, nxz, nyz;
+} DistHeader;
+
+/* Итог процесса для отчёта о нагрузке */
+typedef struct {
+    double join_sec;
+    double nxy, nxz, nyz;
+    double npts;
+    double found;
+} DistStats;
+
+static void send_bytes(const void *p, size_t n, int dest, int tag) {
+    const char *c = (const char *)p;
+    while (n > 0) {
+        size_t part = n < DIST_CHUNK ? n : DIST_CHUNK;
+        MPI_Send(c, (int)part, MPI_BYTE, dest, tag, MPI_COMM_WORLD);
+        c += part;
+        n -= part;
+    }
+}
+
+static void recv_bytes(void *p, size_t n, int src, int tag) {
+    char *c = (char *)p;
+    while (n > 0) {
+        size_t part = n < DIST_CHUNK ? n : DIST_CHUNK;
+        MPI_Recv(c, (int)part, MPI_BYTE, src, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        c += part;
+        n -= part;
+    }
+}
+
+static void *xmalloc(size_t n) {
+    void *p = malloc(n ? n : 1);
+    if (!p) {
+        fprintf(stderr, "Ошибка: недостаточно памяти (%zu байт)\n", n);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return p;
+}
+
+/* ----------------------------------------- */
+/* Доля процесса в видах */
+typedef struct {
+    PointXY *xy;
+    uint32_t *mxy;
+    size_t nxy;
+    PointXZ *xz;
+    uint32_t *mxz;
+    size_t nxz;
+    PointYZ *yz;
+    size_t nyz;
+} Share;
+
+static void share_free(Share *s) {
+    free(s->xy);
+    free(s->mxy);
+    free(s->xz);
+    free(s->mxz);
+    free(s->yz);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Первая точка XZ с ключом x не меньше key (вид отсортирован по ключам) */
+static size_t xz_lower_key(const PointXZ *xz, size_t n, long long key, double inv_cell) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (grid_key(xz[mid].x, inv_cell) < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Есть ли в отсортированном a значение, совпадающее с v с точностью EPS.
+   Граница поиска — в той же арифметике, что approx_eq: v - EPS
+   округляется иначе, чем разность, и отсекал бы совпадения на краю */
+static int sorted_has(const double *a, size_t n, double v) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (v - a[mid] > EPS) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < n && approx_eq(a[lo], v);
+}
+
+/* Доля процесса r из сжатых видов процесса 0: кусок XY [xy_begin, xy_end),
+   окно XZ по ключам x с запасом EPS и те точки YZ, у которых y совпадает
+   с y какой-то точки куска, а z — с z какой-то точки окна: другие точки YZ
+   соединение этого процесса не найдёт. Массивы XY и XZ — указатели
+   внутрь pr, YZ копируется в s->yz */
+static void share_select(const Projections *pr, size_t xy_begin, size_t xy_end, Share *s) {
+    memset(s, 0, sizeof(*s));
+    s->xy = pr->xy + xy_begin;
+    s->mxy = pr->mxy + xy_begin;
+    s->nxy = xy_end - xy_begin;
+    if (s->nxy == 0) return;
+
+    double xlo = s->xy[0].x, xhi = xlo;
+    for (size_t i = 1; i < s->nxy; i++) {
+        if (s->xy[i].x < xlo) xlo = s->xy[i].x;
+        if (s->xy[i].x > xhi) xhi = s->xy[i].x;
+    }
+
+    // Окно берётся целыми ячейками сетки: оно не уже [xlo - EPS, xhi + EPS]
+    double inv_cell = grid_inv_cell();
+    size_t b = xz_lower_key(pr->xz, pr->nxz, grid_key(xlo - EPS, inv_cell), inv_cell);
+    size_t e = xz_lower_key(pr->xz, pr->nxz, grid_key(xhi + EPS, inv_cell) + 1, inv_cell);
+    s->xz = pr->xz + b;
+    s->mxz = pr->mxz + b;
+    s->nxz = e - b;
+    if (s->nxz == 0) return;
+
+    double *ys = (double *)xmalloc(s->nxy * sizeof(double));
+    double *zs = (double *)xmalloc(s->nxz * sizeof(double));
+    for (size_t i = 0; i < s->nxy; i++) ys[i] = s->xy[i].y;
+    for (size_t i = 0; i < s->nxz; i++) zs[i] = s->xz[i].z;
+    qsort(ys, s->nxy, sizeof(double), cmp_double);
+    qsort(zs, s->nxz, sizeof(double), cmp_double);
+
+    // Отбор за два прохода: подсчёт, затем копирование
+    unsigned char *keep = (unsigned char *)xmalloc(pr->nyz);
+    size_t n = 0;
+    for (size_t i = 0; i < pr->nyz; i++) {
+        keep[i] = sorted_has(ys, s->nxy, pr->yz[i].y) && sorted_has(zs, s->nxz, pr->yz[i].z);
+        n += keep[i];
+    }
+    s->yz = (PointYZ *)xmalloc(n * sizeof(PointYZ));
+    for (size_t i = 0; i < pr->nyz; i++) {
+        if (keep[i]) s->yz[s->nyz++] = pr->yz[i];
+    }
+    free(keep);
+    free(ys);
+    free(zs);
+}
+
+static void share_send(const Share *s, int dest) {
+    DistHeader h = {s->nxy, s->nxz, s->nyz};
+    send_bytes(&h, sizeof(h), dest, TAG_HEADER);
+    send_bytes(s->xy, s->nxy * sizeof(PointXY), dest, TAG_DATA);
+    send_bytes(s->mxy, s->nxy * sizeof(uint32_t), dest, TAG_DATA);
+    send_bytes(s->xz, s->nxz * sizeof(PointXZ), dest, TAG_DATA);
+    send_bytes(s->mxz, s->nxz * sizeof(uint32_t), dest, TAG_DATA);
+    send_bytes(s->yz, s->nyz * sizeof(PointYZ), dest, TAG_DATA);
+}
+
+static void share_recv(Share *s) {
+    DistHeader h;
+    recv_bytes(&h, sizeof(h), 0, TAG_HEADER);
+    s->nxy = h.nxy;
+    s->nxz = h.nxz;
+    s->nyz = h.nyz;
+    s->xy = (PointXY *)xmalloc(s->nxy * sizeof(PointXY));
+    s->mxy = (uint32_t *)xmalloc(s->nxy * sizeof(uint32_t));
+    s->xz = (PointXZ *)xmalloc(s->nxz * sizeof(PointXZ));
+    s->mxz = (uint32_t *)xmalloc(s->nxz * sizeof(uint32_t));
+    s->yz = (PointYZ *)xmalloc(s->nyz * sizeof(PointYZ));
+    recv_bytes(s->xy, s->nxy * sizeof(PointXY), 0, TAG_DATA);
+    recv_bytes(s->mxy, s->nxy * sizeof(uint32_t), 0, TAG_DATA);
+    recv_bytes(s->xz, s->nxz * sizeof(PointXZ), 0, TAG_DATA);
+    recv_bytes(s->mxz, s->nxz * sizeof(uint32_t), 0, TAG_DATA);
+    recv_bytes(s->yz, s->nyz * sizeof(PointYZ), 0, TAG_DATA);
+}
+
+/* Копия доли процесса 0 — полные виды после раздачи освобождаются */
+static void share_own(Share *s) {
+    PointXY *xy = (PointXY *)xmalloc(s->nxy * sizeof(PointXY));
+    uint32_t *mxy = (uint32_t *)xmalloc(s->nxy * sizeof(uint32_t));
+    PointXZ *xz = (PointXZ *)xmalloc(s->nxz * sizeof(PointXZ));
+    uint32_t *mxz = (uint32_t *)xmalloc(s->nxz * sizeof(uint32_t));
+    memcpy(xy, s->xy, s->nxy * sizeof(PointXY));
+    memcpy(mxy, s->mxy, s->nxy * sizeof(uint32_t));
+    memcpy(xz, s->xz, s->nxz * sizeof(PointXZ));
+    memcpy(mxz, s->mxz, s->nxz * sizeof(uint32_t));
+    s->xy = xy;
+    s->mxy = mxy;
+    s->xz = xz;
+    s->mxz = mxz;
+}
+
+/* ----------------------------------------- */
+/* Соединение и отбор вершин своей доли */
+static void share_reconstruct(WorkerPool *pool, const Share *s, PointSet *local, size_t *found) {
+    *found = 0;
+    if (s->nxy == 0 || s->nxz == 0 || s->nyz == 0) return;
+    JoinResult cand;
+    if (!join_xyz(pool, NULL, s->xy, s->mxy, s->nxy, s->xz, s->mxz, s->nxz,
+                  s->yz, s->nyz, &cand)) {
+        fprintf(stderr, "Ошибка: недостаточно памяти для поиска 3D точек\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    *found = cand.found;
+    for (size_t c = 0; c < cand.n; c++) {
+        if (pointset_insert(local, cand.pts[c]) < 0) {
+            fprintf(stderr, "Ошибка: недостаточно памяти\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    join_result_free(&cand);
+}
+
+/* ----------------------------------------- */
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const char *input_file = NULL;
+    const char *out_file = NULL;
+    const char *format_name = NULL;
+    int nthreads = 1;
+    double eps = EPS_DEFAULT;
+    int quantize = 0;
+
+    // Аргументы разбирают все процессы: точность нужна каждому
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+            if (nthreads < 1) nthreads = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            eps = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quantize") == 0) {
+            quantize = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            format_name = argv[++i];
+        } else {
+            input_file = argv[i];
+        }
+    }
+
+    OutFormat out_format = out_file ? OUT_POINTS : OUT_LIST;
+    int args_ok = input_file != NULL &&
+                  (quantize ? geom_set_quantized(eps) : geom_set_eps(eps)) &&
+                  (!format_name || out_format_parse(format_name, &out_format));
+    if (!args_ok) {
+        if (rank == 0)
+            fprintf(stderr, "Использование: mpirun -np P %s [-t потоки] [-e eps] [-q] "
+                            "[-o файл] [-f формат] <input_file>\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    WorkerPool pool;
+    if (!pool_init(&pool, nthreads)) {
+        fprintf(stderr, "Ошибка создания пула потоков\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    StageTimes times;
+    timing_start(&times);
+    Projections pr;
+    WireIndex wires;
+    memset(&wires, 0, sizeof(wires));
+    int read_ok = 1;
+
+    // Чтение, индекс отрезков и сортировка — на процессе 0
+    if (rank == 0) {
+        printf("Процессов: %d, потоков на процесс: %d\n", size, pool.nthreads);
+        printf("Чтение файла %s...\n", input_file);
+        timing_begin(&times, STAGE_READ);
+        read_ok = parse_projections(&pool, NULL, input_file, &pr);
+        timing_end(&times, STAGE_READ);
+        if (read_ok && (pr.nxy == 0 || pr.nxz == 0 || pr.nyz == 0)) {
+            fprintf(stderr, "Ошибка: недостаточно данных в файле\n");
+            projections_free(&pr);
+            read_ok = 0;
+        } else if (!read_ok) {
+            fprintf(stderr, "Ошибка чтения файла\n");
+        }
+        if (read_ok) {
+            printf("  topView (X,Y): %zu точек\n", pr.nxy_raw);
+            printf("  frontView (X,Z): %zu точек\n", pr.nxz_raw);
+            printf("  profileView (Y,Z): %zu точек\n", pr.nyz_raw);
+            timing_begin(&times, STAGE_WIRES);
+            if (!wire_index_build(&wires, NULL, &pr)) {
+                fprintf(stderr, "Ошибка: недостаточно памяти для индекса отрезков\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            timing_end(&times, STAGE_WIRES);
+            timing_begin(&times, STAGE_SORT);
+            if (!sort_projections(&pool, pr.xy, pr.nxy, pr.xz, pr.nxz, pr.yz, pr.nyz) ||
+                !compact_projections(&pool, &pr)) {
+                fprintf(stderr, "Ошибка: недостаточно памяти для сортировки\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            timing_end(&times, STAGE_SORT);
+        }
+    }
+    MPI_Bcast(&read_ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!read_ok) {
+        pool_destroy(&pool);
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Раздача долей: кусок XY поровну, окна XZ и YZ по его диапазону
+    timing_begin(&times, STAGE_JOIN);
+    Share share;
+    memset(&share, 0, sizeof(share));
+    size_t total_xy = 0;
+    double lcs[VIEW_COUNT][2];
+    if (rank == 0) {
+        total_xy = pr.nxy;
+        memcpy(lcs, pr.lcs, sizeof(lcs));
+        for (int r = size - 1; r >= 0; r--) {
+            size_t b = pr.nxy * (size_t)r / (size_t)size;
+            size_t e = pr.nxy * (size_t)(r + 1) / (size_t)size;
+            share_select(&pr, b, e, &share);
+            if (r > 0) {
+                share_send(&share, r);
+                free(share.yz);
+            }
+        }
+        share_own(&share);
+        projections_free(&pr);
+    } else {
+        share_recv(&share);
+    }
+
+    double join_start = timing_now();
+    PointSet local;
+    if (!pointset_init(&local, 1024)) {
+        fprintf(stderr, "Ошибка: недостаточно памяти\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    size_t found;
+    share_reconstruct(&pool, &share, &local, &found);
+    DistStats st = {timing_now() - join_start, (double)share.nxy, (double)share.nxz,
+                    (double)share.nyz, (double)local.n, (double)found};
+    share_free(&share);
+    pool_destroy(&pool);
+
+    // Сбор вершин на процесс 0 по порядку процессов и общий отбор
+    DistStats *all = rank == 0 ? (DistStats *)xmalloc((size_t)size * sizeof(DistStats)) : NULL;
+    MPI_Gather(&st, (int)(sizeof(st) / sizeof(double)), MPI_DOUBLE,
+               all, (int)(sizeof(st) / sizeof(double)), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank != 0) {
+        uint64_t n = local.n;
+        send_bytes(&n, sizeof(n), 0, TAG_RESULT);
+        send_bytes(local.pts, local.n * sizeof(PointXYZ), 0, TAG_RESULT);
+        pointset_free(&local);
+        MPI_Finalize();
+        return 0;
+    }
+    timing_end(&times, STAGE_JOIN);
+
+    timing_begin(&times, STAGE_DEDUP);
+    PointSet unique;
+    if (!pointset_init(&unique, local.n * (size_t)size)) {
+        fprintf(stderr, "Ошибка: недостаточно памяти\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    size_t total_found = 0;
+    for (int r = 0; r < size; r++) {
+        uint64_t n = local.n;
+        PointXYZ *pts = local.pts;
+        if (r > 0) {
+            recv_bytes(&n, sizeof(n), r, TAG_RESULT);
+            pts = (PointXYZ *)xmalloc((size_t)n * sizeof(PointXYZ));
+            recv_bytes(pts, (size_t)n * sizeof(PointXYZ), r, TAG_RESULT);
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (pointset_insert(&unique, pts[i]) < 0) {
+                fprintf(stderr, "Ошибка: недостаточно памяти\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        if (r > 0) free(pts);
+        total_found += (size_t)all[r].found;
+    }
+    pointset_free(&local);
+    timing_end(&times, STAGE_DEDUP);
+
+    timing_begin(&times, STAGE_WIRES);
+    Edge3D *edges = NULL;
+    size_t nedges = 0;
+    if (!find_wires(&wires, NULL, unique.pts, unique.n, &edges, &nedges)) {
+        fprintf(stderr, "Ошибка: недостаточно памяти для поиска рёбер\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    timing_end(&times, STAGE_WIRES);
+    wire_index_free(&wires);
+    timing_finish(&times);
+
+    printf("\nДоли процессов (различных точек XY всего %zu):\n", total_xy);
+    for (int r = 0; r < size; r++) {
+        printf("  Процесс %d: XY %.0f, XZ %.0f, YZ %.0f, вершин %.0f, соединение %.3f с\n",
+               r, all[r].nxy, all[r].nxz, all[r].nyz, all[r].npts, all[r].join_sec);
+    }
+    free(all);
+
+    Writer w;
+    ResultData rd = {unique.pts, unique.n, edges, nedges,
+                     (const double (*)[2])lcs, &times};
+    int written = 0;
+    if (writer_open(&w, out_file)) {
+        written = write_result(&w, out_format, &rd);
+        written = writer_close(&w) && written;
+    }
+    if (!written)
+        fprintf(stderr, "Ошибка записи результата\n");
+    else if (out_file)
+        printf("Результат записан в %s\n", out_file);
+
+    printf("\n========================================================\n");
+    printf("РЕЗУЛЬТАТЫ:\n");
+    printf("  Всего совпадений: %zu\n", total_found);
+    printf("  Уникальных 3D точек: %zu\n", unique.n);
+    printf("  3D рёбер: %zu\n", nedges);
+    printf("  Точность сравнения: EPS = %g%s\n", EPS,
+           geom_step > 0.0 ? " (совпадение узлов сетки)" : "");
+    printf("========================================================\n");
+    timing_print_text(stdout, &times);
+
+    pointset_free(&unique);
+    free(edges);
+    MPI_Finalize();
+    return written ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "extsort.h"
+
+/* Буфер чтения прогона не меньше этого — иначе слияние упирается
+   в число обращений к диску, и прогоны сливаются в несколько проходов */
+#define EXT_READ_MIN (256 << 10)
+
+static int write_all(int fd, const void *p, size_t n, off_t off) {
+    const char *c = (const char *)p;
+    while (n > 0) {
+        ssize_t w = pwrite(fd, c, n, off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return 0;
+        c += w;
+        n -= (size_t)w;
+        off += w;
+    }
+    return 1;
+}
+
+static int read_all(int fd, void *p, size_t n, off_t off) {
+    char *c = (char *)p;
+    while (n > 0) {
+        ssize_t r = pread(fd, c, n, off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        c += r;
+        n -= (size_t)r;
+        off += r;
+    }
+    return 1;
+}
+
+/* Безымянный файл прогонов: удаляется сразу, место освобождается
+   при закрытии, в том числе при аварийном завершении */
+static int spill_file(void) {
+    const char *dir = getenv("TMPDIR");
+    if (!dir || !*dir) dir = "/tmp";
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/raschetka-XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    return fd;
+}
+
+int extsort_init(ExtSort *s, size_t rec, size_t budget,
+                 ExtCompare cmp, ExtSortRun sort_run) {
+    memset(s, 0, sizeof(*s));
+    s->rec = rec;
+    s->budget = budget;
+    s->cmp = cmp;
+    s->sort_run = sort_run;
+    s->fd = -1;
+    s->cap = budget / 2 / rec;
+    if (s->cap < 1) s->cap = 1;
+    s->buf = (char *)malloc(s->cap * rec);
+    s->ok = s->buf != NULL;
+    return s->ok;
+}
+
+static void readers_free(ExtSort *s, size_t k) {
+    if (s->readers) {
+        for (size_t i = 0; i < k; i++) free(s->readers[i].buf);
+    }
+    free(s->readers);
+    free(s->heap);
+    s->readers = NULL;
+    s->heap = NULL;
+    s->nheap = 0;
+}
+
+void extsort_free(ExtSort *s) {
+    readers_free(s, s->merging ? s->nruns : 0);
+    free(s->buf);
+    free(s->runs);
+    if (s->fd >= 0) close(s->fd);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+}
+
+static int sort_buffer(ExtSort *s) {
+    if (s->sort_run) return s->sort_run(s->buf, s->n);
+    qsort(s->buf, s->n, s->rec, s->cmp);
+    return 1;
+}
+
+static int push_run(ExtSort *s, off_t off, size_t n) {
+    if (s->nruns == s->runs_cap) {
+        size_t cap = s->runs_cap ? s->runs_cap * 2 : 16;
+        ExtRun *resized = (ExtRun *)realloc(s->runs, cap * sizeof(ExtRun));
+        if (!resized) return 0;
+        s->runs = resized;
+        s->runs_cap = cap;
+    }
+    s->runs[s->nruns++] = (ExtRun){off, n};
+    s->runs_made++;
+    return 1;
+}
+
+/* Буфер сортируется и дописывается в файл очередным прогоном */
+static int spill_run(ExtSort *s) {
+    if (s->fd < 0 && (s->fd = spill_file()) < 0) return 0;
+    if (!sort_buffer(s)) return 0;
+    size_t bytes = s->n * s->rec;
+    if (!write_all(s->fd, s->buf, bytes, s->file_len)) return 0;
+    if (!push_run(s, s->file_len, s->n)) return 0;
+    s->file_len += (off_t)bytes;
+    s->spilled += bytes;
+    s->n = 0;
+    return 1;
+}
+
+int extsort_add(ExtSort *s, const void *rec) {
+    if (!s->ok) return 0;
+    if (s->n == s->cap && !spill_run(s)) {
+        s->ok = 0;
+        return 0;
+    }
+    memcpy(s->buf + s->n * s->rec, rec, s->rec);
+    s->n++;
+    s->total++;
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* k-путевое слияние прогонов runs[first, first + k) */
+static inline const void *reader_head(const ExtSort *s, size_t r) {
+    const ExtReader *rd = &s->readers[r];
+    return rd->buf + rd->pos * s->rec;
+}
+
+/* Меньшая запись, при равенстве — более ранний прогон */
+static inline int heap_less(const ExtSort *s, size_t a, size_t b) {
+    int c = s->cmp(reader_head(s, a), reader_head(s, b));
+    return c < 0 || (c == 0 && a < b);
+}
+
+static void sift_down(ExtSort *s, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < s->nheap && heap_less(s, s->heap[l], s->heap[m])) m = l;
+        if (l + 1 < s->nheap && heap_less(s, s->heap[l + 1], s->heap[m])) m = l + 1;
+        if (m == i) return;
+        size_t t = s->heap[i];
+        s->heap[i] = s->heap[m];
+        s->heap[m] = t;
+        i = m;
+    }
+}
+
+static int reader_fill(ExtSort *s, ExtReader *rd) {
+    size_t n = rd->left < rd->cap ? rd->left : rd->cap;
+    if (!read_all(s->fd, rd->buf, n * s->rec, rd->off)) return 0;
+    rd->off += (off_t)(n * s->rec);
+    rd->left -= n;
+    rd->n = n;
+    rd->pos = 0;
+    s->read_back += n * s->rec;
+    return 1;
+}
+
+static int merge_open(ExtSort *s, size_t first, size_t k, size_t cap) {
+    s->readers = (ExtReader *)calloc(k, sizeof(ExtReader));
+    s->heap = (size_t *)malloc(k * sizeof(size_t));
+    if (!s->readers || !s->heap) return 0;
+    for (size_t i = 0; i < k; i++) {
+        ExtReader *rd = &s->readers[i];
+        rd->cap = cap;
+        rd->off = s->runs[first + i].off;
+        rd->left = s->runs[first + i].n;
+        rd->buf = (char *)malloc(cap * s->rec);
+        if (!rd->buf || !reader_fill(s, rd)) return 0;
+        if (rd->n > 0) s->heap[s->nheap++] = i;
+    }
+    for (size_t i = s->nheap; i-- > 0;) sift_down(s, i);
+    return 1;
+}
+
+/* Наименьшая запись слияния в rec; 0 — слияние закончено или ошибка */
+static int merge_pop(ExtSort *s, void *rec) {
+    if (s->nheap == 0) return 0;
+    size_t r = s->heap[0];
+    ExtReader *rd = &s->readers[r];
+    memcpy(rec, rd->buf + rd->pos * s->rec, s->rec);
+    if (++rd->pos == rd->n) {
+        if (rd->left > 0) {
+            if (!reader_fill(s, rd)) {
+                s->ok = 0;
+                return 0;
+            }
+        } else {
+            s->heap[0] = s->heap[--s->nheap];
+        }
+    }
+    if (s->nheap > 0) sift_down(s, 0);
+    return 1;
+}
+
+/* Буферов чтения по EXT_READ_MIN на весь бюджет */
+static size_t merge_fanin(const ExtSort *s) {
+    size_t k = s->budget / EXT_READ_MIN;
+    return k < 2 ? 2 : k;
+}
+
+/* Промежуточный проход: группы по fanin соседних прогонов сливаются
+   в новый файл, порядок групп сохраняется */
+static int merge_pass(ExtSort *s, size_t fanin) {
+    int out = spill_file();
+    if (out < 0) return 0;
+    size_t cap = s->budget / (fanin + 1) / s->rec;
+    if (cap < 1) cap = 1;
+    char *obuf = (char *)malloc(cap * s->rec);
+    ExtRun *runs = (ExtRun *)malloc(((s->nruns + fanin - 1) / fanin) * sizeof(ExtRun));
+    int ok = obuf && runs;
+    size_t nout = 0;
+    off_t len = 0;
+
+    for (size_t first = 0; ok && first < s->nruns; first += fanin) {
+        size_t k = s->nruns - first < fanin ? s->nruns - first : fanin;
+        ok = merge_open(s, first, k, cap);
+        size_t n = 0, total = 0;
+        off_t start = len;
+        while (ok && merge_pop(s, obuf + n * s->rec)) {
+            if (++n == cap) {
+                ok = write_all(out, obuf, n * s->rec, len);
+                len += (off_t)(n * s->rec);
+                s->spilled += n * s->rec;
+                total += n;
+                n = 0;
+            }
+        }
+        if (ok && n > 0) {
+            ok = write_all(out, obuf, n * s->rec, len);
+            len += (off_t)(n * s->rec);
+            s->spilled += n * s->rec;
+            total += n;
+        }
+        ok = ok && s->ok;
+        readers_free(s, k);
+        runs[nout++] = (ExtRun){start, total};
+    }
+
+    free(obuf);
+    if (!ok) {
+        free(runs);
+        close(out);
+        return 0;
+    }
+    close(s->fd);
+    free(s->runs);
+    s->fd = out;
+    s->file_len = len;
+    s->runs = runs;
+    s->nruns = s->runs_cap = nout;
+    s->runs_made += nout;
+    s->passes++;
+    return 1;
+}
+
+int extsort_finish(ExtSort *s) {
+    if (!s->ok) return 0;
+    if (s->nruns == 0) {
+        // Всё уместилось в память
+        s->ok = sort_buffer(s);
+        s->pos = 0;
+        return s->ok;
+    }
+    if (s->n > 0 && !spill_run(s)) {
+        s->ok = 0;
+        return 0;
+    }
+    free(s->buf);
+    s->buf = NULL;
+
+    size_t fanin = merge_fanin(s);
+    while (s->nruns > fanin) {
+        if (!merge_pass(s, fanin)) {
+            s->ok = 0;
+            return 0;
+        }
+    }
+    size_t cap = s->budget / s->nruns / s->rec;
+    if (cap < 1) cap = 1;
+    s->merging = 1;
+    s->passes++;
+    if (!merge_open(s, 0, s->nruns, cap)) s->ok = 0;
+    return s->ok;
+}
+
+int extsort_next(ExtSort *s, void *rec) {
+    if (!s->ok) return 0;
+    if (!s->merging) {
+        if (s->pos == s->n) return 0;
+        memcpy(rec, s->buf + s->pos * s->rec, s->rec);
+        s->pos++;
+        return 1;
+    }
+    return merge_pop(s, rec);
+}
@@ -0,0 +1,85 @@
+#ifndef EXTSORT_H
+#define EXTSORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Внешняя сортировка записей фиксированного размера в пределах
+   бюджета памяти. Записи копятся в буфере; полный буфер сортируется
+   и сбрасывается на диск прогоном. После extsort_finish прогоны
+   сливаются k-путевым слиянием: если прогонов больше, чем помещается
+   буферов чтения, сначала идут промежуточные проходы слияния.
+   Если все записи уместились в буфер, диск не трогается.
+   Порядок устойчивый: прогоны создаются и сливаются по порядку
+   поступления, при равенстве cmp раньше идёт более ранний прогон,
+   а внутри прогона порядок задаёт sort_run.
+   Прогоны лежат в безымянном файле (удаляется сразу после создания)
+   в каталоге $TMPDIR или /tmp */
+
+typedef int (*ExtCompare)(const void *a, const void *b);
+/* Сортировка буфера из n записей; 1 — успех */
+typedef int (*ExtSortRun)(void *a, size_t n);
+
+/* Прогон — непрерывный участок файла */
+typedef struct {
+    off_t off;
+    size_t n;
+} ExtRun;
+
+/* Буфер чтения одного прогона при слиянии */
+typedef struct {
+    char *buf;
+    size_t cap, n, pos;    // записей в буфере и текущая
+    off_t off;             // следующая непрочитанная запись прогона
+    size_t left;           // записей прогона ещё на диске
+} ExtReader;
+
+typedef struct {
+    size_t rec;            // размер записи, байт
+    size_t budget;
+    ExtCompare cmp;
+    ExtSortRun sort_run;   // NULL — qsort по cmp (cmp должен быть строгим)
+
+    char *buf;             // буфер прогона
+    size_t cap, n;
+    size_t total;          // всего записей
+
+    int fd;                // файл прогонов, -1 — ещё не создан
+    off_t file_len;
+    ExtRun *runs;
+    size_t nruns, runs_cap;
+
+    // Слияние
+    ExtReader *readers;
+    size_t *heap;          // номера читателей, вершина — наименьшая запись
+    size_t nheap;
+    size_t pos;            // чтение буфера, если прогонов нет
+    int merging;
+
+    uint64_t spilled;      // записано на диск, байт (с промежуточными проходами)
+    uint64_t read_back;    // прочитано с диска, байт
+    size_t runs_made;      // прогонов всего, с промежуточными
+    size_t passes;         // проходов слияния через диск
+    int ok;
+} ExtSort;
+
+/* budget — память на буферы этой сортировки, байт. Буфер прогона —
+   половина бюджета: вторая половина остаётся sort_run на временный
+   массив (поразрядная сортировка). Возвращает 1 при успехе */
+int extsort_init(ExtSort *s, size_t rec, size_t budget,
+                 ExtCompare cmp, ExtSortRun sort_run);
+void extsort_free(ExtSort *s);
+
+/* Добавление записи. Возвращает 0 при ошибке записи на диск или нехватке памяти */
+int extsort_add(ExtSort *s, const void *rec);
+
+/* Конец добавления: последний прогон и промежуточные слияния.
+   Возвращает 1 при успехе */
+int extsort_finish(ExtSort *s);
+
+/* Следующая запись по порядку в rec. Возвращает 1 — запись есть,
+   0 — записи кончились или ошибка (тогда s->ok == 0) */
+int extsort_next(ExtSort *s, void *rec);
+
+#endif
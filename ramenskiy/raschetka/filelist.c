@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "filelist.h"
+
+int file_list_add(FileList *l, const char *name) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 8;
+        char **resized = (char **)realloc(l->names, cap * sizeof(char *));
+        if (!resized) return 0;
+        l->names = resized;
+        l->cap = cap;
+    }
+    l->names[l->n] = strdup(name);
+    return l->names[l->n++] != NULL;
+}
+
+void file_list_free(FileList *l) {
+    for (size_t i = 0; i < l->n; i++) free(l->names[i]);
+    free(l->names);
+    memset(l, 0, sizeof(*l));
+}
+
+static int cmp_names(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int has_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name), sl = strlen(suffix);
+    return len >= sl && strcmp(name + len - sl, suffix) == 0;
+}
+
+int file_list_scan_dir(FileList *l, const char *dir, const char *suffix) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return 0;
+    }
+    size_t first = l->n;
+    int ok = 1;
+    struct dirent *e;
+    char path[4096];
+    while (ok && (e = readdir(d)) != NULL) {
+        if (!has_suffix(e->d_name, suffix)) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        ok = file_list_add(l, path);
+    }
+    closedir(d);
+    qsort(l->names + first, l->n - first, sizeof(char *), cmp_names);
+    return ok;
+}
+
+int file_list_read(FileList *l, const char *list_file) {
+    FILE *f = fopen(list_file, "r");
+    if (!f) {
+        perror(list_file);
+        return 0;
+    }
+    char line[4096];
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        ok = file_list_add(l, line);
+    }
+    fclose(f);
+    return ok;
+}
+
+int file_list_from_path(FileList *l, const char *path, const char *suffix) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return 0;
+    }
+    return S_ISDIR(st.st_mode) ? file_list_scan_dir(l, path, suffix)
+                               : file_list_read(l, path);
+}
@@ -0,0 +1,25 @@
+#ifndef FILELIST_H
+#define FILELIST_H
+
+#include <stddef.h>
+
+/* Список путей к чертежам */
+typedef struct {
+    char **names;
+    size_t n, cap;
+} FileList;
+
+int file_list_add(FileList *l, const char *name);
+void file_list_free(FileList *l);
+
+/* Файлы каталога с именем, оканчивающимся на suffix, в порядке имён */
+int file_list_scan_dir(FileList *l, const char *dir, const char *suffix);
+
+/* Файл-список: путь на строку, пустые строки и строки с '#' пропускаются.
+   Относительные пути берутся от текущего каталога */
+int file_list_read(FileList *l, const char *list_file);
+
+/* Каталог сканируется по suffix, обычный файл считается файлом-списком */
+int file_list_from_path(FileList *l, const char *path, const char *suffix);
+
+#endif
@@ -0,0 +1,495 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+/* Генератор синтетических чертежей для проверки масштабирования.
+   Пишет "база 2D.txt" (три вида в формате чертежей: отрезки — пары
+   точек подряд, десятичная запятая, строки CRLF) и "база 3D.txt" —
+   эталонные вершины в секции "3D points".
+   Координаты хранятся в тысячных долях (целыми), поэтому запись в оба
+   файла точная и совпадает с тем, что прочитает восстановление.
+   Вершины и рёбра вычисляются по номеру, а не хранятся, — память
+   не зависит от размера модели (кроме эталона snapped, см. snapped_ghosts) */
+
+enum {
+    SHAPE_LATTICE,      // решётка NX x NY x NZ, рёбра вдоль осей
+    SHAPE_PRISM,        // N-угольная призма из M слоёв
+    SHAPE_RANDOM,       // случайный каркас без совпадающих координат
+    SHAPE_SNAPPED       // случайный каркас в узлах решётки: координаты общие
+};
+
+typedef struct {
+    int shape;
+    size_t n[3];          // параметры фигуры
+    long long step;       // шаг координат, тысячные
+    uint64_t seed;
+    // Случайный каркас: x, y, z вершины i — (a*i + b) mod n, разные
+    // для разных вершин, так что "призрачных" точек не возникает
+    uint64_t mul[3], add[3];
+    // Каркас в узлах: вершина i — узел i + N*r решётки side x side x side,
+    // r — случайное из [0, span): остатки по N разные, значит, и узлы
+    uint64_t side, span;
+    long long radius;     // радиус призмы, тысячные
+} Model;
+
+typedef struct {
+    size_t a, b;
+} EdgeIdx;
+
+/* ----------------------------------------- */
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static size_t model_vertices(const Model *m) {
+    switch (m->shape) {
+    case SHAPE_LATTICE: return m->n[0] * m->n[1] * m->n[2];
+    case SHAPE_PRISM:   return m->n[0] * m->n[1];
+    default:            return m->n[0];
+    }
+}
+
+/* Число номеров рёбер; часть номеров может не давать ребра */
+static size_t model_edge_slots(const Model *m) {
+    switch (m->shape) {
+    case SHAPE_LATTICE: return 3 * model_vertices(m);
+    case SHAPE_PRISM:   return 2 * model_vertices(m);
+    default:            return m->n[0] * m->n[1];
+    }
+}
+
+static void model_vertex(const Model *m, size_t i, long long v[3]) {
+    if (m->shape == SHAPE_LATTICE) {
+        v[0] = (long long)(i % m->n[0]) * m->step;
+        v[1] = (long long)(i / m->n[0] % m->n[1]) * m->step;
+        v[2] = (long long)(i / (m->n[0] * m->n[1])) * m->step;
+    } else if (m->shape == SHAPE_PRISM) {
+        size_t j = i % m->n[0], layer = i / m->n[0];
+        double angle = 2.0 * M_PI * (double)j / (double)m->n[0];
+        v[0] = llround((double)m->radius * cos(angle));
+        v[1] = llround((double)m->radius * sin(angle));
+        v[2] = (long long)layer * m->step;
+    } else if (m->shape == SHAPE_SNAPPED) {
+        uint64_t c = i + m->n[0] * (splitmix64(m->seed ^ splitmix64(i)) % m->span);
+        v[0] = (long long)(c % m->side) * m->step;
+        v[1] = (long long)(c / m->side % m->side) * m->step;
+        v[2] = (long long)(c / (m->side * m->side)) * m->step;
+    } else {
+        for (int a = 0; a < 3; a++)
+            v[a] = (long long)((m->mul[a] * i + m->add[a]) % m->n[0]) * m->step;
+    }
+}
+
+/* Ребро с номером k; 0 — номер пуст */
+static int model_edge(const Model *m, size_t k, EdgeIdx *e) {
+    if (m->shape == SHAPE_LATTICE) {
+        size_t i = k / 3;
+        int axis = (int)(k % 3);
+        size_t c[3] = {i % m->n[0], i / m->n[0] % m->n[1], i / (m->n[0] * m->n[1])};
+        if (c[axis] + 1 >= m->n[axis]) return 0;
+        size_t stride = axis == 0 ? 1 : axis == 1 ? m->n[0] : m->n[0] * m->n[1];
+        *e = (EdgeIdx){i, i + stride};
+        return 1;
+    }
+    if (m->shape == SHAPE_PRISM) {
+        size_t i = k / 2;
+        size_t j = i % m->n[0], layer = i / m->n[0];
+        if (k % 2 == 0) {
+            // Сторона многоугольника в слое
+            *e = (EdgeIdx){i, layer * m->n[0] + (j + 1) % m->n[0]};
+            return 1;
+        }
+        if (layer + 1 >= m->n[1]) return 0;
+        *e = (EdgeIdx){i, i + m->n[0]};
+        return 1;
+    }
+
+    // Случайный каркас: цепочка 0-1-2-... связывает все вершины,
+    // остальные рёбра — к случайным вершинам
+    size_t i = k / m->n[1], r = k % m->n[1];
+    if (r == 0) {
+        if (i + 1 >= m->n[0]) return 0;
+        *e = (EdgeIdx){i, i + 1};
+        return 1;
+    }
+    size_t j = (size_t)(splitmix64(m->seed ^ (uint64_t)k) % m->n[0]);
+    if (j == i) return 0;
+    *e = (EdgeIdx){i, j};
+    return 1;
+}
+
+static int model_init(Model *m) {
+    if (m->step <= 0) return 0;
+    for (int a = 0; a < 3; a++) {
+        if (m->n[a] == 0) return 0;
+    }
+    if (m->shape == SHAPE_PRISM) {
+        if (m->n[0] < 3) return 0;
+        // Сторона многоугольника не меньше шага: соседние вершины
+        // не сливаются с точностью EPS
+        m->radius = (long long)ceil((double)m->step / (2.0 * sin(M_PI / (double)m->n[0])));
+    } else if (m->shape == SHAPE_SNAPPED) {
+        // Сторона ~2 N^(2/3): на значение координаты приходится ~N^(1/3)/2
+        // вершин, а призрачных узлов (snapped_ghosts) ~N/8
+        uint64_t n = m->n[0];
+        m->side = (uint64_t)ceil(2.0 * pow((double)n, 2.0 / 3.0));
+        if (m->side < 2) m->side = 2;
+        if (m->side > (1u << 20)) return 0;
+        m->span = m->side * m->side * m->side / n;
+    } else if (m->shape == SHAPE_RANDOM) {
+        uint64_t n = m->n[0];
+        for (int a = 0; a < 3; a++) {
+            uint64_t mul = n > 1 ? splitmix64(m->seed + 2 * (uint64_t)a) % n : 1;
+            while (n > 1 && (mul == 0 || gcd_u64(mul, n) != 1)) mul = (mul + 1) % n;
+            m->mul[a] = mul ? mul : 1;
+            m->add[a] = splitmix64(m->seed + 2 * (uint64_t)a + 1) % n;
+        }
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Оси вида: frontView (x, z), profileView (y, z), topView (x, y) */
+static const char *view_names[3] = {"frontView", "profileView", "topView"};
+static const int view_axes[3][2] = {{0, 2}, {1, 2}, {0, 1}};
+
+/* Призрачные узлы каркаса snapped: не вершины, но все три проекции
+   совпадают с проекциями вершин. Восстановление по видам не отличает
+   их от вершин, поэтому они входят в эталон. Проекции — ключи a*side + b
+   в трёх отсортированных массивах по N чисел; для каждого x перебираются
+   пары (x, y) вида сверху и (x, z) вида спереди, (y, z) ищется в виде
+   сбоку. Узлы выдаются номерами (z*side + y)*side + x, через malloc */
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t lower_u64(const uint64_t *a, size_t n, uint64_t key) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static size_t sort_unique(uint64_t *a, size_t n) {
+    qsort(a, n, sizeof(uint64_t), cmp_u64);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (k == 0 || a[i] != a[k - 1]) a[k++] = a[i];
+    }
+    return k;
+}
+
+static int snapped_ghosts(const Model *m, uint64_t **ghosts, size_t *nghosts) {
+    size_t n = model_vertices(m);
+    uint64_t side = m->side;
+    uint64_t *proj[3], *nodes = (uint64_t *)malloc(n * sizeof(uint64_t));
+    size_t np[3];
+    uint64_t *out = NULL;
+    size_t cnt = 0, cap = 0;
+    int ok = nodes != NULL;
+    for (int view = 0; view < 3; view++) {
+        proj[view] = (uint64_t *)malloc(n * sizeof(uint64_t));
+        ok = ok && proj[view];
+    }
+    for (size_t i = 0; i < n && ok; i++) {
+        long long v[3];
+        model_vertex(m, i, v);
+        uint64_t c[3];
+        for (int a = 0; a < 3; a++) c[a] = (uint64_t)(v[a] / m->step);
+        for (int view = 0; view < 3; view++)
+            proj[view][i] = c[view_axes[view][0]] * side + c[view_axes[view][1]];
+        nodes[i] = (c[2] * side + c[1]) * side + c[0];
+    }
+    if (ok) {
+        for (int view = 0; view < 3; view++) np[view] = sort_unique(proj[view], n);
+        sort_unique(nodes, n);
+    }
+
+    const uint64_t *front = proj[0], *profile = proj[1], *top = proj[2];
+    for (uint64_t x = 0; x < side && ok; x++) {
+        size_t t0 = lower_u64(top, np[2], x * side), t1 = lower_u64(top, np[2], (x + 1) * side);
+        size_t f0 = lower_u64(front, np[0], x * side), f1 = lower_u64(front, np[0], (x + 1) * side);
+        for (size_t t = t0; t < t1 && ok; t++) {
+            uint64_t y = top[t] % side;
+            for (size_t f = f0; f < f1; f++) {
+                uint64_t z = front[f] % side, key = y * side + z;
+                size_t k = lower_u64(profile, np[1], key);
+                if (k == np[1] || profile[k] != key) continue;
+                uint64_t node = (z * side + y) * side + x;
+                k = lower_u64(nodes, n, node);
+                if (k < n && nodes[k] == node) continue;
+                if (cnt == cap) {
+                    cap = cap ? cap * 2 : 1024;
+                    uint64_t *resized = (uint64_t *)realloc(out, cap * sizeof(uint64_t));
+                    if (!resized) {
+                        ok = 0;
+                        break;
+                    }
+                    out = resized;
+                }
+                out[cnt++] = node;
+            }
+        }
+    }
+
+    for (int view = 0; view < 3; view++) free(proj[view]);
+    free(nodes);
+    if (!ok) {
+        free(out);
+        return 0;
+    }
+    *ghosts = out;
+    *nghosts = cnt;
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Буферизованная запись */
+typedef struct {
+    FILE *f;
+    char buf[1 << 16];
+    size_t len;
+    int ok;
+} Out;
+
+static void out_flush(Out *o) {
+    if (o->len && fwrite(o->buf, 1, o->len, o->f) != o->len) o->ok = 0;
+    o->len = 0;
+}
+
+static void out_str(Out *o, const char *s) {
+    size_t n = strlen(s);
+    if (o->len + n > sizeof(o->buf)) out_flush(o);
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+}
+
+/* Число в тысячных как "-12,345" и перевод строки */
+static void out_milli(Out *o, long long v) {
+    char tmp[32];
+    int p = sizeof(tmp);
+    tmp[--p] = '\n';
+    tmp[--p] = '\r';
+    unsigned long long u = v < 0 ? (unsigned long long)(-v) : (unsigned long long)v;
+    for (int d = 0; d < 3; d++) {
+        tmp[--p] = (char)('0' + u % 10);
+        u /= 10;
+    }
+    tmp[--p] = ',';
+    do {
+        tmp[--p] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) tmp[--p] = '-';
+
+    size_t n = sizeof(tmp) - (size_t)p;
+    if (o->len + n > sizeof(o->buf)) out_flush(o);
+    memcpy(o->buf + o->len, tmp + p, n);
+    o->len += n;
+}
+
+static int out_open(Out *o, const char *name) {
+    o->f = fopen(name, "wb");
+    o->len = 0;
+    o->ok = o->f != NULL;
+    if (!o->f) perror(name);
+    return o->ok;
+}
+
+static int out_close(Out *o) {
+    out_flush(o);
+    if (fclose(o->f) != 0) o->ok = 0;
+    return o->ok;
+}
+
+static void write_header_view(Out *o, int view) {
+    out_str(o, view_names[view]);
+    out_str(o, "\r\nlcsX= 0,00000\r\nlcsY= 0,00000\r\n");
+}
+
+static void write_tail(Out *o, size_t nverts) {
+    char line[64];
+    out_str(o, "3D edges\r\n");
+    snprintf(line, sizeof(line), "3d %zu\r\n", nverts);
+    out_str(o, line);
+    out_str(o, "Algorithm (sec)\r\n0.0\r\nRead plot (sec)\r\n0.0\r\n"
+               "3D points (sec)\r\n0.0\r\nGet wires (sec)\r\n0.0\r\n");
+}
+
+/* Чертёж: каждое ребро — отрезок в каждом виде; ntruth — число точек
+   эталона для строки "3d" */
+static int write_drawing(const Model *m, const char *name, size_t ntruth, size_t *nsegs) {
+    Out *o = (Out *)malloc(sizeof(Out));
+    if (!o || !out_open(o, name)) {
+        free(o);
+        return 0;
+    }
+    size_t slots = model_edge_slots(m);
+    *nsegs = 0;
+
+    out_str(o, "start\r\n");
+    for (int view = 0; view < 3 && o->ok; view++) {
+        write_header_view(o, view);
+        for (size_t k = 0; k < slots; k++) {
+            EdgeIdx e;
+            if (!model_edge(m, k, &e)) continue;
+            long long a[3], b[3];
+            model_vertex(m, e.a, a);
+            model_vertex(m, e.b, b);
+            out_milli(o, a[view_axes[view][0]]);
+            out_milli(o, a[view_axes[view][1]]);
+            out_milli(o, b[view_axes[view][0]]);
+            out_milli(o, b[view_axes[view][1]]);
+            if (view == 0) (*nsegs)++;
+        }
+    }
+    out_str(o, "3D points\r\n");
+    write_tail(o, ntruth);
+
+    int ok = out_close(o);
+    free(o);
+    return ok;
+}
+
+/* Эталон: все вершины модели по одному разу, затем призрачные узлы */
+static int write_truth(const Model *m, const char *name,
+                       const uint64_t *ghosts, size_t nghosts) {
+    Out *o = (Out *)malloc(sizeof(Out));
+    if (!o || !out_open(o, name)) {
+        free(o);
+        return 0;
+    }
+    size_t n = model_vertices(m);
+
+    out_str(o, "start\r\n");
+    for (int view = 0; view < 3; view++) write_header_view(o, view);
+    out_str(o, "3D points\r\n");
+    for (size_t i = 0; i < n && o->ok; i++) {
+        long long v[3];
+        model_vertex(m, i, v);
+        out_milli(o, v[0]);
+        out_milli(o, v[1]);
+        out_milli(o, v[2]);
+    }
+    for (size_t k = 0; k < nghosts && o->ok; k++) {
+        uint64_t c = ghosts[k];
+        out_milli(o, (long long)(c % m->side) * m->step);
+        out_milli(o, (long long)(c / m->side % m->side) * m->step);
+        out_milli(o, (long long)(c / (m->side * m->side)) * m->step);
+    }
+    write_tail(o, n + nghosts);
+
+    int ok = out_close(o);
+    free(o);
+    return ok;
+}
+
+/* ----------------------------------------- */
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [-o база] [-s зерно] [-h шаг] фигура\n"
+            "  lattice NX NY NZ   решётка, рёбра вдоль осей\n"
+            "  prism N M          N-угольная призма из M слоёв\n"
+            "  random N [K]       N вершин, K рёбер на вершину (по умолчанию 3)\n"
+            "  snapped N [K]      то же в узлах решётки: вершины делят значения x, y, z\n"
+            "Пишет \"база 2D.txt\" и \"база 3D.txt\" (база по умолчанию — synthetic)\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *base = "synthetic";
+    Model m;
+    memset(&m, 0, sizeof(m));
+    m.step = 1000;
+    m.seed = 1;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-o") == 0) {
+            base = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0) {
+            m.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-h") == 0) {
+            m.step = llround(atof(argv[++i]) * 1000.0);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *shape = argv[i++];
+    int nargs = argc - i;
+    m.n[0] = m.n[1] = m.n[2] = 1;
+    if (strcmp(shape, "lattice") == 0 && nargs == 3) {
+        m.shape = SHAPE_LATTICE;
+        for (int a = 0; a < 3; a++) m.n[a] = strtoull(argv[i + a], NULL, 10);
+    } else if (strcmp(shape, "prism") == 0 && nargs == 2) {
+        m.shape = SHAPE_PRISM;
+        m.n[0] = strtoull(argv[i], NULL, 10);
+        m.n[1] = strtoull(argv[i + 1], NULL, 10);
+    } else if ((strcmp(shape, "random") == 0 || strcmp(shape, "snapped") == 0) &&
+               (nargs == 1 || nargs == 2)) {
+        m.shape = strcmp(shape, "random") == 0 ? SHAPE_RANDOM : SHAPE_SNAPPED;
+        m.n[0] = strtoull(argv[i], NULL, 10);
+        m.n[1] = nargs == 2 ? strtoull(argv[i + 1], NULL, 10) : 3;
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!model_init(&m)) {
+        fprintf(stderr, "Ошибка: неверные параметры фигуры\n");
+        return 1;
+    }
+
+    char name2d[4096], name3d[4096];
+    snprintf(name2d, sizeof(name2d), "%s 2D.txt", base);
+    snprintf(name3d, sizeof(name3d), "%s 3D.txt", base);
+
+    uint64_t *ghosts = NULL;
+    size_t nghosts = 0;
+    if (m.shape == SHAPE_SNAPPED && !snapped_ghosts(&m, &ghosts, &nghosts)) {
+        fprintf(stderr, "Ошибка: недостаточно памяти\n");
+        return 1;
+    }
+    size_t nsegs, ntruth = model_vertices(&m) + nghosts;
+    int ok = write_drawing(&m, name2d, ntruth, &nsegs) &&
+             write_truth(&m, name3d, ghosts, nghosts);
+    free(ghosts);
+    if (!ok) {
+        fprintf(stderr, "Ошибка записи\n");
+        return 1;
+    }
+    printf("%s: %zu отрезков в каждом виде\n", name2d, nsegs);
+    printf("%s: %zu вершин", name3d, ntruth);
+    if (m.shape == SHAPE_SNAPPED)
+        printf(" (из них призрачных узлов %zu, решётка %llu^3)", nghosts,
+               (unsigned long long)m.side);
+    printf("\n");
+    return 0;
+}
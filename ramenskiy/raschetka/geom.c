@@ -0,0 +1,18 @@
+#include "geom.h"
+
+double geom_eps = EPS_DEFAULT;
+double geom_step = 0.0;
+
+int geom_set_eps(double eps) {
+    if (!(eps > 0.0) || !isfinite(eps)) return 0;
+    geom_eps = eps;
+    geom_step = 0.0;
+    return 1;
+}
+
+int geom_set_quantized(double step) {
+    if (!(step > 0.0) || !isfinite(step)) return 0;
+    geom_step = step;
+    geom_eps = step / 2;
+    return 1;
+}
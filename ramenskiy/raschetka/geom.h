@@ -0,0 +1,94 @@
+#ifndef GEOM_H
+#define GEOM_H
+
+#include <math.h>
+#include <stddef.h>
+
+/* Точность сравнения координат задаётся при запуске (geom_set_eps),
+   EPS читает текущее значение. Значение общее для процесса и меняется,
+   только пока восстановление не идёт (библиотека разводит такие запуски
+   сама, см. raschetka.c) */
+#define EPS_DEFAULT 0.001
+#define EPS geom_eps
+
+extern double geom_eps;
+extern double geom_step;   // шаг квантования, 0 — координаты как в файле
+
+/* Ячейка сетки берётся чуть больше EPS: тогда две координаты, совпадающие
+   с точностью EPS, всегда лежат в одной или соседних ячейках, даже с учётом
+   ошибок округления при делении */
+#define GRID_SLACK 1e-6
+
+/* Координата считается лежащей на границе ячеек квантования, если до
+   середины между соседними узлами меньше этой доли шага */
+#define QUANT_MARGIN 1e-6
+
+/* Виды чертежа в порядке секций файла */
+enum {
+    VIEW_FRONT = 0,    // frontView   (X, Z)
+    VIEW_PROFILE = 1,  // profileView (Y, Z)
+    VIEW_TOP = 2,      // topView     (X, Y)
+    VIEW_COUNT = 3
+};
+
+/* Структуры точек для каждой проекции */
+typedef struct {
+    double x, y;  // для XY (topView)
+} PointXY;
+
+typedef struct {
+    double x, z;  // для XZ (frontView)
+} PointXZ;
+
+typedef struct {
+    double y, z;  // для YZ (profileView)
+} PointYZ;
+
+typedef struct {
+    double x, y, z;
+} PointXYZ;
+
+/* Проверка двух чисел на равенство с EPS */
+static inline int approx_eq(double a, double b) {
+    return fabs(a - b) <= EPS;
+}
+
+/* Номер ячейки сетки по одной координате */
+static inline long long grid_key(double v, double inv_cell) {
+    return (long long)floor(v * inv_cell);
+}
+
+static inline double grid_inv_cell(void) {
+    return 1.0 / (EPS * (1.0 + GRID_SLACK));
+}
+
+/* Сколько соседних ячеек сетки просматривать вокруг своей: после
+   квантования равные с точностью EPS координаты равны точно и лежат
+   в одной ячейке */
+static inline long long grid_reach(void) {
+    return geom_step > 0.0 ? 0 : 1;
+}
+
+/* Обычный режим: координаты сравниваются с точностью eps.
+   Возвращает 0, если eps не положительное конечное число */
+int geom_set_eps(double eps);
+
+/* Режим квантования: при чтении каждая координата заменяется ближайшим
+   узлом сетки q * step (q — целое, середина между узлами округляется от
+   нуля), после чего координаты совпадают, только если совпали их узлы.
+   EPS становится step / 2: разность разных узлов не меньше step, поэтому
+   сравнение с EPS и сетки по EPS дают точное равенство номеров узлов.
+   Вызывается до чтения чертежей. Возвращает 0 при неверном step */
+int geom_set_quantized(double step);
+
+/* Узел сетки квантования для v; *near увеличивается, если v лежит
+   у середины между узлами и от ошибки округления в записи числа
+   могла бы попасть в соседний узел */
+static inline double geom_snap(double v, size_t *near) {
+    double t = v / geom_step;
+    double q = (double)llround(t);
+    if (fabs(fabs(t - q) - 0.5) < QUANT_MARGIN) (*near)++;
+    return q * geom_step;
+}
+
+#endif
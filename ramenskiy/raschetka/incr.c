@@ -0,0 +1,594 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "compact.h"
+#include "incr.h"
+#include "join.h"
+#include "parse.h"
+#include "pointset.h"
+#include "sort.h"
+#include "wires.h"
+
+#define STATE_ALIGN 64
+
+/* Виды читаются как пары (u, v): раскладка точек видов одна */
+_Static_assert(sizeof(PointXY) == sizeof(Point2D) && sizeof(PointXZ) == sizeof(Point2D) &&
+               sizeof(PointYZ) == sizeof(Point2D), "точка вида — два double");
+
+static const size_t state_elem[STATE_ARRAYS] = {
+    sizeof(Point2D), sizeof(Point2D), sizeof(Point2D), sizeof(PointXYZ), sizeof(uint64_t)
+};
+
+/* Различные точки вида в порядке сортировки: ячейки сетки (по ключу u,
+   затем по ключу v) идут подряд */
+typedef struct {
+    const Point2D *p;
+    size_t n;
+} SortedView;
+
+/* Прошлый запуск: отображение файла состояния */
+typedef struct {
+    void *map;
+    size_t len;
+    SortedView views[VIEW_COUNT];
+    const PointXYZ *verts;
+    const uint64_t *refs;
+    size_t nverts;
+} State;
+
+/* ----------------------------------------- */
+/* Поиск по ячейкам отсортированного вида */
+
+static inline int cell_cmp(const Point2D *p, long long ka, long long kb, double inv) {
+    long long pa = grid_key(p->u, inv);
+    if (pa != ka) return pa < ka ? -1 : 1;
+    long long pb = grid_key(p->v, inv);
+    return (pb > kb) - (pb < kb);
+}
+
+/* Первая точка, чья ячейка не меньше (ka, kb) */
+static size_t cell_lower(const SortedView *s, long long ka, long long kb, double inv) {
+    size_t lo = 0, hi = s->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cell_cmp(&s->p[mid], ka, kb, inv) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Есть ли в виде точка, совпадающая с (u, v) с точностью EPS */
+static int view_has(const SortedView *s, double u, double v, double inv) {
+    long long ku = grid_key(u, inv), kv = grid_key(v, inv);
+    long long r = grid_reach();
+    for (long long du = -r; du <= r; du++) {
+        for (long long dv = -r; dv <= r; dv++) {
+            for (size_t i = cell_lower(s, ku + du, kv + dv, inv); i < s->n; i++) {
+                const Point2D *p = &s->p[i];
+                if (cell_cmp(p, ku + du, kv + dv, inv) != 0) break;
+                if (approx_eq(p->u, u) && approx_eq(p->v, v)) return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ----------------------------------------- */
+/* Списки, растущие вдвое */
+
+static int grow(void **a, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap) return 1;
+    size_t new_cap = *cap ? *cap * 2 : 64;
+    while (new_cap < need) new_cap *= 2;
+    void *resized = realloc(*a, new_cap * elem);
+    if (!resized) return 0;
+    *a = resized;
+    *cap = new_cap;
+    return 1;
+}
+
+typedef struct {
+    Point2D *p;
+    size_t n, cap;
+} ValueList;
+
+typedef struct {
+    double *z;
+    size_t n, cap;
+} ZList;
+
+typedef struct {
+    PointXYZ *p;
+    size_t n, cap;
+} PointList;
+
+static int value_push(ValueList *l, Point2D p) {
+    if (!grow((void **)&l->p, &l->cap, l->n + 1, sizeof(Point2D))) return 0;
+    l->p[l->n++] = p;
+    return 1;
+}
+
+static int point_push(PointList *l, PointXYZ p) {
+    if (!grow((void **)&l->p, &l->cap, l->n + 1, sizeof(PointXYZ))) return 0;
+    l->p[l->n++] = p;
+    return 1;
+}
+
+static int z_has(const ZList *l, double z) {
+    for (size_t k = 0; k < l->n; k++) {
+        if (memcmp(&l->z[k], &z, sizeof(z)) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Совпадения значения (x, y): z точек XZ с тем же x, для которых в YZ
+   есть (y, z), в порядке вида XZ и без побитовых повторов — те же
+   кандидаты, что дают join_point и отбор повторов join_xyz */
+static int match_value(const SortedView *xz, const SortedView *yz, double x, double y,
+                       double inv, ZList *out) {
+    out->n = 0;
+    long long kx = grid_key(x, inv);
+    long long r = grid_reach();
+    for (long long dx = -r; dx <= r; dx++) {
+        size_t end = cell_lower(xz, kx + dx + 1, LLONG_MIN, inv);
+        for (size_t i = cell_lower(xz, kx + dx, LLONG_MIN, inv); i < end; i++) {
+            const Point2D *p = &xz->p[i];
+            if (!approx_eq(p->u, x) || !view_has(yz, y, p->v, inv) || z_has(out, p->v))
+                continue;
+            if (!grow((void **)&out->z, &out->cap, out->n + 1, sizeof(double))) return 0;
+            out->z[out->n++] = p->v;
+        }
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Сравнение вида с прошлым: обе последовательности идут по ячейкам,
+   внутри общей ячейки точки сравниваются перебором (их там единицы).
+   is_new != NULL — отметки новых точек по номеру в новом виде */
+static int same_value(Point2D a, Point2D b) {
+    return a.u == b.u && a.v == b.v;
+}
+
+static int range_has(const Point2D *p, size_t begin, size_t end, Point2D v) {
+    for (size_t k = begin; k < end; k++) {
+        if (same_value(p[k], v)) return 1;
+    }
+    return 0;
+}
+
+static int diff_view(const SortedView *o, const SortedView *n, double inv,
+                     ValueList *added, ValueList *removed, unsigned char *is_new) {
+    size_t i = 0, j = 0;
+    while (i < o->n || j < n->n) {
+        int cmp;
+        if (i == o->n) cmp = 1;
+        else if (j == n->n) cmp = -1;
+        else cmp = -cell_cmp(&n->p[j], grid_key(o->p[i].u, inv), grid_key(o->p[i].v, inv), inv);
+
+        if (cmp < 0) {
+            if (!value_push(removed, o->p[i++])) return 0;
+            continue;
+        }
+        if (cmp > 0) {
+            if (is_new) is_new[j] = 1;
+            if (!value_push(added, n->p[j++])) return 0;
+            continue;
+        }
+
+        long long ka = grid_key(o->p[i].u, inv), kb = grid_key(o->p[i].v, inv);
+        size_t ie = i, je = j;
+        while (ie < o->n && cell_cmp(&o->p[ie], ka, kb, inv) == 0) ie++;
+        while (je < n->n && cell_cmp(&n->p[je], ka, kb, inv) == 0) je++;
+        for (size_t k = j; k < je; k++) {
+            if (range_has(o->p, i, ie, n->p[k])) continue;
+            if (is_new) is_new[k] = 1;
+            if (!value_push(added, n->p[k])) return 0;
+        }
+        for (size_t k = i; k < ie; k++) {
+            if (!range_has(n->p, j, je, o->p[k]) && !value_push(removed, o->p[k])) return 0;
+        }
+        i = ie;
+        j = je;
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Файл состояния */
+
+static int state_load(const char *path, State *s) {
+    memset(s, 0, sizeof(*s));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    StateHeader h;
+    int ok = fstat(fd, &st) == 0 &&
+             pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) &&
+             memcmp(h.magic, STATE_MAGIC, sizeof(h.magic)) == 0 &&
+             h.version == STATE_VERSION && h.header_size == sizeof(StateHeader) &&
+             h.eps == EPS && h.step == geom_step && h.count[STATE_REFS] == h.count[STATE_VERTS];
+    size_t len = ok ? (size_t)st.st_size : 0;
+    for (int a = 0; a < STATE_ARRAYS && ok; a++) {
+        ok = h.offset[a] % STATE_ALIGN == 0 && h.offset[a] <= len &&
+             h.count[a] <= (len - h.offset[a]) / state_elem[a];
+    }
+    void *map = ok ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    s->map = map;
+    s->len = len;
+    const char *c = (const char *)map;
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        s->views[v].p = (const Point2D *)(c + h.offset[v]);
+        s->views[v].n = h.count[v];
+    }
+    s->verts = (const PointXYZ *)(c + h.offset[STATE_VERTS]);
+    s->refs = (const uint64_t *)(c + h.offset[STATE_REFS]);
+    s->nverts = h.count[STATE_VERTS];
+    return 1;
+}
+
+static void state_free(State *s) {
+    if (s->map) munmap(s->map, s->len);
+    memset(s, 0, sizeof(*s));
+}
+
+static int write_padded(FILE *f, const void *p, size_t bytes, uint64_t *pos) {
+    static const char zeros[STATE_ALIGN];
+    if (bytes && fwrite(p, 1, bytes, f) != bytes) return 0;
+    *pos += bytes;
+    size_t pad = (size_t)((STATE_ALIGN - *pos % STATE_ALIGN) % STATE_ALIGN);
+    if (pad && fwrite(zeros, 1, pad, f) != pad) return 0;
+    *pos += pad;
+    return 1;
+}
+
+/* Запись через временный файл и переименование */
+static int state_save(const char *path, const SortedView *views,
+                      const PointXYZ *verts, const uint64_t *refs, size_t nverts) {
+    StateHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, STATE_MAGIC, sizeof(h.magic));
+    h.version = STATE_VERSION;
+    h.header_size = sizeof(StateHeader);
+    h.eps = EPS;
+    h.step = geom_step;
+
+    const void *data[STATE_ARRAYS];
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        data[v] = views[v].p;
+        h.count[v] = views[v].n;
+    }
+    data[STATE_VERTS] = verts;
+    data[STATE_REFS] = refs;
+    h.count[STATE_VERTS] = h.count[STATE_REFS] = nverts;
+
+    uint64_t pos = sizeof(StateHeader);
+    pos += (STATE_ALIGN - pos % STATE_ALIGN) % STATE_ALIGN;
+    for (int a = 0; a < STATE_ARRAYS; a++) {
+        h.offset[a] = pos;
+        size_t bytes = h.count[a] * state_elem[a];
+        pos += bytes + (STATE_ALIGN - bytes % STATE_ALIGN) % STATE_ALIGN;
+    }
+
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        perror(tmp);
+        return 0;
+    }
+    pos = 0;
+    int ok = write_padded(f, &h, sizeof(h), &pos);
+    for (int a = 0; a < STATE_ARRAYS && ok; a++) {
+        ok = pos == h.offset[a] && write_padded(f, data[a], h.count[a] * state_elem[a], &pos);
+    }
+    if (fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) {
+        perror(path);
+        ok = 0;
+    }
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+/* ----------------------------------------- */
+/* Вершины с числом кандидатов */
+typedef struct {
+    PointSet set;
+    size_t *refs;
+    size_t cap;
+} VertexRefs;
+
+static int refs_add(VertexRefs *v, PointXYZ p) {
+    long long idx = pointset_find(&v->set, p);
+    if (idx < 0) {
+        if (pointset_insert(&v->set, p) != 1 ||
+            !grow((void **)&v->refs, &v->cap, v->set.n, sizeof(size_t)))
+            return 0;
+        idx = (long long)v->set.n - 1;
+        v->refs[idx] = 0;
+    }
+    v->refs[idx]++;
+    return 1;
+}
+
+static void refs_remove(VertexRefs *v, PointXYZ p) {
+    // Кандидат без вершины бывает, только если состояние не от этих
+    // видов, — тогда снимать нечего
+    long long idx = pointset_find(&v->set, p);
+    if (idx >= 0 && v->refs[idx] > 0) v->refs[idx]--;
+}
+
+/* Прошлые вершины в том же порядке; 0 — состояние не согласовано */
+static int refs_load(VertexRefs *v, const State *s) {
+    if (!grow((void **)&v->refs, &v->cap, s->nverts, sizeof(size_t))) return 0;
+    for (size_t i = 0; i < s->nverts; i++) {
+        if (pointset_insert(&v->set, s->verts[i]) != 1) return 0;
+        v->refs[i] = (size_t)s->refs[i];
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Значения XY, чьи совпадения могли измениться. Появившиеся XY уже
+   отмечены; изменившаяся точка XZ (x, z) задевает XY с тем же x, если
+   в старом или новом YZ есть (y, z), точка YZ (y, z) — XY с тем же y,
+   если в старом или новом XZ есть (x, z) */
+typedef struct {
+    long long ky;
+    size_t i;
+} YEntry;
+
+static int cmp_yentry(const void *a, const void *b) {
+    const YEntry *pa = (const YEntry *)a;
+    const YEntry *pb = (const YEntry *)b;
+    if (pa->ky != pb->ky) return pa->ky < pb->ky ? -1 : 1;
+    return (pa->i > pb->i) - (pa->i < pb->i);
+}
+
+static int mark_dirty(const SortedView *oldv, const SortedView *newv,
+                      const ValueList *xz_changed, const ValueList *yz_changed,
+                      double inv, unsigned char *dirty) {
+    const SortedView *xy = &newv[VIEW_TOP];
+    long long r = grid_reach();
+
+    for (int side = 0; side < 2; side++) {
+        const ValueList *ch = &xz_changed[side];
+        for (size_t c = 0; c < ch->n; c++) {
+            Point2D v = ch->p[c];
+            long long kx = grid_key(v.u, inv);
+            for (long long dx = -r; dx <= r; dx++) {
+                size_t end = cell_lower(xy, kx + dx + 1, LLONG_MIN, inv);
+                for (size_t i = cell_lower(xy, kx + dx, LLONG_MIN, inv); i < end; i++) {
+                    if (dirty[i] || !approx_eq(xy->p[i].u, v.u)) continue;
+                    dirty[i] = view_has(&newv[VIEW_PROFILE], xy->p[i].v, v.v, inv) ||
+                               view_has(&oldv[VIEW_PROFILE], xy->p[i].v, v.v, inv);
+                }
+            }
+        }
+    }
+
+    if (yz_changed[0].n + yz_changed[1].n == 0) return 1;
+
+    // Вид сверху упорядочен по x: для поиска по y — порядок по ячейкам y
+    YEntry *by_y = (YEntry *)malloc((xy->n ? xy->n : 1) * sizeof(YEntry));
+    if (!by_y) return 0;
+    for (size_t i = 0; i < xy->n; i++) by_y[i] = (YEntry){grid_key(xy->p[i].v, inv), i};
+    qsort(by_y, xy->n, sizeof(YEntry), cmp_yentry);
+
+    for (int side = 0; side < 2; side++) {
+        const ValueList *ch = &yz_changed[side];
+        for (size_t c = 0; c < ch->n; c++) {
+            Point2D v = ch->p[c];
+            long long ky = grid_key(v.u, inv);
+            size_t lo = 0, hi = xy->n;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (by_y[mid].ky < ky - r) lo = mid + 1;
+                else hi = mid;
+            }
+            for (size_t k = lo; k < xy->n && by_y[k].ky <= ky + r; k++) {
+                size_t i = by_y[k].i;
+                if (dirty[i] || !approx_eq(xy->p[i].v, v.u)) continue;
+                dirty[i] = view_has(&newv[VIEW_FRONT], xy->p[i].u, v.v, inv) ||
+                           view_has(&oldv[VIEW_FRONT], xy->p[i].u, v.v, inv);
+            }
+        }
+    }
+    free(by_y);
+    return 1;
+}
+
+/* Кандидаты, которые пропали и появились у значения (x, y) */
+static int diff_matches(const ZList *old_z, const ZList *new_z, Point2D xy,
+                        PointList *rm, PointList *add) {
+    for (size_t k = 0; k < old_z->n; k++) {
+        if (!z_has(new_z, old_z->z[k]) &&
+            !point_push(rm, (PointXYZ){xy.u, xy.v, old_z->z[k]}))
+            return 0;
+    }
+    for (size_t k = 0; k < new_z->n; k++) {
+        if (!z_has(old_z, new_z->z[k]) &&
+            !point_push(add, (PointXYZ){xy.u, xy.v, new_z->z[k]}))
+            return 0;
+    }
+    return 1;
+}
+
+/* Повторное соединение изменившихся значений XY */
+static int rejoin(const State *old, const SortedView *newv, double inv,
+                  VertexRefs *vr, IncrResult *r) {
+    ValueList added[VIEW_COUNT], removed[VIEW_COUNT];
+    memset(added, 0, sizeof(added));
+    memset(removed, 0, sizeof(removed));
+    size_t nxy = newv[VIEW_TOP].n;
+    unsigned char *is_new = (unsigned char *)calloc(nxy ? nxy : 1, 1);
+    unsigned char *dirty = (unsigned char *)calloc(nxy ? nxy : 1, 1);
+    ZList old_z = {NULL, 0, 0}, new_z = {NULL, 0, 0};
+    PointList rm = {NULL, 0, 0}, add = {NULL, 0, 0};
+    int ok = is_new && dirty;
+
+    for (int v = 0; v < VIEW_COUNT && ok; v++) {
+        ok = diff_view(&old->views[v], &newv[v], inv, &added[v], &removed[v],
+                       v == VIEW_TOP ? is_new : NULL);
+        r->added[v] = added[v].n;
+        r->removed[v] = removed[v].n;
+    }
+    if (ok) {
+        memcpy(dirty, is_new, nxy);
+        ValueList xz_changed[2] = {added[VIEW_FRONT], removed[VIEW_FRONT]};
+        ValueList yz_changed[2] = {added[VIEW_PROFILE], removed[VIEW_PROFILE]};
+        ok = mark_dirty(old->views, newv, xz_changed, yz_changed, inv, dirty);
+    }
+
+    const SortedView *ov = old->views;
+    for (size_t i = 0; i < nxy && ok; i++) {
+        if (!dirty[i]) continue;
+        Point2D v = newv[VIEW_TOP].p[i];
+        r->rejoined++;
+        old_z.n = 0;
+        ok = match_value(&newv[VIEW_FRONT], &newv[VIEW_PROFILE], v.u, v.v, inv, &new_z) &&
+             (is_new[i] || match_value(&ov[VIEW_FRONT], &ov[VIEW_PROFILE], v.u, v.v, inv, &old_z)) &&
+             diff_matches(&old_z, &new_z, v, &rm, &add);
+    }
+    new_z.n = 0;
+    for (size_t c = 0; c < removed[VIEW_TOP].n && ok; c++) {
+        Point2D v = removed[VIEW_TOP].p[c];
+        r->rejoined++;
+        ok = match_value(&ov[VIEW_FRONT], &ov[VIEW_PROFILE], v.u, v.v, inv, &old_z) &&
+             diff_matches(&old_z, &new_z, v, &rm, &add);
+    }
+
+    // Сначала снимаются пропавшие кандидаты: сдвинутый на доли EPS
+    // кандидат возвращается к своей прежней вершине
+    for (size_t k = 0; k < rm.n && ok; k++) refs_remove(vr, rm.p[k]);
+    for (size_t k = 0; k < add.n && ok; k++) ok = refs_add(vr, add.p[k]);
+    r->cand_removed = rm.n;
+    r->cand_added = add.n;
+
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        free(added[v].p);
+        free(removed[v].p);
+    }
+    free(is_new);
+    free(dirty);
+    free(old_z.z);
+    free(new_z.z);
+    free(rm.p);
+    free(add.p);
+    return ok;
+}
+
+/* ----------------------------------------- */
+int incr_run(WorkerPool *pool, Arena *arena, const char *filename,
+             const char *state_path, IncrResult *r, StageTimes *t) {
+    memset(r, 0, sizeof(*r));
+
+    timing_begin(t, STAGE_READ);
+    Projections pr;
+    if (!parse_projections(pool, arena, filename, &pr)) return 0;
+    timing_end(t, STAGE_READ);
+    r->nxy_raw = pr.nxy_raw;
+    r->nxz_raw = pr.nxz_raw;
+    r->nyz_raw = pr.nyz_raw;
+    if (pr.nxy == 0 || pr.nxz == 0 || pr.nyz == 0) {
+        projections_free(&pr);
+        return 1;
+    }
+
+    timing_begin(t, STAGE_SORT);
+    int ok = sort_projections(pool, pr.xy, pr.nxy, pr.xz, pr.nxz, pr.yz, pr.nyz) &&
+             compact_projections(pool, &pr);
+    timing_end(t, STAGE_SORT);
+    SortedView newv[VIEW_COUNT] = {
+        {(const Point2D *)pr.xz, pr.nxz},
+        {(const Point2D *)pr.yz, pr.nyz},
+        {(const Point2D *)pr.xy, pr.nxy},
+    };
+    r->nxy = pr.nxy;
+    double inv = grid_inv_cell();
+
+    State old;
+    VertexRefs vr;
+    memset(&vr, 0, sizeof(vr));
+    int have_state = ok && state_load(state_path, &old);
+    ok = ok && pointset_init(&vr.set, have_state ? old.nverts + 1024 : 1024);
+    timing_begin(t, STAGE_DEDUP);
+    int loaded = have_state && ok && refs_load(&vr, &old);
+    timing_end(t, STAGE_DEDUP);
+    if (have_state && ok && !loaded) {
+        // Вершины состояния не различны — файл не от этой программы
+        pointset_clear(&vr.set);
+        state_free(&old);
+        have_state = 0;
+    }
+    r->full = !have_state;
+    size_t nold = have_state ? old.nverts : 0;
+
+    if (ok && have_state) {
+        timing_begin(t, STAGE_JOIN);
+        ok = rejoin(&old, newv, inv, &vr, r);
+        timing_end(t, STAGE_JOIN);
+    } else if (ok) {
+        timing_begin(t, STAGE_JOIN);
+        JoinResult cand;
+        ok = join_xyz(pool, arena, pr.xy, pr.mxy, pr.nxy, pr.xz, pr.mxz, pr.nxz,
+                      pr.yz, pr.nyz, &cand);
+        timing_end(t, STAGE_JOIN);
+        if (ok) {
+            timing_begin(t, STAGE_DEDUP);
+            for (size_t c = 0; c < cand.n && ok; c++) ok = refs_add(&vr, cand.pts[c]);
+            timing_end(t, STAGE_DEDUP);
+            r->cand_added = cand.n;
+            join_result_free(&cand);
+        }
+    }
+
+    // Изменение вершин и новое состояние: живые вершины по порядку
+    PointXYZ *live = NULL;
+    uint64_t *live_refs = NULL;
+    size_t nlive = 0;
+    if (ok) {
+        size_t n = vr.set.n;
+        live = (PointXYZ *)malloc((n ? n : 1) * sizeof(PointXYZ));
+        live_refs = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+        r->vadd = (PointXYZ *)malloc((n ? n : 1) * sizeof(PointXYZ));
+        r->vdel = (PointXYZ *)malloc((nold ? nold : 1) * sizeof(PointXYZ));
+        ok = live && live_refs && r->vadd && r->vdel;
+        for (size_t i = 0; i < n && ok; i++) {
+            if (vr.refs[i] == 0) {
+                r->vdel[r->nvdel++] = vr.set.pts[i];
+                continue;
+            }
+            if (i >= nold) r->vadd[r->nvadd++] = vr.set.pts[i];
+            live[nlive] = vr.set.pts[i];
+            live_refs[nlive++] = vr.refs[i];
+        }
+        r->vertices = nlive;
+    }
+    if (have_state) state_free(&old);
+    if (ok) r->saved = state_save(state_path, newv, live, live_refs, nlive);
+
+    free(live);
+    free(live_refs);
+    free(vr.refs);
+    pointset_free(&vr.set);
+    projections_free(&pr);
+    if (!ok) incr_result_free(r);
+    return ok;
+}
+
+void incr_result_free(IncrResult *r) {
+    free(r->vadd);
+    free(r->vdel);
+    r->vadd = r->vdel = NULL;
+    r->nvadd = r->nvdel = 0;
+}
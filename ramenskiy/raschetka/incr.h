@@ -0,0 +1,74 @@
+#ifndef INCR_H
+#define INCR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "geom.h"
+#include "pool.h"
+#include "timing.h"
+
+/* Инкрементальное восстановление после правки чертежа.
+   Файл состояния хранит различные точки видов прошлого запуска в порядке
+   сортировки (как кэш, cache.h) и вершины с числом кандидатов, слитых
+   в каждую. Новый чертёж читается, сортируется и сжимается как обычно,
+   затем каждый вид сравнивается с прошлым по ячейкам сетки — так
+   находятся появившиеся и пропавшие точки. Соединение повторяется только
+   для значений XY, чьи совпадения могли измениться: новых и пропавших,
+   а также тех, у кого с тем же x есть изменившаяся точка XZ или с тем же
+   y — изменившаяся точка YZ (и пара к ней во втором виде). Индексы не
+   строятся: в отсортированном виде точки одной ячейки идут подряд,
+   и поиск по ячейкам — двоичный. Пропавшие кандидаты снимаются со своих
+   вершин, новые добавляются к ближней вершине или становятся новыми;
+   вершина без кандидатов удаляется. Время соединения и отбора зависит
+   от размера правки, чтение и сравнение видов — от размера чертежа.
+
+   В режиме квантования вершины точно те же, что при полном
+   восстановлении нового чертежа; с EPS — с точностью EPS (вершина
+   сохраняет прежнего представителя, пока у неё есть кандидаты).
+   Рёбра не строятся. Нет состояния или оно записано с другой
+   точностью — полное восстановление, все вершины в добавленных */
+
+#define STATE_MAGIC "RSSTATE"
+#define STATE_VERSION 1
+
+/* Массивы состояния: виды по номерам VIEW_*, вершины, число кандидатов */
+enum {
+    STATE_VERTS = VIEW_COUNT,
+    STATE_REFS,
+    STATE_ARRAYS
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    double eps;
+    double step;                  // шаг квантования, 0 — без него
+    uint64_t count[STATE_ARRAYS];
+    uint64_t offset[STATE_ARRAYS];
+} StateHeader;
+
+typedef struct {
+    int full;                     // полное восстановление
+    int saved;                    // новое состояние записано
+    size_t nxy_raw, nxz_raw, nyz_raw;          // точек в новом чертеже
+    size_t added[VIEW_COUNT], removed[VIEW_COUNT];   // различных точек видов
+    size_t nxy;                   // различных значений XY
+    size_t rejoined;              // значений XY, соединённых заново
+    size_t cand_added, cand_removed;
+    PointXYZ *vadd, *vdel;        // добавленные и удалённые вершины
+    size_t nvadd, nvdel;
+    size_t vertices;              // вершин после правки
+} IncrResult;
+
+/* Восстановление filename с учётом состояния state_path; состояние
+   перезаписывается новым (через временный файл). Пустой вид в новом
+   чертеже — не ошибка, но ничего не считается и состояние не трогается:
+   проверяются r->n*_raw. arena — для видов нового чертежа.
+   Возвращает 1 при успехе */
+int incr_run(WorkerPool *pool, Arena *arena, const char *filename,
+             const char *state_path, IncrResult *r, StageTimes *t);
+void incr_result_free(IncrResult *r);
+
+#endif
@@ -0,0 +1,526 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "join.h"
+#include "simd.h"
+
+/* ----------------------------------------- */
+/* Индекс XZ по x */
+typedef struct {
+    double x;
+    size_t pos;
+} XEntry;
+
+static int cmp_xentry(const void *a, const void *b) {
+    const XEntry *pa = (const XEntry*)a;
+    const XEntry *pb = (const XEntry*)b;
+    if (pa->x != pb->x) return (pa->x < pb->x) ? -1 : 1;
+    if (pa->pos != pb->pos) return (pa->pos < pb->pos) ? -1 : 1;
+    return 0;
+}
+
+int xz_index_build(XzIndex *ix, Arena *arena, const PointXZ *xz, size_t n) {
+    memset(ix, 0, sizeof(*ix));
+    ix->arena = arena;
+    XEntry *tmp = (XEntry *)malloc((n ? n : 1) * sizeof(XEntry));
+    ix->x = (double *)arena_or_malloc(arena, n * sizeof(double));
+    ix->pos = (size_t *)arena_or_malloc(arena, n * sizeof(size_t));
+    if (!tmp || !ix->x || !ix->pos) {
+        free(tmp);
+        xz_index_free(ix);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        tmp[i].x = xz[i].x;
+        tmp[i].pos = i;
+    }
+    qsort(tmp, n, sizeof(XEntry), cmp_xentry);
+    for (size_t i = 0; i < n; i++) {
+        ix->x[i] = tmp[i].x;
+        ix->pos[i] = tmp[i].pos;
+    }
+    ix->n = n;
+
+    free(tmp);
+    return 1;
+}
+
+void xz_index_free(XzIndex *ix) {
+    arena_or_free(ix->arena, ix->x);
+    arena_or_free(ix->arena, ix->pos);
+    memset(ix, 0, sizeof(*ix));
+}
+
+/* Первый элемент с x >= v */
+static size_t lower_bound(const double *a, size_t n, double v) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Первый элемент с x > v */
+static size_t upper_bound(const double *a, size_t n, double v) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] <= v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* ----------------------------------------- */
+/* Сетка YZ */
+static inline size_t hash_key(long long a, long long b) {
+    uint64_t h = (uint64_t)a * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)b + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+typedef struct {
+    long long ky, kz;
+    size_t pos;
+} KeyEntry;
+
+static int cmp_keyentry(const void *a, const void *b) {
+    const KeyEntry *pa = (const KeyEntry*)a;
+    const KeyEntry *pb = (const KeyEntry*)b;
+    if (pa->ky != pb->ky) return (pa->ky < pb->ky) ? -1 : 1;
+    if (pa->kz != pb->kz) return (pa->kz < pb->kz) ? -1 : 1;
+    if (pa->pos != pb->pos) return (pa->pos < pb->pos) ? -1 : 1;
+    return 0;
+}
+
+static const GridCell *yz_grid_find(const YzGrid *g, long long ky, long long kz) {
+    size_t slot = hash_key(ky, kz) & g->mask;
+    while (g->table[slot]) {
+        const GridCell *c = &g->cells[g->table[slot] - 1];
+        if (c->ky == ky && c->kz == kz) return c;
+        slot = (slot + 1) & g->mask;
+    }
+    return NULL;
+}
+
+int yz_grid_build(YzGrid *g, Arena *arena, const PointYZ *yz, size_t n) {
+    memset(g, 0, sizeof(*g));
+    g->arena = arena;
+    g->inv_cell = grid_inv_cell();
+
+    KeyEntry *keys = (KeyEntry *)malloc((n ? n : 1) * sizeof(KeyEntry));
+    g->pts = (PointYZ *)arena_or_malloc(arena, n * sizeof(PointYZ));
+    g->cells = (GridCell *)arena_or_malloc(arena, n * sizeof(GridCell));
+    if (!keys || !g->pts || !g->cells) {
+        free(keys);
+        yz_grid_free(g);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        keys[i].ky = grid_key(yz[i].y, g->inv_cell);
+        keys[i].kz = grid_key(yz[i].z, g->inv_cell);
+        keys[i].pos = i;
+    }
+    qsort(keys, n, sizeof(KeyEntry), cmp_keyentry);
+
+    for (size_t i = 0; i < n; i++) {
+        g->pts[i] = yz[keys[i].pos];
+        if (i == 0 || keys[i].ky != keys[i-1].ky || keys[i].kz != keys[i-1].kz) {
+            GridCell *c = &g->cells[g->ncells++];
+            c->ky = keys[i].ky;
+            c->kz = keys[i].kz;
+            c->begin = i;
+        }
+        g->cells[g->ncells - 1].end = i + 1;
+    }
+    free(keys);
+
+    size_t cap = 16;
+    while (cap < 2 * g->ncells) cap *= 2;
+    g->table = (size_t *)arena_or_calloc(arena, cap, sizeof(size_t));
+    if (!g->table) {
+        yz_grid_free(g);
+        return 0;
+    }
+    g->mask = cap - 1;
+
+    for (size_t c = 0; c < g->ncells; c++) {
+        size_t slot = hash_key(g->cells[c].ky, g->cells[c].kz) & g->mask;
+        while (g->table[slot]) slot = (slot + 1) & g->mask;
+        g->table[slot] = c + 1;
+    }
+    return 1;
+}
+
+/* Есть ли в YZ точка, совпадающая с (y, z) с точностью EPS */
+int yz_grid_has(const YzGrid *g, double y, double z) {
+    long long ky = grid_key(y, g->inv_cell);
+    long long kz = grid_key(z, g->inv_cell);
+    long long r = grid_reach();
+
+    for (long long dy = -r; dy <= r; dy++) {
+        for (long long dz = -r; dz <= r; dz++) {
+            const GridCell *c = yz_grid_find(g, ky + dy, kz + dz);
+            if (!c) continue;
+            for (size_t k = c->begin; k < c->end; k++) {
+                if (approx_eq(g->pts[k].y, y) && approx_eq(g->pts[k].z, z))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void yz_grid_free(YzGrid *g) {
+    arena_or_free(g->arena, g->pts);
+    arena_or_free(g->arena, g->cells);
+    arena_or_free(g->arena, g->table);
+    memset(g, 0, sizeof(*g));
+}
+
+/* ----------------------------------------- */
+/* Соединение трёх видов */
+static int cmp_size(const void *a, const void *b) {
+    size_t va = *(const size_t*)a;
+    size_t vb = *(const size_t*)b;
+    return (va > vb) - (va < vb);
+}
+
+static void sort_positions(size_t *a, size_t n) {
+    if (n > 32) {
+        qsort(a, n, sizeof(size_t), cmp_size);
+        return;
+    }
+    // Короткие списки — сортировка вставками
+    for (size_t i = 1; i < n; i++) {
+        size_t v = a[i];
+        size_t j = i;
+        while (j > 0 && a[j-1] > v) {
+            a[j] = a[j-1];
+            j--;
+        }
+        a[j] = v;
+    }
+}
+
+int join_point(const XzIndex *ix, const YzGrid *g, const PointXZ *xz,
+               double x, double y, size_t **match, size_t *cap, size_t *n) {
+    // Окно по x берётся с запасом, точная проверка — eps_filter
+    size_t lo = lower_bound(ix->x, ix->n, x - 2 * EPS);
+    size_t width = upper_bound(ix->x + lo, ix->n - lo, x + 2 * EPS);
+    if (width > *cap) {
+        size_t new_cap = *cap ? *cap : 64;
+        while (new_cap < width) new_cap *= 2;
+        size_t *resized = (size_t *)realloc(*match, new_cap * sizeof(size_t));
+        if (!resized) return 0;
+        *match = resized;
+        *cap = new_cap;
+    }
+    size_t *cand = *match;
+    size_t ncand = eps_filter(ix->x + lo, width, x, cand);
+    for (size_t t = 0; t < ncand; t++) cand[t] = ix->pos[lo + cand[t]];
+    sort_positions(cand, ncand);
+
+    size_t m = 0;
+    for (size_t t = 0; t < ncand; t++) {
+        if (yz_grid_has(g, y, xz[cand[t]].z)) cand[m++] = cand[t];
+    }
+    *n = m;
+    return 1;
+}
+
+/* Хеш точки по битовому представлению координат */
+static inline uint64_t hash_point(PointXYZ p) {
+    uint64_t bx, by, bz;
+    memcpy(&bx, &p.x, sizeof(bx));
+    memcpy(&by, &p.y, sizeof(by));
+    memcpy(&bz, &p.z, sizeof(bz));
+    uint64_t h = bx * 0x9E3779B97F4A7C15ULL;
+    h ^= by * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+    h ^= bz * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return h;
+}
+
+static inline int same_point(PointXYZ a, PointXYZ b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/* Кандидаты одного куска вида сверху (локальный буфер потока).
+   Точные повторы отбрасываются сразу: если точка совпадает с уже
+   встреченной побитово, то отбор по EPS её всё равно отбросит */
+typedef struct {
+    PointXYZ *pts;
+    uint64_t *hash;
+    unsigned char *keep;   // флаг после слияния кусков
+    size_t n, cap;
+    size_t *table;         // номер точки + 1, 0 — пустой слот
+    size_t mask;
+    size_t found;          // совпадений вместе с повторами
+    int ok;
+} JoinChunk;
+
+static int chunk_grow(JoinChunk *c) {
+    size_t cap = c->cap ? c->cap * 2 : 256;
+    PointXYZ *pts = (PointXYZ *)realloc(c->pts, cap * sizeof(PointXYZ));
+    if (!pts) return 0;
+    c->pts = pts;
+    uint64_t *hash = (uint64_t *)realloc(c->hash, cap * sizeof(uint64_t));
+    if (!hash) return 0;
+    c->hash = hash;
+
+    size_t tcap = 2 * cap;
+    size_t *table = (size_t *)calloc(tcap, sizeof(size_t));
+    if (!table) return 0;
+    for (size_t i = 0; i < c->n; i++) {
+        size_t slot = c->hash[i] & (tcap - 1);
+        while (table[slot]) slot = (slot + 1) & (tcap - 1);
+        table[slot] = i + 1;
+    }
+    free(c->table);
+    c->table = table;
+    c->mask = tcap - 1;
+    c->cap = cap;
+    return 1;
+}
+
+static int chunk_add(JoinChunk *c, PointXYZ p) {
+    uint64_t h = hash_point(p);
+    if (c->table) {
+        size_t slot = h & c->mask;
+        while (c->table[slot]) {
+            size_t k = c->table[slot] - 1;
+            if (c->hash[k] == h && same_point(c->pts[k], p)) return 1;
+            slot = (slot + 1) & c->mask;
+        }
+    }
+    if (c->n == c->cap && !chunk_grow(c)) return 0;
+
+    size_t slot = h & c->mask;
+    while (c->table[slot]) slot = (slot + 1) & c->mask;
+    c->table[slot] = c->n + 1;
+    c->pts[c->n] = p;
+    c->hash[c->n] = h;
+    c->n++;
+    return 1;
+}
+
+static void chunk_free(JoinChunk *c) {
+    free(c->pts);
+    free(c->hash);
+    free(c->keep);
+    free(c->table);
+}
+
+typedef struct {
+    const PointXY *xy;
+    const uint32_t *mxy;   // кратности точек или NULL — все по одной
+    size_t nxy;
+    const PointXZ *xz;
+    const uint32_t *mxz;
+    size_t nxz;
+    const PointYZ *yz;
+    size_t nyz;
+    Arena *arena;
+
+    XzIndex ix;
+    YzGrid grid;
+    int ix_ok, grid_ok;
+
+    JoinChunk *chunks;
+    size_t nchunks;
+    size_t nparts;
+} JoinJob;
+
+/* Построение индексов: задача 0 — XZ, задача 1 — YZ */
+static void build_index_task(void *arg, size_t task) {
+    JoinJob *job = (JoinJob*)arg;
+    if (task == 0) job->ix_ok = xz_index_build(&job->ix, job->arena, job->xz, job->nxz);
+    else job->grid_ok = yz_grid_build(&job->grid, job->arena, job->yz, job->nyz);
+}
+
+/* Соединение куска [begin, end) вида сверху */
+static void join_chunk_task(void *arg, size_t task) {
+    JoinJob *job = (JoinJob*)arg;
+    JoinChunk *chunk = &job->chunks[task];
+    const PointXY *xy = job->xy;
+    const XzIndex *ix = &job->ix;
+    size_t begin = task * job->nxy / job->nchunks;
+    size_t end = (task + 1) * job->nxy / job->nchunks;
+
+    size_t *cand = NULL;
+    size_t cand_cap = 0;
+    chunk->ok = 1;
+
+    // Повторяющиеся точки вида сверху дают в точности те же совпадения,
+    // что и предыдущая точка: достаточно учесть их количество.
+    // Совпадения считаются с кратностями, как при переборе всех повторов
+    size_t prev_unit = 0;
+
+    for (size_t i = begin; i < end && chunk->ok; i++) {
+        double x = xy[i].x;
+        double y = xy[i].y;
+        size_t weight = job->mxy ? job->mxy[i] : 1;
+
+        if (i > begin && xy[i-1].x == x && xy[i-1].y == y) {
+            chunk->found += weight * prev_unit;
+            continue;
+        }
+
+        size_t ncand;
+        if (!join_point(ix, &job->grid, job->xz, x, y, &cand, &cand_cap, &ncand)) {
+            chunk->ok = 0;
+            break;
+        }
+
+        size_t unit = 0;
+        for (size_t t = 0; t < ncand && chunk->ok; t++) {
+            unit += job->mxz ? job->mxz[cand[t]] : 1;
+            chunk->ok = chunk_add(chunk, (PointXYZ){x, y, job->xz[cand[t]].z});
+        }
+        chunk->found += weight * unit;
+        prev_unit = unit;
+    }
+
+    free(cand);
+}
+
+/* Слияние кусков: часть пространства хешей task просматривает все куски
+   по порядку и оставляет только первое вхождение каждой точки */
+static void merge_part_task(void *arg, size_t task) {
+    JoinJob *job = (JoinJob*)arg;
+    size_t total = 0;
+    for (size_t c = 0; c < job->nchunks; c++) {
+        JoinChunk *chunk = &job->chunks[c];
+        for (size_t i = 0; i < chunk->n; i++) {
+            if (chunk->hash[i] % job->nparts == task) total++;
+        }
+    }
+
+    size_t cap = 16;
+    while (cap < 2 * total) cap *= 2;
+    size_t mask = cap - 1;
+    PointXYZ **table = (PointXYZ **)calloc(cap, sizeof(PointXYZ*));
+
+    for (size_t c = 0; c < job->nchunks; c++) {
+        JoinChunk *chunk = &job->chunks[c];
+        for (size_t i = 0; i < chunk->n; i++) {
+            uint64_t h = chunk->hash[i];
+            if (h % job->nparts != task) continue;
+            if (!table) {
+                // Без памяти под таблицу оставляем точку: отбор по EPS
+                // всё равно удалит повтор, меняется только скорость
+                chunk->keep[i] = 1;
+                continue;
+            }
+            size_t slot = (h / job->nparts) & mask;
+            int dup = 0;
+            while (table[slot]) {
+                if (same_point(*table[slot], chunk->pts[i])) {
+                    dup = 1;
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+            if (!dup) table[slot] = &chunk->pts[i];
+            chunk->keep[i] = !dup;
+        }
+    }
+    free(table);
+}
+
+static void run_join_tasks(WorkerPool *pool, PoolTask fn, JoinJob *job, size_t ntasks) {
+    if (pool) {
+        pool_run(pool, fn, job, ntasks);
+    } else {
+        for (size_t t = 0; t < ntasks; t++) fn(job, t);
+    }
+}
+
+int join_xyz(WorkerPool *pool, Arena *arena,
+             const PointXY *xy, const uint32_t *mxy, size_t nxy,
+             const PointXZ *xz, const uint32_t *mxz, size_t nxz,
+             const PointYZ *yz, size_t nyz,
+             JoinResult *res) {
+    memset(res, 0, sizeof(*res));
+    res->arena = arena;
+
+    JoinJob job;
+    memset(&job, 0, sizeof(job));
+    job.xy = xy;
+    job.mxy = mxy;
+    job.nxy = nxy;
+    job.xz = xz;
+    job.mxz = mxz;
+    job.nxz = nxz;
+    job.yz = yz;
+    job.nyz = nyz;
+    job.arena = arena;
+
+    int nthreads = pool ? pool->nthreads : 1;
+    run_join_tasks(pool, build_index_task, &job, 2);
+    int ok = job.ix_ok && job.grid_ok;
+
+    // Кусков больше, чем потоков, чтобы выровнять нагрузку
+    job.nchunks = (size_t)nthreads * 8;
+    if (job.nchunks > nxy) job.nchunks = nxy ? nxy : 1;
+    job.nparts = (size_t)nthreads;
+    job.chunks = ok ? (JoinChunk *)calloc(job.nchunks, sizeof(JoinChunk)) : NULL;
+    ok = ok && job.chunks;
+
+    if (ok) {
+        run_join_tasks(pool, join_chunk_task, &job, job.nchunks);
+        for (size_t c = 0; c < job.nchunks; c++) {
+            JoinChunk *chunk = &job.chunks[c];
+            ok = ok && chunk->ok;
+            chunk->keep = (unsigned char *)malloc(chunk->n ? chunk->n : 1);
+            ok = ok && chunk->keep;
+            res->found += chunk->found;
+        }
+    }
+
+    if (ok) {
+        run_join_tasks(pool, merge_part_task, &job, job.nparts);
+
+        size_t total = 0;
+        for (size_t c = 0; c < job.nchunks; c++) {
+            for (size_t i = 0; i < job.chunks[c].n; i++)
+                total += job.chunks[c].keep[i];
+        }
+        res->pts = (PointXYZ *)arena_or_malloc(arena, total * sizeof(PointXYZ));
+        ok = res->pts != NULL;
+        for (size_t c = 0; c < job.nchunks && ok; c++) {
+            JoinChunk *chunk = &job.chunks[c];
+            for (size_t i = 0; i < chunk->n; i++) {
+                if (chunk->keep[i]) res->pts[res->n++] = chunk->pts[i];
+            }
+        }
+    }
+
+    if (job.chunks) {
+        for (size_t c = 0; c < job.nchunks; c++) chunk_free(&job.chunks[c]);
+        free(job.chunks);
+    }
+    if (job.ix_ok) xz_index_free(&job.ix);
+    if (job.grid_ok) yz_grid_free(&job.grid);
+
+    if (!ok) {
+        join_result_free(res);
+        return 0;
+    }
+    return 1;
+}
+
+void join_result_free(JoinResult *res) {
+    arena_or_free(res->arena, res->pts);
+    memset(res, 0, sizeof(*res));
+}
@@ -0,0 +1,78 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "geom.h"
+#include "pool.h"
+
+/* Индекс вида спереди: точки XZ, упорядоченные строго по x.
+   Координаты лежат отдельными массивами, чтобы отбор по x читал только x.
+   pos хранит исходный номер точки, чтобы сохранить порядок перебора */
+typedef struct {
+    double *x;
+    size_t *pos;
+    size_t n;
+    Arena *arena;        // откуда массивы (NULL — malloc)
+} XzIndex;
+
+/* Ячейка сетки вида сбоку */
+typedef struct {
+    long long ky, kz;
+    size_t begin, end;   // диапазон точек ячейки в YzGrid.pts
+} GridCell;
+
+/* Сеточный индекс вида сбоку: ячейки размером ~EPS по (y, z),
+   поиск ячейки через хеш-таблицу с открытой адресацией */
+typedef struct {
+    PointYZ *pts;        // точки, сгруппированные по ячейкам
+    GridCell *cells;
+    size_t ncells;
+    size_t *table;       // номер ячейки + 1, 0 — пустой слот
+    size_t mask;
+    double inv_cell;
+    Arena *arena;
+} YzGrid;
+
+/* arena != NULL — массивы индекса выдаются из неё, временные буферы
+   сортировки берутся обычным malloc */
+int xz_index_build(XzIndex *ix, Arena *arena, const PointXZ *xz, size_t n);
+void xz_index_free(XzIndex *ix);
+
+int yz_grid_build(YzGrid *g, Arena *arena, const PointYZ *yz, size_t n);
+int yz_grid_has(const YzGrid *g, double y, double z);
+void yz_grid_free(YzGrid *g);
+
+/* Совпадения одной точки вида сверху (x, y): номера точек XZ с тем же x,
+   для которых в YZ есть (y, z), по возрастанию. Пишутся в *match (буфер
+   растёт realloc, *cap — его размер), *n — их число. Возвращает 1 при успехе */
+int join_point(const XzIndex *ix, const YzGrid *g, const PointXZ *xz,
+               double x, double y, size_t **match, size_t *cap, size_t *n);
+
+/* Результат соединения: 3D-кандидаты без точных повторов */
+typedef struct {
+    PointXYZ *pts;
+    size_t n;
+    size_t found;        // всего совпадений, как при полном переборе
+    Arena *arena;
+} JoinResult;
+
+/* Поиск всех 3D-кандидатов (x, y, z): для каждой точки XY берутся точки XZ
+   с тем же x и проверяется наличие точки (y, z) в YZ.
+   Вид сверху делится на куски между потоками пула, у каждого куска свой
+   буфер; после слияния кандидаты идут в том же порядке, что и при полном
+   переборе (по номеру в xy, затем по номеру в xz), независимо от числа
+   потоков. pool == NULL — всё в вызывающем потоке.
+   mxy и mxz — кратности точек сжатых видов (compact.h) или NULL;
+   found считается так, как если бы повторы не были слиты.
+   arena != NULL — индексы и результат выдаются из неё (буферы кусков
+   растут realloc и остаются на malloc). Возвращает 1 при успехе */
+int join_xyz(WorkerPool *pool, Arena *arena,
+             const PointXY *xy, const uint32_t *mxy, size_t nxy,
+             const PointXZ *xz, const uint32_t *mxz, size_t nxz,
+             const PointYZ *yz, size_t nyz,
+             JoinResult *res);
+void join_result_free(JoinResult *res);
+
+#endif
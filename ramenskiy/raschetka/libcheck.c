@@ -0,0 +1,176 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "raschetka.h"
+
+/* Проверка библиотеки (raschetka.h) против try: на каждую точность свой
+   контекст, контексты запускаются по очереди несколько раз подряд в
+   одном потоке — точность процесса меняется между запусками каждого
+   контекста. Затем те же контексты запускаются одновременно, каждый
+   в своём потоке: библиотека должна развести запуски с разной точностью.
+   Вершины и рёбра каждого запуска должны побайтно совпасть с эталоном
+   try -e eps -f bin (см. write_bin в writer.c).
+   Использование: libcheck <чертёж> <eps> <эталон.bin> [<eps> <эталон.bin> ...]
+   Код возврата 1 — расхождение или ошибка */
+
+#define ROUNDS 2
+
+typedef struct {
+    double eps;
+    const char *ref_file;
+    unsigned char *ref;      // содержимое эталона
+    size_t ref_len;
+    RaschetkaContext *ctx;
+    const char *drawing;
+    int errors, mismatches;  // одновременные запуски
+} Case;
+
+static unsigned char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    unsigned char *buf = NULL;
+    size_t cap = 0;
+    *len = 0;
+    for (;;) {
+        if (*len == cap) {
+            cap = cap ? cap * 2 : 1 << 16;
+            unsigned char *resized = (unsigned char *)realloc(buf, cap);
+            if (!resized) {
+                free(buf);
+                fclose(f);
+                return NULL;
+            }
+            buf = resized;
+        }
+        size_t got = fread(buf + *len, 1, cap - *len, f);
+        if (got == 0) break;
+        *len += got;
+    }
+    fclose(f);
+    return buf;
+}
+
+/* Результат запуска в формате bin и сравнение с эталоном */
+static int same_as_ref(const Case *c) {
+    size_t nv, ne;
+    const double *v = raschetka_vertices(c->ctx, &nv);
+    const size_t *e = raschetka_edges(c->ctx, &ne);
+    size_t head = 8 + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+    size_t len = head + nv * 3 * sizeof(double) + ne * 2 * sizeof(uint64_t);
+    if (len != c->ref_len) {
+        printf("  размер %zu, у эталона %zu\n", len, c->ref_len);
+        return 0;
+    }
+    const unsigned char *p = c->ref;
+    uint64_t counts[2];
+    memcpy(counts, p + 8 + 2 * sizeof(uint32_t), sizeof(counts));
+    if (memcmp(p, "RSRESULT", 8) != 0 || counts[0] != nv || counts[1] != ne) {
+        printf("  вершин %zu, рёбер %zu; у эталона %llu и %llu\n", nv, ne,
+               (unsigned long long)counts[0], (unsigned long long)counts[1]);
+        return 0;
+    }
+    p += head;
+    if (nv && memcmp(p, v, nv * 3 * sizeof(double)) != 0) {
+        printf("  вершины отличаются от эталона\n");
+        return 0;
+    }
+    p += nv * 3 * sizeof(double);
+    for (size_t k = 0; k < ne; k++) {
+        uint64_t ab[2];
+        memcpy(ab, p + k * sizeof(ab), sizeof(ab));
+        if (ab[0] != e[2 * k] || ab[1] != e[2 * k + 1]) {
+            printf("  ребро %zu отличается от эталона\n", k);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Поток одновременной проверки: ROUNDS запусков своего контекста */
+static void *run_concurrent(void *arg) {
+    Case *c = (Case *)arg;
+    for (int round = 0; round < ROUNDS; round++) {
+        if (!raschetka_run_file(c->ctx, c->drawing)) c->errors++;
+        else if (!same_as_ref(c)) c->mismatches++;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4 || (argc - 2) % 2 != 0) {
+        fprintf(stderr, "Использование: %s <чертёж> <eps> <эталон.bin> [<eps> <эталон.bin> ...]\n",
+                argv[0]);
+        return 1;
+    }
+    const char *drawing = argv[1];
+    int ncases = (argc - 2) / 2;
+    Case *cases = (Case *)calloc((size_t)ncases, sizeof(Case));
+    if (!cases) return 1;
+
+    int ok = 1;
+    for (int i = 0; i < ncases && ok; i++) {
+        Case *c = &cases[i];
+        c->eps = strtod(argv[2 + 2 * i], NULL);
+        c->ref_file = argv[3 + 2 * i];
+        c->ref = read_file(c->ref_file, &c->ref_len);
+        RaschetkaOptions opt = {1, c->eps, 0, 0};
+        c->ctx = c->ref ? raschetka_create(&opt) : NULL;
+        if (!c->ctx) {
+            fprintf(stderr, "Ошибка подготовки eps %g\n", c->eps);
+            ok = 0;
+        }
+    }
+
+    int failures = 0;
+    for (int round = 0; round < ROUNDS && ok; round++) {
+        for (int i = 0; i < ncases; i++) {
+            Case *c = &cases[i];
+            if (!raschetka_run_file(c->ctx, drawing)) {
+                printf("eps %g, проход %d: %s\n", c->eps, round + 1, raschetka_error(c->ctx));
+                failures++;
+                continue;
+            }
+            size_t nv;
+            raschetka_vertices(c->ctx, &nv);
+            int same = same_as_ref(c);
+            printf("eps %g, проход %d: вершин %zu — %s\n", c->eps, round + 1, nv,
+                   same ? "как у try" : "РАСХОЖДЕНИЕ");
+            if (!same) failures++;
+        }
+    }
+
+    pthread_t *threads = ok ? (pthread_t *)calloc((size_t)ncases, sizeof(pthread_t)) : NULL;
+    if (ok && !threads) ok = 0;
+    int started = 0;
+    for (; started < ncases && ok; started++) {
+        cases[started].drawing = drawing;
+        if (pthread_create(&threads[started], NULL, run_concurrent, &cases[started]) != 0) {
+            fprintf(stderr, "Ошибка запуска потока\n");
+            ok = 0;
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    for (int i = 0; i < started && ok; i++) {
+        const Case *c = &cases[i];
+        printf("eps %g, одновременно с другими, %d прохода: %s", c->eps, ROUNDS,
+               c->errors + c->mismatches ? "" : "как у try\n");
+        if (c->errors + c->mismatches)
+            printf("ошибок %d, расхождений %d\n", c->errors, c->mismatches);
+        failures += c->errors + c->mismatches;
+    }
+    free(threads);
+
+    for (int i = 0; i < ncases; i++) {
+        if (cases[i].ctx) raschetka_destroy(cases[i].ctx);
+        free(cases[i].ref);
+    }
+    free(cases);
+    return ok && failures == 0 ? 0 : 1;
+}
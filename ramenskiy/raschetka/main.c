@@ -3,133 +3,44 @@
 #include <string.h>
 #include <math.h>
 #include <pthread.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "geom.h"
+#include "pointset.h"
+#include "sort.h"
+#include "../common/log.h"
 
-#define EPS 0.001
 #define DEFAULT_XY_FILE "xy.txt"
 #define DEFAULT_XZ_FILE "xz.txt"
 #define DEFAULT_YZ_FILE "yz.txt"
 
-/* Структуры точек для каждой проекции */
-typedef struct {
-    double x, y;
-} PointXY;
-
-typedef struct {
-    double x, z;
-} PointXZ;
-
-typedef struct {
-    double y, z;
-} PointYZ;
-
-typedef struct {
-    double x, y, z;
-} PointXYZ;
-
 /* Аргументы для потока сортировки */
 typedef struct {
     void *base;
     size_t nmemb;
-    size_t size;
-    int (*compar)(const void*, const void*);
+    int view;            // VIEW_TOP, VIEW_FRONT или VIEW_PROFILE
+    int ok;
 } SortThreadArg;
 
 /* ----------------------------------------- */
-/* Функции сравнения для сортировки */
-int cmp_xy(const void *a, const void *b) {
-    const PointXY *pa = (const PointXY*)a;
-    const PointXY *pb = (const PointXY*)b;
-    if (fabs(pa->x - pb->x) <= EPS) {
-        if (fabs(pa->y - pb->y) <= EPS) return 0;
-        return (pa->y < pb->y) ? -1 : 1;
-    }
-    return (pa->x < pb->x) ? -1 : 1;
-}
-
-int cmp_xz(const void *a, const void *b) {
-    const PointXZ *pa = (const PointXZ*)a;
-    const PointXZ *pb = (const PointXZ*)b;
-    if (fabs(pa->x - pb->x) <= EPS) {
-        if (fabs(pa->z - pb->z) <= EPS) return 0;
-        return (pa->z < pb->z) ? -1 : 1;
-    }
-    return (pa->x < pb->x) ? -1 : 1;
-}
-
-int cmp_yz(const void *a, const void *b) {
-    const PointYZ *pa = (const PointYZ*)a;
-    const PointYZ *pb = (const PointYZ*)b;
-    if (fabs(pa->y - pb->y) <= EPS) {
-        if (fabs(pa->z - pb->z) <= EPS) return 0;
-        return (pa->z < pb->z) ? -1 : 1;
-    }
-    return (pa->y < pb->y) ? -1 : 1;
-}
-
-/* ----------------------------------------- */
-/* Реализация быстрой сортировки */
-static void swap(void *a, void *b, size_t size) {
-    char *pa = (char*)a;
-    char *pb = (char*)b;
-    char tmp;
-    for (size_t i = 0; i < size; i++) {
-        tmp = pa[i];
-        pa[i] = pb[i];
-        pb[i] = tmp;
-    }
-}
-
-static void quicksort_impl(void *base, size_t lo, size_t hi, size_t size,
-                           int (*compar)(const void*, const void*)) {
-    if (lo >= hi) return;
-    
-    char *arr = (char*)base;
-    
-    // Выбираем медиану из трёх для лучшей производительности
-    size_t mid = lo + (hi - lo) / 2;
-    if (compar(arr + lo*size, arr + mid*size) > 0)
-        swap(arr + lo*size, arr + mid*size, size);
-    if (compar(arr + lo*size, arr + hi*size) > 0)
-        swap(arr + lo*size, arr + hi*size, size);
-    if (compar(arr + mid*size, arr + hi*size) > 0)
-        swap(arr + mid*size, arr + hi*size, size);
-    
-    // Ставим медиану в конец как опорный элемент
-    swap(arr + mid*size, arr + hi*size, size);
-    
-    size_t pivot = hi;
-    size_t i = lo;
-    
-    for (size_t j = lo; j < hi; j++) {
-        if (compar(arr + j*size, arr + pivot*size) <= 0) {
-            swap(arr + i*size, arr + j*size, size);
-            i++;
-        }
-    }
-    swap(arr + i*size, arr + pivot*size, size);
-    
-    if (i > lo) quicksort_impl(base, lo, i-1, size, compar);
-    if (i < hi) quicksort_impl(base, i+1, hi, size, compar);
-}
-
-void quicksort(void *base, size_t nmemb, size_t size,
-               int (*compar)(const void*, const void*)) {
-    if (nmemb <= 1) return;
-    quicksort_impl(base, 0, nmemb-1, size, compar);
-}
-
-/* Потоковая функция */
+/* Потоковая функция для сортировки */
 void* sort_thread(void *arg) {
     SortThreadArg *ta = (SortThreadArg*)arg;
-    printf("Thread sorting %zu elements...\n", ta->nmemb);
-    quicksort(ta->base, ta->nmemb, ta->size, ta->compar);
-    printf("Thread finished sorting\n");
+    if (ta->view == VIEW_TOP)
+        ta->ok = sort_xy((PointXY*)ta->base, ta->nmemb);
+    else if (ta->view == VIEW_FRONT)
+        ta->ok = sort_xz((PointXZ*)ta->base, ta->nmemb);
+    else
+        ta->ok = sort_yz((PointYZ*)ta->base, ta->nmemb);
     return NULL;
 }
 
 /* ----------------------------------------- */
-/* Чтение массивов из файлов */
-PointXY* read_xy(const char *filename, size_t *n) {
+/* Чтение массивов из файлов. Все массивы программы берутся из одной
+   арены: читаемый массив — последняя выдача, поэтому удвоение ёмкости
+   продлевает его на месте без копирования */
+PointXY* read_xy(Arena *arena, const char *filename, size_t *n) {
     FILE *f = fopen(filename, "r");
     if (!f) {
         perror(filename);
@@ -144,8 +55,9 @@ PointXY* read_xy(const char *filename, size_t *n) {
     printf("Reading XY from %s...\n", filename);
     while (fscanf(f, "%lf %lf", &x, &y) == 2) {
         if (count == capacity) {
+            size_t old_cap = capacity;
             capacity = capacity ? capacity * 2 : 16;
-            arr = realloc(arr, capacity * sizeof(PointXY));
+            arr = arena_grow(arena, arr, old_cap * sizeof(PointXY), capacity * sizeof(PointXY));
             if (!arr) { 
                 fclose(f); 
                 return NULL; 
@@ -153,7 +65,7 @@ PointXY* read_xy(const char *filename, size_t *n) {
         }
         arr[count].x = x;
         arr[count].y = y;
-        printf("  Read XY: %.3f %.3f\n", x, y);
+        log_debug("  Read XY: %.3f %.3f\n", x, y);
         count++;
     }
     fclose(f);
@@ -162,7 +74,7 @@ PointXY* read_xy(const char *filename, size_t *n) {
     return arr;
 }
 
-PointXZ* read_xz(const char *filename, size_t *n) {
+PointXZ* read_xz(Arena *arena, const char *filename, size_t *n) {
     FILE *f = fopen(filename, "r");
     if (!f) {
         perror(filename);
@@ -177,8 +89,9 @@ PointXZ* read_xz(const char *filename, size_t *n) {
     printf("Reading XZ from %s...\n", filename);
     while (fscanf(f, "%lf %lf", &x, &z) == 2) {
         if (count == capacity) {
+            size_t old_cap = capacity;
             capacity = capacity ? capacity * 2 : 16;
-            arr = realloc(arr, capacity * sizeof(PointXZ));
+            arr = arena_grow(arena, arr, old_cap * sizeof(PointXZ), capacity * sizeof(PointXZ));
             if (!arr) { 
                 fclose(f); 
                 return NULL; 
@@ -186,7 +99,7 @@ PointXZ* read_xz(const char *filename, size_t *n) {
         }
         arr[count].x = x;
         arr[count].z = z;
-        printf("  Read XZ: %.3f %.3f\n", x, z);
+        log_debug("  Read XZ: %.3f %.3f\n", x, z);
         count++;
     }
     fclose(f);
@@ -195,7 +108,7 @@ PointXZ* read_xz(const char *filename, size_t *n) {
     return arr;
 }
 
-PointYZ* read_yz(const char *filename, size_t *n) {
+PointYZ* read_yz(Arena *arena, const char *filename, size_t *n) {
     FILE *f = fopen(filename, "r");
     if (!f) {
         perror(filename);
@@ -210,8 +123,9 @@ PointYZ* read_yz(const char *filename, size_t *n) {
     printf("Reading YZ from %s...\n", filename);
     while (fscanf(f, "%lf %lf", &y, &z) == 2) {
         if (count == capacity) {
+            size_t old_cap = capacity;
             capacity = capacity ? capacity * 2 : 16;
-            arr = realloc(arr, capacity * sizeof(PointYZ));
+            arr = arena_grow(arena, arr, old_cap * sizeof(PointYZ), capacity * sizeof(PointYZ));
             if (!arr) { 
                 fclose(f); 
                 return NULL; 
@@ -219,7 +133,7 @@ PointYZ* read_yz(const char *filename, size_t *n) {
         }
         arr[count].y = y;
         arr[count].z = z;
-        printf("  Read YZ: %.3f %.3f\n", y, z);
+        log_debug("  Read YZ: %.3f %.3f\n", y, z);
         count++;
     }
     fclose(f);
@@ -229,13 +143,9 @@ PointYZ* read_yz(const char *filename, size_t *n) {
 }
 
 /* ----------------------------------------- */
-/* Проверка двух чисел на равенство с eps */
-static inline int approx_eq(double a, double b) {
-    return fabs(a - b) <= EPS;
-}
-
 /* Линейный поиск совпадений (более надёжный, чем бинарный с учётом погрешности) */
-PointXYZ* find_all_xyz_simple(const PointXY *xy, size_t nxy,
+PointXYZ* find_all_xyz_simple(Arena *arena,
+                              const PointXY *xy, size_t nxy,
                               const PointXZ *xz, size_t nxz,
                               const PointYZ *yz, size_t nyz,
                               size_t *out_cnt) {
@@ -249,13 +159,13 @@ PointXYZ* find_all_xyz_simple(const PointXY *xy, size_t nxy,
         double x = xy[i].x;
         double y = xy[i].y;
         
-        printf("Checking XY point (%.3f, %.3f)\n", x, y);
+        log_debug("Checking XY point (%.3f, %.3f)\n", x, y);
         
         // Ищем совпадения в XZ
         for (size_t j = 0; j < nxz; j++) {
             if (approx_eq(xz[j].x, x)) {
                 double z = xz[j].z;
-                printf("  Found XZ match: (%.3f, %.3f) with z=%.3f\n", xz[j].x, xz[j].z, z);
+                log_debug("  Found XZ match: (%.3f, %.3f) with z=%.3f\n", xz[j].x, xz[j].z, z);
                 
                 // Ищем совпадения в YZ
                 for (size_t k = 0; k < nyz; k++) {
@@ -265,8 +175,10 @@ PointXYZ* find_all_xyz_simple(const PointXY *xy, size_t nxy,
                         
                         // Добавляем точку
                         if (cnt == cap) {
+                            size_t old_cap = cap;
                             cap = cap ? cap * 2 : 16;
-                            result = realloc(result, cap * sizeof(PointXYZ));
+                            result = arena_grow(arena, result, old_cap * sizeof(PointXYZ),
+                                                cap * sizeof(PointXYZ));
                             if (!result) {
                                 fprintf(stderr, "Out of memory\n");
                                 *out_cnt = cnt;
@@ -277,6 +189,8 @@ PointXYZ* find_all_xyz_simple(const PointXY *xy, size_t nxy,
                         result[cnt].y = y;
                         result[cnt].z = z;
                         cnt++;
+                        // Тройка от k не зависит: одной точки YZ достаточно
+                        break;
                     }
                 }
             }
@@ -287,51 +201,63 @@ PointXYZ* find_all_xyz_simple(const PointXY *xy, size_t nxy,
     return result;
 }
 
-/*проверка, была ли уже эта точка*/
-int point_exists(PointXYZ *points, int count, PointXYZ new_point) {
-    for (int i = 0; i < count; i++) {
-        if (approx_eq(points[i].x, new_point.x) &&
-            approx_eq(points[i].y, new_point.y) &&
-            approx_eq(points[i].z, new_point.z)) {
-            return 1; // точка уже есть
-        }
-    }
-    return 0; // новой точки нет
-}
-
 /* ----------------------------------------- */
 int main(int argc, char *argv[]) {
     const char *xy_file = DEFAULT_XY_FILE;
     const char *xz_file = DEFAULT_XZ_FILE;
     const char *yz_file = DEFAULT_YZ_FILE;
 
-    if (argc >= 4) {
-        xy_file = argv[1];
-        xz_file = argv[2];
-        yz_file = argv[3];
+    // Необязательная точность: -e eps перед именами файлов
+    int arg = 1;
+    if (argc >= 3 && strcmp(argv[1], "-e") == 0) {
+        if (!geom_set_eps(strtod(argv[2], NULL))) {
+            fprintf(stderr, "Invalid eps: %s\n", argv[2]);
+            return 1;
+        }
+        arg = 3;
+    }
+
+    if (argc - arg >= 3) {
+        xy_file = argv[arg];
+        xz_file = argv[arg + 1];
+        yz_file = argv[arg + 2];
     } else {
-        printf("Usage: %s <xy_file> <xz_file> <yz_file>\n", argv[0]);
+        printf("Usage: %s [-e eps] <xy_file> <xz_file> <yz_file>\n", argv[0]);
         printf("Using default file names: %s, %s, %s\n", xy_file, xz_file, yz_file);
     }
 
+    // Арена на все массивы: по точке на строку "x y", то есть примерно
+    // по байту на байт текста, и столько же на найденные тройки
+    size_t estimate = 0;
+    const char *files[3] = {xy_file, xz_file, yz_file};
+    for (int i = 0; i < 3; i++) {
+        struct stat st;
+        if (stat(files[i], &st) == 0) estimate += 2 * (size_t)st.st_size;
+    }
+    Arena arena;
+    if (!arena_init(&arena, estimate)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
     // Чтение массивов
     size_t nxy, nxz, nyz;
-    PointXY *xy = read_xy(xy_file, &nxy);
-    PointXZ *xz = read_xz(xz_file, &nxz);
-    PointYZ *yz = read_yz(yz_file, &nyz);
+    PointXY *xy = read_xy(&arena, xy_file, &nxy);
+    PointXZ *xz = read_xz(&arena, xz_file, &nxz);
+    PointYZ *yz = read_yz(&arena, yz_file, &nyz);
 
     if (!xy || !xz || !yz) {
         fprintf(stderr, "Error reading input files\n");
-        free(xy); free(xz); free(yz);
+        arena_free(&arena);
         return 1;
     }
 
     printf("\nRead %zu XY points, %zu XZ points, %zu YZ points\n", nxy, nxz, nyz);
 
     // Подготовка аргументов для потоков сортировки
-    SortThreadArg arg_xy = {xy, nxy, sizeof(PointXY), cmp_xy};
-    SortThreadArg arg_xz = {xz, nxz, sizeof(PointXZ), cmp_xz};
-    SortThreadArg arg_yz = {yz, nyz, sizeof(PointYZ), cmp_yz};
+    SortThreadArg arg_xy = {xy, nxy, VIEW_TOP, 0};
+    SortThreadArg arg_xz = {xz, nxz, VIEW_FRONT, 0};
+    SortThreadArg arg_yz = {yz, nyz, VIEW_PROFILE, 0};
 
     pthread_t thread_xy, thread_xz, thread_yz;
 
@@ -340,20 +266,20 @@ int main(int argc, char *argv[]) {
     // Создание потоков
     if (pthread_create(&thread_xy, NULL, sort_thread, &arg_xy) != 0) {
         perror("pthread_create xy");
-        free(xy); free(xz); free(yz);
+        arena_free(&arena);
         return 1;
     }
     if (pthread_create(&thread_xz, NULL, sort_thread, &arg_xz) != 0) {
         perror("pthread_create xz");
         pthread_cancel(thread_xy);
-        free(xy); free(xz); free(yz);
+        arena_free(&arena);
         return 1;
     }
     if (pthread_create(&thread_yz, NULL, sort_thread, &arg_yz) != 0) {
         perror("pthread_create yz");
         pthread_cancel(thread_xy);
         pthread_cancel(thread_xz);
-        free(xy); free(xz); free(yz);
+        arena_free(&arena);
         return 1;
     }
 
@@ -362,66 +288,44 @@ int main(int argc, char *argv[]) {
     pthread_join(thread_xz, NULL);
     pthread_join(thread_yz, NULL);
 
-    printf("\nSorting completed\n");
-
-    // Вывод отсортированных массивов для проверки
-    printf("\nSorted XY points:\n");
-    for (size_t i = 0; i < nxy; i++) {
-        printf("  XY[%zu]: %.3f %.3f\n", i, xy[i].x, xy[i].y);
-    }
-    
-    printf("\nSorted XZ points:\n");
-    for (size_t i = 0; i < nxz; i++) {
-        printf("  XZ[%zu]: %.3f %.3f\n", i, xz[i].x, xz[i].z);
-    }
-    
-    printf("\nSorted YZ points:\n");
-    for (size_t i = 0; i < nyz; i++) {
-        printf("  YZ[%zu]: %.3f %.3f\n", i, yz[i].y, yz[i].z);
+    if (!arg_xy.ok || !arg_xz.ok || !arg_yz.ok) {
+        fprintf(stderr, "Out of memory while sorting\n");
+        arena_free(&arena);
+        return 1;
     }
 
+    printf("\nSorting completed\n");
+
     // Поиск всех троек (используем простой линейный поиск для надёжности)
     size_t nxyz;
-    PointXYZ *xyz = find_all_xyz_simple(xy, nxy, xz, nxz, yz, nyz, &nxyz);
+    PointXYZ *xyz = find_all_xyz_simple(&arena, xy, nxy, xz, nxz, yz, nyz, &nxyz);
+    if (!xyz && nxyz > 0) {
+        arena_free(&arena);
+        return 1;
+    }
 
      // ========== ПОИСК И ВЫВОД ТОЛЬКО УНИКАЛЬНЫХ ТОЧЕК ==========
     printf("\n========================================================\n");
     printf("RESULTS (UNIQUE 3D POINTS):\n");
     
-    PointXYZ *unique_points = NULL;
-    int unique_count = 0;
-    int found_count = 0;
+    PointSet unique;
+    if (!pointset_init(&unique, 1024)) {
+        fprintf(stderr, "Out of memory\n");
+        arena_free(&arena);
+        return 1;
+    }
+    size_t found_count = nxyz;
     
-    for (size_t i = 0; i < nxy; i++) {
-        double x = xy[i].x;
-        double y = xy[i].y;
-        
-        for (size_t j = 0; j < nxz; j++) {
-            if (approx_eq(xz[j].x, x)) {
-                double z = xz[j].z;
-                
-                for (size_t k = 0; k < nyz; k++) {
-                    if (approx_eq(yz[k].y, y) && approx_eq(yz[k].z, z)) {
-                        found_count++;
-                        
-                        PointXYZ new_point = {x, y, z};
-                        
-                        // Проверяем, не выводили ли уже такую точку
-                        if (!point_exists(unique_points, unique_count, new_point)) {
-                            unique_count++;
-                            unique_points = realloc(unique_points, unique_count * sizeof(PointXYZ));
-                            unique_points[unique_count-1] = new_point;
-                            printf("  Point %d: (%.6f, %.6f, %.6f)\n", unique_count, x, y, z);
-                        }
-                        break;
-                    }
-                }
-            }
+    // Тройки идут в порядке перебора: первая из совпадающих с точностью
+    // EPS выводится, остальные отбрасываются
+    for (size_t i = 0; i < nxyz; i++) {
+        if (pointset_insert(&unique, xyz[i]) > 0) {
+            printf("  Point %zu: (%.6f, %.6f, %.6f)\n", unique.n, xyz[i].x, xyz[i].y, xyz[i].z);
         }
     }
     
-    printf("\nTotal matches found: %d\n", found_count);
-    printf("Unique 3D points: %d (eps = %.3f)\n", unique_count, EPS);
+    printf("\nTotal matches found: %zu\n", found_count);
+    printf("Unique 3D points: %zu (eps = %g)\n", unique.n, EPS);
 
     // Вывод результатов
     // printf("\n========================================================\n");
@@ -441,10 +345,8 @@ int main(int argc, char *argv[]) {
     printf("========================================================\n");
 
     // Освобождение памяти
-    free(xy);
-    free(xz);
-    free(yz);
-    free(xyz);
+    arena_free(&arena);
+    pointset_free(&unique);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "extsort.h"
+#include "ooc.h"
+#include "parse.h"
+#include "sort.h"
+
+/* Сортировок, живущих одновременно: три вида и пары соединения */
+#define OOC_SORTERS 4
+
+/* Ключи сетки для сравнения: размер ячейки задан на весь запуск */
+static double ooc_inv;
+
+static inline long long key(double v) {
+    return grid_key(v, ooc_inv);
+}
+
+static inline int cmp_ll(long long a, long long b) {
+    return (a > b) - (a < b);
+}
+
+/* ----------------------------------------- */
+/* Точки видов: две координаты в порядке вида, как PointXY/XZ/YZ */
+typedef struct {
+    double a, b;
+} ViewRec;
+
+static int cmp_view(const void *pa, const void *pb) {
+    const ViewRec *p = (const ViewRec *)pa, *q = (const ViewRec *)pb;
+    int c = cmp_ll(key(p->a), key(q->a));
+    return c ? c : cmp_ll(key(p->b), key(q->b));
+}
+
+static int run_xz(void *a, size_t n) { return sort_xz((PointXZ *)a, n); }
+static int run_yz(void *a, size_t n) { return sort_yz((PointYZ *)a, n); }
+static int run_xy(void *a, size_t n) { return sort_xy((PointXY *)a, n); }
+
+/* Пара XY–XZ: кандидат в вершины до проверки по YZ. i, j — номера
+   точек в сжатых видах XY и XZ, w — вклад в число совпадений */
+typedef struct {
+    double x, y, z;
+    uint64_t i, j, w;
+} OocCand;
+
+static int cmp_cand_yz(const void *pa, const void *pb) {
+    const OocCand *p = (const OocCand *)pa, *q = (const OocCand *)pb;
+    int c = cmp_ll(key(p->y), key(q->y));
+    if (!c) c = cmp_ll(key(p->z), key(q->z));
+    if (!c) c = (p->i > q->i) - (p->i < q->i);
+    if (!c) c = (p->j > q->j) - (p->j < q->j);
+    return c;
+}
+
+/* Порядок перебора join_xyz: по номеру в XY, затем в XZ */
+static int cmp_cand_order(const void *pa, const void *pb) {
+    const OocCand *p = (const OocCand *)pa, *q = (const OocCand *)pb;
+    int c = (p->i > q->i) - (p->i < q->i);
+    return c ? c : (p->j > q->j) - (p->j < q->j);
+}
+
+/* ----------------------------------------- */
+/* Сжатый поток вида: различные точки по порядку с кратностями.
+   Точные повторы имеют одинаковые ключи, поэтому ищутся только среди
+   точек текущей ячейки — группы записей с равными ключами */
+typedef struct {
+    double a, b;
+    uint32_t mult;
+} ViewEntry;
+
+typedef struct {
+    ExtSort *es;
+    ViewEntry *grp;
+    size_t ngrp, cap, pos;
+    ViewRec pend;          // первая запись следующей группы
+    int has_pend;
+    size_t count;          // выдано различных точек
+    int ok;
+} ViewStream;
+
+static void view_stream_init(ViewStream *v, ExtSort *es) {
+    memset(v, 0, sizeof(*v));
+    v->es = es;
+    v->ok = 1;
+    v->has_pend = extsort_next(es, &v->pend);
+}
+
+/* Следующая различная точка; 0 — поток кончился или ошибка */
+static int view_stream_next(ViewStream *v, ViewEntry *e) {
+    if (v->pos == v->ngrp) {
+        v->ngrp = v->pos = 0;
+        if (!v->has_pend) return 0;
+        long long ka = key(v->pend.a), kb = key(v->pend.b);
+        do {
+            ViewRec r = v->pend;
+            size_t k = 0;
+            while (k < v->ngrp && !(v->grp[k].a == r.a && v->grp[k].b == r.b &&
+                                    v->grp[k].mult < UINT32_MAX))
+                k++;
+            if (k < v->ngrp) {
+                v->grp[k].mult++;
+            } else {
+                if (v->ngrp == v->cap) {
+                    size_t cap = v->cap ? v->cap * 2 : 16;
+                    ViewEntry *resized = (ViewEntry *)realloc(v->grp, cap * sizeof(ViewEntry));
+                    if (!resized) {
+                        v->ok = 0;
+                        return 0;
+                    }
+                    v->grp = resized;
+                    v->cap = cap;
+                }
+                v->grp[v->ngrp++] = (ViewEntry){r.a, r.b, 1};
+            }
+            v->has_pend = extsort_next(v->es, &v->pend);
+        } while (v->has_pend && key(v->pend.a) == ka && key(v->pend.b) == kb);
+    }
+    *e = v->grp[v->pos++];
+    v->count++;
+    return 1;
+}
+
+static void view_stream_free(ViewStream *v) {
+    free(v->grp);
+    memset(v, 0, sizeof(*v));
+}
+
+/* ----------------------------------------- */
+/* Окно точек вида по первой координате: точки приходят по возрастанию
+   ключей, слева уходят вышедшие из окна */
+typedef struct {
+    long long ka, kb;
+    ViewEntry e;
+    uint64_t idx;          // номер точки в сжатом виде
+} WinEntry;
+
+typedef struct {
+    WinEntry *w;
+    size_t head, n, cap;   // занято [head, n)
+} Window;
+
+static int window_push(Window *win, const ViewEntry *e, uint64_t idx) {
+    if (win->n == win->cap) {
+        // Сначала сдвиг к началу, если ушла половина
+        if (win->head > 0 && win->head >= win->n / 2) {
+            memmove(win->w, win->w + win->head, (win->n - win->head) * sizeof(WinEntry));
+            win->n -= win->head;
+            win->head = 0;
+        } else {
+            size_t cap = win->cap ? win->cap * 2 : 256;
+            WinEntry *resized = (WinEntry *)realloc(win->w, cap * sizeof(WinEntry));
+            if (!resized) return 0;
+            win->w = resized;
+            win->cap = cap;
+        }
+    }
+    win->w[win->n++] = (WinEntry){key(e->a), key(e->b), *e, idx};
+    return 1;
+}
+
+static void window_drop(Window *win, long long ka_min) {
+    while (win->head < win->n && win->w[win->head].ka < ka_min) win->head++;
+}
+
+/* Есть ли в окне точка (a, b) с точностью EPS: по каждой из соседних
+   строк ключа ka — двоичный поиск начала диапазона kb */
+static int window_has(const Window *win, double a, double b, long long r) {
+    long long ka = key(a), kb = key(b);
+    for (long long da = -r; da <= r; da++) {
+        long long ta = ka + da, tb = kb - r;
+        size_t lo = win->head, hi = win->n;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            const WinEntry *m = &win->w[mid];
+            if (m->ka < ta || (m->ka == ta && m->kb < tb)) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t k = lo; k < win->n && win->w[k].ka == ta && win->w[k].kb <= kb + r; k++) {
+            if (approx_eq(win->w[k].e.a, a) && approx_eq(win->w[k].e.b, b)) return 1;
+        }
+    }
+    return 0;
+}
+
+/* ----------------------------------------- */
+static int sink_view(void *ctx, int view, double a, double b) {
+    ExtSort *views = (ExtSort *)ctx;
+    ViewRec r = {a, b};
+    return extsort_add(&views[view], &r);
+}
+
+/* Соединение XY и XZ по x: пары в cand */
+static int join_xy_xz(ViewStream *xy, ViewStream *xz, ExtSort *cand) {
+    long long r = grid_reach();
+    Window win = {NULL, 0, 0, 0};
+    ViewEntry next, p;
+    int have_next = view_stream_next(xz, &next);
+    uint64_t j = 0;
+    int ok = 1;
+
+    for (uint64_t i = 0; ok && view_stream_next(xy, &p); i++) {
+        long long kx = key(p.a);
+        window_drop(&win, kx - r);
+        while (ok && have_next && key(next.a) <= kx + r) {
+            ok = window_push(&win, &next, j++);
+            have_next = view_stream_next(xz, &next);
+        }
+        for (size_t k = win.head; ok && k < win.n; k++) {
+            const WinEntry *e = &win.w[k];
+            if (!approx_eq(e->e.a, p.a)) continue;
+            OocCand c = {p.a, p.b, e->e.b, i, e->idx, (uint64_t)p.mult * e->e.mult};
+            ok = extsort_add(cand, &c);
+        }
+    }
+    // Остаток XZ дочитывается ради числа различных точек
+    while (ok && have_next) have_next = view_stream_next(xz, &next);
+    free(win.w);
+    return ok && xy->ok && xz->ok && xy->es->ok && xz->es->ok;
+}
+
+/* Проверка пар по YZ: совпавшие — в matched, их вклад — в found */
+static int join_yz(ExtSort *cand, ViewStream *yz, ExtSort *matched, size_t *found) {
+    long long r = grid_reach();
+    Window win = {NULL, 0, 0, 0};
+    ViewEntry next;
+    int have_next = view_stream_next(yz, &next);
+    OocCand c;
+    int ok = 1;
+
+    while (ok && extsort_next(cand, &c)) {
+        long long ky = key(c.y);
+        window_drop(&win, ky - r);
+        while (ok && have_next && key(next.a) <= ky + r) {
+            ok = window_push(&win, &next, 0);
+            have_next = view_stream_next(yz, &next);
+        }
+        if (ok && window_has(&win, c.y, c.z, r)) {
+            *found += (size_t)c.w;
+            ok = extsort_add(matched, &c);
+        }
+    }
+    // Остаток YZ дочитывается ради числа различных точек
+    while (ok && have_next) have_next = view_stream_next(yz, &next);
+    free(win.w);
+    return ok && cand->ok && yz->ok && yz->es->ok;
+}
+
+/* ----------------------------------------- */
+static void collect_stats(OocResult *r, const ExtSort *s) {
+    r->spilled += s->spilled;
+    r->read_back += s->read_back;
+    r->runs += s->runs_made;
+    r->passes += s->passes;
+}
+
+int ooc_reconstruct(const char *filename, size_t budget, OocResult *r, StageTimes *t) {
+    memset(r, 0, sizeof(*r));
+    ooc_inv = grid_inv_cell();
+    size_t part = budget / OOC_SORTERS;
+
+    static const ExtSortRun run_sort[VIEW_COUNT] = {run_xz, run_yz, run_xy};
+    ExtSort views[VIEW_COUNT], cand, matched;
+    memset(views, 0, sizeof(views));
+    memset(&cand, 0, sizeof(cand));
+    memset(&matched, 0, sizeof(matched));
+    for (int v = 0; v < VIEW_COUNT; v++) views[v].fd = -1;
+    cand.fd = matched.fd = -1;
+    ViewStream sxy, sxz, syz;
+    memset(&sxy, 0, sizeof(sxy));
+    memset(&sxz, 0, sizeof(sxz));
+    memset(&syz, 0, sizeof(syz));
+
+    int ok = pointset_init(&r->verts, 1024);
+    for (int v = 0; ok && v < VIEW_COUNT; v++)
+        ok = extsort_init(&views[v], sizeof(ViewRec), part, cmp_view, run_sort[v]);
+
+    // Чтение: точки уходят в прогоны видов
+    timing_begin(t, STAGE_READ);
+    Projections pr;
+    if (ok && !parse_projections_stream(filename, sink_view, views, &pr)) {
+        // Разбор прерывается и отказом записи прогона — тогда файл ни при чём
+        r->data_error = views[0].ok && views[1].ok && views[2].ok;
+        ok = 0;
+    }
+    timing_end(t, STAGE_READ);
+    if (ok) {
+        r->nxy_raw = pr.nxy_raw;
+        r->nxz_raw = pr.nxz_raw;
+        r->nyz_raw = pr.nyz_raw;
+        r->near_boundary = pr.near_boundary;
+        memcpy(r->lcs, pr.lcs, sizeof(r->lcs));
+        ok = r->nxy_raw > 0 && r->nxz_raw > 0 && r->nyz_raw > 0;
+        r->data_error = !ok;
+    }
+
+    // Слияние прогонов видов
+    timing_begin(t, STAGE_SORT);
+    for (int v = 0; ok && v < VIEW_COUNT; v++) ok = extsort_finish(&views[v]);
+    timing_end(t, STAGE_SORT);
+
+    timing_begin(t, STAGE_JOIN);
+    if (ok) {
+        view_stream_init(&sxy, &views[VIEW_TOP]);
+        view_stream_init(&sxz, &views[VIEW_FRONT]);
+        view_stream_init(&syz, &views[VIEW_PROFILE]);
+        ok = extsort_init(&cand, sizeof(OocCand), part, cmp_cand_yz, NULL) &&
+             join_xy_xz(&sxy, &sxz, &cand);
+    }
+    if (ok) {
+        r->nxy = sxy.count;
+        r->nxz = sxz.count;
+        // Виды XY и XZ прочитаны — их память идёт парам
+        collect_stats(r, &views[VIEW_TOP]);
+        collect_stats(r, &views[VIEW_FRONT]);
+        extsort_free(&views[VIEW_TOP]);
+        extsort_free(&views[VIEW_FRONT]);
+        ok = extsort_finish(&cand) &&
+             extsort_init(&matched, sizeof(OocCand), part, cmp_cand_order, NULL) &&
+             join_yz(&cand, &syz, &matched, &r->found) &&
+             extsort_finish(&matched);
+        r->nyz = syz.count;
+    }
+    timing_end(t, STAGE_JOIN);
+
+    // Отбор вершин в порядке перебора try
+    timing_begin(t, STAGE_DEDUP);
+    OocCand c;
+    while (ok && extsort_next(&matched, &c)) {
+        ok = pointset_insert(&r->verts, (PointXYZ){c.x, c.y, c.z}) >= 0;
+    }
+    ok = ok && matched.ok;
+    timing_end(t, STAGE_DEDUP);
+
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        collect_stats(r, &views[v]);
+        extsort_free(&views[v]);
+    }
+    collect_stats(r, &cand);
+    collect_stats(r, &matched);
+    extsort_free(&cand);
+    extsort_free(&matched);
+    view_stream_free(&sxy);
+    view_stream_free(&sxz);
+    view_stream_free(&syz);
+
+    // Размеры видов и причина остаются для сообщения об ошибке
+    if (!ok) pointset_free(&r->verts);
+    return ok;
+}
+
+void ooc_result_free(OocResult *r) {
+    pointset_free(&r->verts);
+    memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,47 @@
+#ifndef OOC_H
+#define OOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "geom.h"
+#include "pointset.h"
+#include "timing.h"
+
+/* Восстановление чертежа больше оперативной памяти (режим try -m).
+   Файл читается одним потоковым проходом (parse_projections_stream),
+   точки каждого вида уходят во внешнюю сортировку (extsort.h) с тем же
+   порядком, что sort_projections; повторы сливаются с кратностью
+   прямо при слиянии прогонов, как в compact_projections.
+   Соединение — два сортирующих слияния:
+     1) XY и XZ, оба по x: окно XZ на несколько ячеек по x скользит
+        вместе с XY, пары (x, y, z) идут во внешнюю сортировку по (y, z);
+     2) пары и YZ, обе по (y, z): окно YZ на несколько ячеек по y,
+        совпавшие пары сортируются обратно в порядок перебора try.
+   Вершины и счётчики совпадают с try; рёбра не строятся — индекс
+   отрезков требует всех отрезков чертежа в памяти.
+   Бюджет делится поровну между четырьмя одновременно живущими
+   сортировками; окна соединения в бюджет не входят, они держат
+   точки нескольких ячеек сетки */
+
+typedef struct {
+    PointSet verts;
+    size_t nxy_raw, nxz_raw, nyz_raw;   // точек в файле
+    size_t nxy, nxz, nyz;               // различных точек
+    size_t found;          // всего совпадений, как у join_xyz
+    double lcs[VIEW_COUNT][2];
+    size_t near_boundary;
+    uint64_t spilled;      // записано во временные файлы, байт
+    uint64_t read_back;    // прочитано обратно, байт
+    size_t runs;           // прогонов всех сортировок
+    size_t passes;         // проходов слияния
+    int data_error;        // при ошибке: файл не прочитан или пустой вид
+} OocResult;
+
+/* budget — память на буферы сортировок, байт. Этапы отмечаются в t
+   (чтение, сортировка, соединение, отбор). Пустой вид — ошибка
+   с data_error, иначе ошибка — нехватка памяти или места на диске.
+   Возвращает 1 при успехе */
+int ooc_reconstruct(const char *filename, size_t budget, OocResult *r, StageTimes *t);
+void ooc_result_free(OocResult *r);
+
+#endif
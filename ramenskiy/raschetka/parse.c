@@ -0,0 +1,512 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parse.h"
+
+/* Типы строк чертежа */
+enum {
+    LINE_EMPTY,
+    LINE_NUMBER,
+    LINE_FRONT,
+    LINE_PROFILE,
+    LINE_TOP,
+    LINE_END,      // "3D points" — дальше идут результаты, не проекции
+    LINE_LCSX,
+    LINE_LCSY,
+    LINE_SKIP
+};
+
+/* Строка только из цифр, знаков, разделителей и пробелов */
+static int is_plain_number(const char *p, const char *end) {
+    if (p == end) return 0;
+    for (; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == ',' ||
+              c == '.' || c == ' ' || c == '\t' || c == '\r'))
+            return 0;
+    }
+    return 1;
+}
+
+static int line_has(const char *p, const char *end, const char *word) {
+    size_t wl = strlen(word);
+    for (; p + wl <= end; p++) {
+        if (*p == word[0] && memcmp(p, word, wl) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Классификация строки: ключевые слова проверяются в том же порядке,
+   что и в прежнем построчном чтении */
+static int classify_line(const char *p, const char *end) {
+    if (p == end) return LINE_EMPTY;
+    if (is_plain_number(p, end)) return LINE_NUMBER;
+
+    if (line_has(p, end, "frontView")) return LINE_FRONT;
+    if (line_has(p, end, "profileView")) return LINE_PROFILE;
+    if (line_has(p, end, "topView")) return LINE_TOP;
+    if (line_has(p, end, "3D points")) return LINE_END;
+    if (line_has(p, end, "lcsX")) return LINE_LCSX;
+    if (line_has(p, end, "lcsY")) return LINE_LCSY;
+    if (line_has(p, end, "3D edges") || line_has(p, end, "Algorithm") ||
+        line_has(p, end, "Read plot") || line_has(p, end, "Get wires"))
+        return LINE_SKIP;
+    // Прочие строки разбираются как число, если начинаются с числа
+    return LINE_NUMBER;
+}
+
+static const double pow10_tab[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Разбор числа с разделителем '.' или ',' прямо из буфера.
+   Мантисса до 2^53 и не более 22 знаков после запятой дают точно
+   округлённый результат одним делением — так же, как strtod.
+   Остальные случаи уходят в strtod через короткую копию */
+static int parse_number(const char *p, const char *end, double *out) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char *start = p;
+
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+
+    uint64_t mant = 0;
+    int digits = 0, frac = 0, exact = 1;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (mant < (1ULL << 53) / 10) mant = mant * 10 + (uint64_t)(*p - '0');
+        else exact = 0;
+        digits++;
+        p++;
+    }
+    if (p < end && (*p == '.' || *p == ',')) {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (mant < (1ULL << 53) / 10) mant = mant * 10 + (uint64_t)(*p - '0');
+            else exact = 0;
+            digits++;
+            frac++;
+            p++;
+        }
+    }
+    if (digits == 0) return 0;
+    if (p < end && (*p == 'e' || *p == 'E')) exact = 0;
+
+    if (exact && frac <= 22) {
+        double v = (double)mant / pow10_tab[frac];
+        *out = neg ? -v : v;
+        return 1;
+    }
+
+    char tmp[128];
+    size_t len = (size_t)(end - start);
+    if (len >= sizeof(tmp)) len = sizeof(tmp) - 1;
+    memcpy(tmp, start, len);
+    tmp[len] = '\0';
+    char *comma = strchr(tmp, ',');
+    if (comma) *comma = '.';
+    char *stop;
+    *out = strtod(tmp, &stop);
+    return stop != tmp;
+}
+
+/* Конец строки (без '\n') */
+static inline const char *line_end(const char *p, const char *end) {
+    const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl : end;
+}
+
+/* ----------------------------------------- */
+/* Секция одного вида */
+typedef struct {
+    int view;
+    const char *begin, *end;
+    size_t lines;          // верхняя граница числа значений
+    void *pts;             // PointXZ / PointYZ / PointXY по виду
+    size_t n;
+    size_t near;           // координат у границы узлов (режим квантования)
+    Arena *arena;
+    int ok;
+} Section;
+
+typedef struct {
+    Section *secs;
+    size_t nsecs, cap;
+} SectionList;
+
+static int section_open(SectionList *l, int view, const char *begin) {
+    if (l->nsecs == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 4;
+        Section *resized = (Section *)realloc(l->secs, cap * sizeof(Section));
+        if (!resized) return 0;
+        l->secs = resized;
+        l->cap = cap;
+    }
+    Section *s = &l->secs[l->nsecs++];
+    memset(s, 0, sizeof(*s));
+    s->view = view;
+    s->begin = s->end = begin;
+    return 1;
+}
+
+/* Первый проход: границы секций и значения lcsX/lcsY */
+static int scan_sections(const char *buf, size_t len, SectionList *l,
+                         Projections *pr) {
+    const char *p = buf, *end = buf + len;
+    Section *cur = NULL;
+
+    while (p < end) {
+        const char *le = line_end(p, end);
+        const char *next = le < end ? le + 1 : end;
+        int kind = classify_line(p, le);
+
+        if (kind == LINE_FRONT || kind == LINE_PROFILE || kind == LINE_TOP) {
+            int view = kind == LINE_FRONT ? VIEW_FRONT :
+                       kind == LINE_PROFILE ? VIEW_PROFILE : VIEW_TOP;
+            if (!section_open(l, view, next)) return 0;
+            cur = &l->secs[l->nsecs - 1];
+        } else if (kind == LINE_END) {
+            break;
+        } else if (cur) {
+            if (kind == LINE_LCSX || kind == LINE_LCSY) {
+                const char *eq = (const char *)memchr(p, '=', (size_t)(le - p));
+                double v;
+                if (eq && parse_number(eq + 1, le, &v))
+                    pr->lcs[cur->view][kind == LINE_LCSY] = v;
+            } else if (kind == LINE_NUMBER) {
+                cur->lines++;
+            }
+            cur->end = next;
+        }
+        p = next;
+    }
+    return 1;
+}
+
+static const size_t view_size[VIEW_COUNT] = {
+    sizeof(PointXZ), sizeof(PointYZ), sizeof(PointXY)
+};
+
+/* Второй проход: разбор значений одной секции парами */
+static void parse_section_task(void *arg, size_t task) {
+    Section *s = &((Section*)arg)[task];
+    size_t cap = s->lines / 2 + 1;
+    s->pts = arena_or_malloc(s->arena, cap * view_size[s->view]);
+    s->ok = s->pts != NULL;
+    if (!s->ok) return;
+
+    const char *p = s->begin;
+    int waiting_second = 0;
+    double saved = 0.0;
+
+    while (p < s->end) {
+        const char *le = line_end(p, s->end);
+        const char *next = le < s->end ? le + 1 : s->end;
+        double value;
+
+        if (classify_line(p, le) == LINE_NUMBER && parse_number(p, le, &value)) {
+            if (geom_step > 0.0) value = geom_snap(value, &s->near);
+            if (!waiting_second) {
+                saved = value;
+                waiting_second = 1;
+            } else {
+                if (s->view == VIEW_FRONT)
+                    ((PointXZ*)s->pts)[s->n] = (PointXZ){saved, value};
+                else if (s->view == VIEW_PROFILE)
+                    ((PointYZ*)s->pts)[s->n] = (PointYZ){saved, value};
+                else
+                    ((PointXY*)s->pts)[s->n] = (PointXY){saved, value};
+                s->n++;
+                waiting_second = 0;
+            }
+        }
+        p = next;
+    }
+}
+
+/* Склейка секций одного вида в один массив */
+static void *collect_view(SectionList *l, Arena *arena, int view, size_t *n_out, int *ok) {
+    size_t total = 0, count = 0;
+    Section *single = NULL;
+    for (size_t i = 0; i < l->nsecs; i++) {
+        if (l->secs[i].view != view) continue;
+        total += l->secs[i].n;
+        single = &l->secs[i];
+        count++;
+    }
+    *n_out = total;
+
+    // Обычно секция вида одна — её буфер отдаётся без копирования
+    if (count == 1) {
+        void *pts = single->pts;
+        single->pts = NULL;
+        return pts;
+    }
+
+    char *pts = (char *)arena_or_malloc(arena, total * view_size[view]);
+    if (!pts) {
+        *ok = 0;
+        return NULL;
+    }
+    size_t off = 0;
+    for (size_t i = 0; i < l->nsecs; i++) {
+        if (l->secs[i].view != view) continue;
+        memcpy(pts + off, l->secs[i].pts, l->secs[i].n * view_size[view]);
+        off += l->secs[i].n * view_size[view];
+    }
+    return pts;
+}
+
+int parse_projections_buf(WorkerPool *pool, Arena *arena, const char *buf, size_t len,
+                          Projections *pr) {
+    memset(pr, 0, sizeof(*pr));
+    pr->arena = arena;
+
+    SectionList l = {NULL, 0, 0};
+    int ok = scan_sections(buf, len, &l, pr);
+
+    if (ok) {
+        for (size_t i = 0; i < l.nsecs; i++) l.secs[i].arena = arena;
+        if (pool) {
+            pool_run(pool, parse_section_task, l.secs, l.nsecs);
+        } else {
+            for (size_t i = 0; i < l.nsecs; i++) parse_section_task(l.secs, i);
+        }
+        for (size_t i = 0; i < l.nsecs; i++) {
+            ok = ok && l.secs[i].ok;
+            pr->near_boundary += l.secs[i].near;
+        }
+    }
+
+    if (ok) {
+        pr->xz = (PointXZ *)collect_view(&l, arena, VIEW_FRONT, &pr->nxz, &ok);
+        pr->yz = (PointYZ *)collect_view(&l, arena, VIEW_PROFILE, &pr->nyz, &ok);
+        pr->xy = (PointXY *)collect_view(&l, arena, VIEW_TOP, &pr->nxy, &ok);
+        pr->nxy_raw = pr->nxy;
+        pr->nxz_raw = pr->nxz;
+        pr->nyz_raw = pr->nyz;
+    }
+
+    for (size_t i = 0; i < l.nsecs; i++) arena_or_free(arena, l.secs[i].pts);
+    free(l.secs);
+
+    if (!ok) {
+        projections_free(pr);
+        return 0;
+    }
+    return 1;
+}
+
+/* Копия массива вида; в режиме квантования — с заменой координат узлами */
+static void *copy_view(Arena *arena, const void *src, size_t n, int view, size_t *near) {
+    double *dst = (double *)arena_or_malloc(arena, n * view_size[view]);
+    if (!dst) return NULL;
+    if (n > 0) memcpy(dst, src, n * view_size[view]);
+    if (geom_step > 0.0) {
+        for (size_t i = 0; i < 2 * n; i++) dst[i] = geom_snap(dst[i], near);
+    }
+    return dst;
+}
+
+int projections_from_views(Arena *arena, const PointXY *xy, size_t nxy,
+                           const PointXZ *xz, size_t nxz,
+                           const PointYZ *yz, size_t nyz, Projections *pr) {
+    memset(pr, 0, sizeof(*pr));
+    pr->arena = arena;
+    pr->xy = (PointXY *)copy_view(arena, xy, nxy, VIEW_TOP, &pr->near_boundary);
+    pr->xz = (PointXZ *)copy_view(arena, xz, nxz, VIEW_FRONT, &pr->near_boundary);
+    pr->yz = (PointYZ *)copy_view(arena, yz, nyz, VIEW_PROFILE, &pr->near_boundary);
+    if (!pr->xy || !pr->xz || !pr->yz) {
+        projections_free(pr);
+        return 0;
+    }
+    pr->nxy = pr->nxy_raw = nxy;
+    pr->nxz = pr->nxz_raw = nxz;
+    pr->nyz = pr->nyz_raw = nyz;
+    return 1;
+}
+
+/* Отображение файла в память только для чтения; пустой файл даёт "" */
+static const char *map_file(const char *filename, size_t *len) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("fstat");
+        close(fd);
+        return NULL;
+    }
+
+    *len = (size_t)st.st_size;
+    if (*len == 0) {
+        close(fd);
+        return "";
+    }
+
+    void *map = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    madvise(map, *len, MADV_WILLNEED);
+    return (const char *)map;
+}
+
+static void unmap_file(const char *map, size_t len) {
+    if (len) munmap((void *)map, len);
+}
+
+int parse_projections(WorkerPool *pool, Arena *arena, const char *filename,
+                      Projections *pr) {
+    memset(pr, 0, sizeof(*pr));
+
+    size_t len;
+    const char *map = map_file(filename, &len);
+    if (!map) return 0;
+
+    int ok = parse_projections_buf(pool, arena, map, len, pr);
+    unmap_file(map, len);
+    return ok;
+}
+
+/* Прочитанная часть отображения отдаётся системе кусками такого размера */
+#define STREAM_RELEASE (64 << 20)
+
+int parse_projections_stream(const char *filename, PointSink sink, void *ctx,
+                             Projections *pr) {
+    memset(pr, 0, sizeof(*pr));
+
+    size_t len;
+    const char *map = map_file(filename, &len);
+    if (!map) return 0;
+    if (len) madvise((void *)map, len, MADV_SEQUENTIAL);
+
+    // Тот же разбор, что scan_sections + parse_section_task, за один проход
+    const char *p = map, *end = map + len;
+    const char *released = map;
+    int view = -1;
+    int waiting_second = 0;
+    double saved = 0.0;
+    size_t *nraw[VIEW_COUNT] = {&pr->nxz_raw, &pr->nyz_raw, &pr->nxy_raw};
+    int ok = 1;
+
+    while (ok && p < end) {
+        const char *le = line_end(p, end);
+        const char *next = le < end ? le + 1 : end;
+        int kind = classify_line(p, le);
+
+        if (kind == LINE_FRONT || kind == LINE_PROFILE || kind == LINE_TOP) {
+            view = kind == LINE_FRONT ? VIEW_FRONT :
+                   kind == LINE_PROFILE ? VIEW_PROFILE : VIEW_TOP;
+            waiting_second = 0;
+        } else if (kind == LINE_END) {
+            break;
+        } else if (view >= 0) {
+            double value;
+            if (kind == LINE_LCSX || kind == LINE_LCSY) {
+                const char *eq = (const char *)memchr(p, '=', (size_t)(le - p));
+                if (eq && parse_number(eq + 1, le, &value))
+                    pr->lcs[view][kind == LINE_LCSY] = value;
+            } else if (kind == LINE_NUMBER && parse_number(p, le, &value)) {
+                if (geom_step > 0.0) value = geom_snap(value, &pr->near_boundary);
+                if (!waiting_second) {
+                    saved = value;
+                    waiting_second = 1;
+                } else {
+                    ok = sink(ctx, view, saved, value);
+                    (*nraw[view])++;
+                    waiting_second = 0;
+                }
+            }
+        }
+        p = next;
+
+        // Страницы позади не понадобятся: чертёж больше памяти не должен
+        // оседать в резидентной памяти процесса
+        if ((size_t)(p - released) >= 2 * STREAM_RELEASE) {
+            madvise((void *)released, STREAM_RELEASE, MADV_DONTNEED);
+            released += STREAM_RELEASE;
+        }
+    }
+
+    unmap_file(map, len);
+    return ok;
+}
+
+int parse_points3d(const char *filename, PointXYZ **pts, size_t *n) {
+    *pts = NULL;
+    *n = 0;
+
+    size_t len;
+    const char *map = map_file(filename, &len);
+    if (!map) return 0;
+
+    const char *p = map, *end = map + len;
+    int in_points = 0;
+    size_t cap = 0;
+    double xyz[3];
+    int have = 0, ok = 1;
+
+    while (p < end && ok) {
+        const char *le = line_end(p, end);
+        const char *next = le < end ? le + 1 : end;
+        int kind = classify_line(p, le);
+
+        if (!in_points) {
+            in_points = kind == LINE_END;
+        } else if (kind == LINE_NUMBER && parse_number(p, le, &xyz[have])) {
+            if (++have == 3) {
+                if (*n == cap) {
+                    size_t new_cap = cap ? cap * 2 : 1024;
+                    PointXYZ *resized = (PointXYZ *)realloc(*pts, new_cap * sizeof(PointXYZ));
+                    if (!resized) {
+                        ok = 0;
+                        break;
+                    }
+                    *pts = resized;
+                    cap = new_cap;
+                }
+                (*pts)[(*n)++] = (PointXYZ){xyz[0], xyz[1], xyz[2]};
+                have = 0;
+            }
+        } else if (kind != LINE_EMPTY) {
+            // Точки кончаются на "3D edges" или первой нечисловой строке
+            break;
+        }
+        p = next;
+    }
+    unmap_file(map, len);
+
+    if (!ok) {
+        free(*pts);
+        *pts = NULL;
+        *n = 0;
+    }
+    return ok;
+}
+
+void projections_free(Projections *pr) {
+    if (pr->map) {
+        munmap(pr->map, pr->map_len);
+    } else if (!pr->arena) {
+        free(pr->xy);
+        free(pr->xz);
+        free(pr->yz);
+        free(pr->mxy);
+        free(pr->mxz);
+        free(pr->myz);
+    }
+    memset(pr, 0, sizeof(*pr));
+}
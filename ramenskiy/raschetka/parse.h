@@ -0,0 +1,64 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "geom.h"
+#include "pool.h"
+
+/* Три проекции чертежа */
+typedef struct {
+    PointXY *xy;
+    size_t nxy;
+    PointXZ *xz;
+    size_t nxz;
+    PointYZ *yz;
+    size_t nyz;
+    uint32_t *mxy, *mxz, *myz;   // кратности точек после сжатия (compact.h), иначе NULL
+    size_t nxy_raw, nxz_raw, nyz_raw;   // точек в файле до сжатия
+    double lcs[VIEW_COUNT][2];   // lcsX, lcsY каждого вида
+    size_t near_boundary;        // координат у середины между узлами квантования
+    void *map;                   // массивы лежат в отображённом кэше (cache.h)
+    size_t map_len;
+    Arena *arena;                // массивы выданы из арены и не освобождаются по одному
+} Projections;
+
+/* Разбор файла чертежа через отображение в память.
+   За один проход находятся границы секций, затем секции разбираются
+   (параллельно, если pool != NULL). Числа вида "102,000" читаются прямо
+   из отображённого файла без копирования. В режиме квантования (geom.h)
+   координаты сразу заменяются узлами сетки. arena != NULL — массивы
+   видов (и кратности после сжатия) выдаются из неё. Возвращает 1 при успехе */
+int parse_projections(WorkerPool *pool, Arena *arena, const char *filename,
+                      Projections *pr);
+
+/* То же для текста чертежа, уже находящегося в памяти */
+int parse_projections_buf(WorkerPool *pool, Arena *arena, const char *buf, size_t len,
+                          Projections *pr);
+
+/* Проекции из готовых массивов точек видов в порядке чертежа (соседние
+   пары точек — отрезки, как в файле). Массивы копируются в arena (NULL —
+   malloc): дальше они сортируются на месте. В режиме квантования
+   координаты заменяются узлами сетки, как при чтении файла.
+   Возвращает 1 при успехе */
+int projections_from_views(Arena *arena, const PointXY *xy, size_t nxy,
+                           const PointXZ *xz, size_t nxz,
+                           const PointYZ *yz, size_t nyz, Projections *pr);
+
+/* Потоковый разбор для чертежей больше памяти (ooc.h): точки не
+   собираются в массивы, а передаются sink по одной в порядке файла —
+   view, затем две координаты в порядке вида (XZ: x, z; YZ: y, z;
+   XY: x, y). Заполняются только lcs, near_boundary и n*_raw.
+   sink возвращает 0, чтобы прервать разбор. Возвращает 1 при успехе */
+typedef int (*PointSink)(void *ctx, int view, double a, double b);
+int parse_projections_stream(const char *filename, PointSink sink, void *ctx,
+                             Projections *pr);
+
+void projections_free(Projections *pr);
+
+/* Точки секции "3D points" (тройки x, y, z) — эталон восстановления,
+   записанный в файле вида "X 3D.txt". Возвращает 1 при успехе */
+int parse_points3d(const char *filename, PointXYZ **pts, size_t *n);
+
+#endif
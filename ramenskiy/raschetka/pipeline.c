@@ -0,0 +1,654 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "compact.h"
+#include "pipeline.h"
+#include "sort.h"
+
+/* Таблица занятых значений (x, y) делится на части со своими замками */
+#define PIPE_SHARDS 64
+
+/* До стольких совпадений точки повторы z ищутся перебором */
+#define SEEN_SCAN 16
+
+/* Кусок вида сверху в порядке файла */
+typedef struct {
+    PointXY *pts;
+    size_t n;
+} XyChunk;
+
+/* Занятое значение (x, y): поток, который его соединяет, и номер
+   результата у этого потока */
+typedef struct {
+    double x, y;
+    size_t worker;
+    size_t local;
+} ClaimEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    ClaimEntry *entries;
+    size_t n, cap;
+    size_t *table;         // номер записи + 1, 0 — пустой слот
+    size_t mask;
+} ClaimShard;
+
+/* Совпадения одного значения (x, y) */
+typedef struct {
+    size_t off, n;         // значения z подряд в JoinWorker.z
+    size_t unit;           // совпадений с кратностями XZ
+} PointMatch;
+
+/* Слот поиска повторов z: занят, если gen — текущее поколение */
+typedef struct {
+    uint64_t bits;
+    size_t gen;
+} SeenSlot;
+
+/* Поток соединения: результаты копятся у него, без общих буферов */
+typedef struct {
+    double *z;
+    size_t nz, zcap;
+    PointMatch *res;
+    size_t nres, rescap;
+    size_t *match;         // буфер join_point
+    size_t match_cap;
+    SeenSlot *seen;
+    size_t seen_cap, gen;
+    double idle;
+    int ok;
+} JoinWorker;
+
+typedef struct {
+    WorkerPool *pool;
+    Arena *arena;
+    Projections *pr;
+    WireIndex *wires;
+    StageTimes *t;
+    PipelineStats *st;
+    size_t cap_xz, cap_yz;
+
+    // Куски вида сверху по порядку — их ведёт только поток разбора
+    XyChunk *chunks;
+    size_t nchunks, chunks_cap;
+    XyChunk cur;
+
+    // Очередь кусков: разбор кладёт, потоки соединения забирают
+    pthread_mutex_t lock;
+    pthread_cond_t not_full, not_empty;
+    XyChunk queue[PIPE_QUEUE];
+    size_t head, count;
+    int closed;
+
+    pthread_t stage;
+    int started;
+    int order_broken;      // точка XZ/YZ после начала topView
+    int stage_ok;
+    int compact_ok[2];
+
+    XzIndex ix;
+    YzGrid grid;
+    int ix_ok, grid_ok;
+    ClaimShard shards[PIPE_SHARDS];
+    JoinWorker *workers;
+    size_t nworkers;
+} Pipeline;
+
+static void run_tasks(WorkerPool *pool, PoolTask fn, void *arg, size_t ntasks) {
+    if (pool) {
+        pool_run(pool, fn, arg, ntasks);
+    } else {
+        for (size_t t = 0; t < ntasks; t++) fn(arg, t);
+    }
+}
+
+/* ----------------------------------------- */
+/* Занятые значения (x, y) */
+
+/* Хеш по битам координат; -0.0 и 0.0 равны, как при сжатии (compact.c) */
+static inline uint64_t hash_xy(double x, double y) {
+    uint64_t bx, by;
+    x += 0.0;
+    y += 0.0;
+    memcpy(&bx, &x, sizeof(bx));
+    memcpy(&by, &y, sizeof(by));
+    uint64_t h = bx * 0x9E3779B97F4A7C15ULL;
+    h ^= by * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return h;
+}
+
+static inline ClaimShard *shard_of(Pipeline *p, uint64_t h) {
+    return &p->shards[h >> 58];   // старшие 6 бит: PIPE_SHARDS == 64
+}
+
+static int shard_grow(ClaimShard *s) {
+    size_t cap = s->cap ? s->cap * 2 : 1024;
+    ClaimEntry *entries = (ClaimEntry *)realloc(s->entries, cap * sizeof(ClaimEntry));
+    if (!entries) return 0;
+    s->entries = entries;
+
+    size_t tcap = 2 * cap;
+    size_t *table = (size_t *)calloc(tcap, sizeof(size_t));
+    if (!table) return 0;
+    for (size_t i = 0; i < s->n; i++) {
+        size_t slot = hash_xy(entries[i].x, entries[i].y) & (tcap - 1);
+        while (table[slot]) slot = (slot + 1) & (tcap - 1);
+        table[slot] = i + 1;
+    }
+    free(s->table);
+    s->table = table;
+    s->mask = tcap - 1;
+    s->cap = cap;
+    return 1;
+}
+
+/* Занимает значение (x, y) за потоком worker под следующий номер его
+   результата. Возвращает 1 — значение новое, 0 — уже занято,
+   -1 — нет памяти */
+static int claim(Pipeline *p, size_t worker, double x, double y) {
+    uint64_t h = hash_xy(x, y);
+    ClaimShard *s = shard_of(p, h);
+    int rc = 1;
+    pthread_mutex_lock(&s->lock);
+    if (s->table) {
+        size_t slot = h & s->mask;
+        while (s->table[slot]) {
+            const ClaimEntry *e = &s->entries[s->table[slot] - 1];
+            if (e->x == x && e->y == y) {
+                rc = 0;
+                break;
+            }
+            slot = (slot + 1) & s->mask;
+        }
+    }
+    if (rc == 1 && s->n == s->cap && !shard_grow(s)) rc = -1;
+    if (rc == 1) {
+        size_t slot = h & s->mask;
+        while (s->table[slot]) slot = (slot + 1) & s->mask;
+        s->table[slot] = s->n + 1;
+        s->entries[s->n++] = (ClaimEntry){x, y, worker, p->workers[worker].nres};
+    }
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+/* Результат соединения значения (x, y) — после того как все потоки
+   соединения завершились */
+static const PointMatch *lookup(const Pipeline *p, double x, double y, const double **z) {
+    uint64_t h = hash_xy(x, y);
+    const ClaimShard *s = &p->shards[h >> 58];
+    if (!s->table) return NULL;
+    size_t slot = h & s->mask;
+    while (s->table[slot]) {
+        const ClaimEntry *e = &s->entries[s->table[slot] - 1];
+        if (e->x == x && e->y == y) {
+            const JoinWorker *jw = &p->workers[e->worker];
+            if (e->local >= jw->nres) return NULL;
+            *z = jw->z;
+            return &jw->res[e->local];
+        }
+        slot = (slot + 1) & s->mask;
+    }
+    return NULL;
+}
+
+/* ----------------------------------------- */
+/* Соединение */
+
+static int grow_array(void **a, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap) return 1;
+    size_t new_cap = *cap ? *cap : 256;
+    while (new_cap < need) new_cap *= 2;
+    void *resized = realloc(*a, new_cap * elem);
+    if (!resized) return 0;
+    *a = resized;
+    *cap = new_cap;
+    return 1;
+}
+
+static inline uint64_t double_bits(double v) {
+    uint64_t b;
+    memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+/* Было ли z среди совпадений текущей точки (с from в jw->z). Повторы
+   сравниваются побитово: так их отбрасывает и join_xyz */
+static int z_seen(JoinWorker *jw, size_t from, double z, int use_table) {
+    uint64_t bits = double_bits(z);
+    if (!use_table) {
+        for (size_t k = from; k < jw->nz; k++) {
+            if (double_bits(jw->z[k]) == bits) return 1;
+        }
+        return 0;
+    }
+    uint64_t h = bits * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    size_t mask = jw->seen_cap - 1;
+    size_t slot = (size_t)h & mask;
+    while (jw->seen[slot].gen == jw->gen) {
+        if (jw->seen[slot].bits == bits) return 1;
+        slot = (slot + 1) & mask;
+    }
+    jw->seen[slot] = (SeenSlot){bits, jw->gen};
+    return 0;
+}
+
+/* Совпадения значения (x, y) в результаты потока */
+static int join_value(Pipeline *p, JoinWorker *jw, double x, double y) {
+    const PointXZ *xz = p->pr->xz;
+    const uint32_t *mxz = p->pr->mxz;
+    size_t n;
+    if (!join_point(&p->ix, &p->grid, xz, x, y, &jw->match, &jw->match_cap, &n) ||
+        !grow_array((void **)&jw->res, &jw->rescap, jw->nres + 1, sizeof(PointMatch)) ||
+        !grow_array((void **)&jw->z, &jw->zcap, jw->nz + n, sizeof(double)))
+        return 0;
+
+    // Длинные списки проверяются на повторы через таблицу поколений
+    int use_table = n > SEEN_SCAN;
+    if (use_table && jw->seen_cap < 2 * n) {
+        size_t cap = 64;
+        while (cap < 2 * n) cap *= 2;
+        free(jw->seen);
+        jw->seen = (SeenSlot *)calloc(cap, sizeof(SeenSlot));
+        if (!jw->seen) return 0;
+        jw->seen_cap = cap;
+        jw->gen = 0;
+    }
+    jw->gen++;
+
+    PointMatch m = {jw->nz, 0, 0};
+    for (size_t t = 0; t < n; t++) {
+        m.unit += mxz ? mxz[jw->match[t]] : 1;
+        double z = xz[jw->match[t]].z;
+        if (!z_seen(jw, m.off, z, use_table)) jw->z[jw->nz++] = z;
+    }
+    m.n = jw->nz - m.off;
+    jw->res[jw->nres++] = m;
+    return 1;
+}
+
+/* Поток соединения: забирает куски, пока очередь не закрыта и не пуста.
+   После ошибки куски только забираются, чтобы разбор не встал */
+static void join_task(void *arg, size_t task) {
+    Pipeline *p = (Pipeline *)arg;
+    JoinWorker *jw = &p->workers[task];
+    jw->ok = p->ix_ok && p->grid_ok;
+
+    for (;;) {
+        double waited = timing_now();
+        pthread_mutex_lock(&p->lock);
+        while (p->count == 0 && !p->closed) pthread_cond_wait(&p->not_empty, &p->lock);
+        if (p->count == 0) {
+            pthread_mutex_unlock(&p->lock);
+            jw->idle += timing_now() - waited;
+            break;
+        }
+        XyChunk c = p->queue[p->head];
+        p->head = (p->head + 1) % PIPE_QUEUE;
+        p->count--;
+        pthread_cond_signal(&p->not_full);
+        pthread_mutex_unlock(&p->lock);
+        jw->idle += timing_now() - waited;
+
+        for (size_t i = 0; i < c.n && jw->ok; i++) {
+            double x = c.pts[i].x, y = c.pts[i].y;
+            // Общий конец соседних отрезков — тот же, что у предыдущей точки
+            if (i > 0 && c.pts[i - 1].x == x && c.pts[i - 1].y == y) continue;
+            int rc = claim(p, task, x, y);
+            if (rc < 0) jw->ok = 0;
+            else if (rc > 0) jw->ok = join_value(p, jw, x, y);
+        }
+    }
+}
+
+/* ----------------------------------------- */
+/* Поток этапов: XZ и YZ уже прочитаны целиком */
+
+static void compact_task(void *arg, size_t task) {
+    Pipeline *p = (Pipeline *)arg;
+    p->compact_ok[task] = compact_view(p->pr, task == 0 ? VIEW_FRONT : VIEW_PROFILE);
+}
+
+static void index_task(void *arg, size_t task) {
+    Pipeline *p = (Pipeline *)arg;
+    Projections *pr = p->pr;
+    if (task == 0) p->ix_ok = xz_index_build(&p->ix, p->arena, pr->xz, pr->nxz);
+    else p->grid_ok = yz_grid_build(&p->grid, p->arena, pr->yz, pr->nyz);
+}
+
+static void *stage_main(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+    Projections *pr = p->pr;
+
+    // Графы отрезков — по порядку файла, до сортировки
+    double t0 = timing_now();
+    int ok = wire_view_build(p->wires, p->arena, pr, VIEW_FRONT) &&
+             wire_view_build(p->wires, p->arena, pr, VIEW_PROFILE);
+    double t1 = timing_now();
+    p->t->sec[STAGE_WIRES] += t1 - t0;
+
+    ok = ok && sort_projections(p->pool, NULL, 0, pr->xz, pr->nxz, pr->yz, pr->nyz);
+    if (ok) {
+        run_tasks(p->pool, compact_task, p, 2);
+        ok = p->compact_ok[0] && p->compact_ok[1];
+    }
+    double t2 = timing_now();
+    p->t->sec[STAGE_SORT] += t2 - t1;
+
+    if (ok) run_tasks(p->pool, index_task, p, 2);
+    p->stage_ok = ok && p->ix_ok && p->grid_ok;
+    p->st->index_ready = timing_now() - p->t->run_started;
+
+    // Соединение идёт, пока разбор не закроет очередь
+    run_tasks(p->pool, join_task, p, p->nworkers);
+    p->t->sec[STAGE_JOIN] += timing_now() - t2;
+    return NULL;
+}
+
+static int stage_start(Pipeline *p) {
+    p->pr->nxz_raw = p->pr->nxz;
+    p->pr->nyz_raw = p->pr->nyz;
+    if (pthread_create(&p->stage, NULL, stage_main, p) != 0) return 0;
+    p->started = 1;
+    return 1;
+}
+
+/* ----------------------------------------- */
+/* Разбор */
+
+static void queue_push(Pipeline *p, XyChunk c) {
+    pthread_mutex_lock(&p->lock);
+    if (p->count == PIPE_QUEUE) {
+        double waited = timing_now();
+        while (p->count == PIPE_QUEUE) pthread_cond_wait(&p->not_full, &p->lock);
+        p->st->parse_stall += timing_now() - waited;
+    }
+    p->queue[(p->head + p->count) % PIPE_QUEUE] = c;
+    p->count++;
+    pthread_cond_signal(&p->not_empty);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* Заполненный кусок — в очередь и в список кусков */
+static int chunk_push(Pipeline *p) {
+    if (!p->cur.pts || p->cur.n == 0) return 1;
+    if (!grow_array((void **)&p->chunks, &p->chunks_cap, p->nchunks + 1, sizeof(XyChunk)))
+        return 0;
+    p->chunks[p->nchunks++] = p->cur;
+    queue_push(p, p->cur);
+    p->cur.pts = NULL;
+    p->cur.n = 0;
+    return 1;
+}
+
+static int view_append(Arena *arena, void **a, size_t *n, size_t *cap, double u, double v) {
+    if (*n == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 4096;
+        void *grown = arena_grow(arena, *a, *cap * sizeof(PointXZ), new_cap * sizeof(PointXZ));
+        if (!grown) return 0;
+        *a = grown;
+        *cap = new_cap;
+    }
+    PointXZ *pts = (PointXZ *)*a;   // у всех видов — два double
+    pts[(*n)++] = (PointXZ){u, v};
+    return 1;
+}
+
+static int pipe_sink(void *ctx, int view, double a, double b) {
+    Pipeline *p = (Pipeline *)ctx;
+    Projections *pr = p->pr;
+    if (view == VIEW_TOP) {
+        if (!p->started && !stage_start(p)) return 0;
+        if (!p->cur.pts || p->cur.n == PIPE_CHUNK) {
+            if (!chunk_push(p)) return 0;
+            p->cur.pts = (PointXY *)malloc(PIPE_CHUNK * sizeof(PointXY));
+            if (!p->cur.pts) return 0;
+        }
+        p->cur.pts[p->cur.n++] = (PointXY){a, b};
+        return 1;
+    }
+    if (p->started) {
+        p->order_broken = 1;
+        return 0;
+    }
+    if (view == VIEW_FRONT)
+        return view_append(p->arena, (void **)&pr->xz, &pr->nxz, &p->cap_xz, a, b);
+    return view_append(p->arena, (void **)&pr->yz, &pr->nyz, &p->cap_yz, a, b);
+}
+
+/* ----------------------------------------- */
+/* Сборка кандидатов в порядке сжатого вида сверху */
+typedef struct {
+    const Pipeline *p;
+    const PointXY *xy;
+    const uint32_t *mxy;
+    size_t nxy;
+    size_t nparts;
+    size_t *count;         // кандидатов части, затем её смещение
+    size_t *found;
+    PointXYZ *out;
+    int *ok;
+} AssembleJob;
+
+static void assemble_count_task(void *arg, size_t task) {
+    AssembleJob *job = (AssembleJob *)arg;
+    size_t begin = task * job->nxy / job->nparts;
+    size_t end = (task + 1) * job->nxy / job->nparts;
+    size_t count = 0, found = 0;
+    job->ok[task] = 1;
+    for (size_t i = begin; i < end; i++) {
+        const double *z;
+        const PointMatch *m = lookup(job->p, job->xy[i].x, job->xy[i].y, &z);
+        if (!m) {
+            job->ok[task] = 0;
+            break;
+        }
+        count += m->n;
+        found += (job->mxy ? job->mxy[i] : 1) * m->unit;
+    }
+    job->count[task] = count;
+    job->found[task] = found;
+}
+
+static void assemble_fill_task(void *arg, size_t task) {
+    AssembleJob *job = (AssembleJob *)arg;
+    size_t begin = task * job->nxy / job->nparts;
+    size_t end = (task + 1) * job->nxy / job->nparts;
+    PointXYZ *out = job->out + job->count[task];
+    for (size_t i = begin; i < end; i++) {
+        const double *z;
+        const PointMatch *m = lookup(job->p, job->xy[i].x, job->xy[i].y, &z);
+        for (size_t k = 0; k < m->n; k++)
+            *out++ = (PointXYZ){job->xy[i].x, job->xy[i].y, z[m->off + k]};
+    }
+}
+
+static int assemble(Pipeline *p, JoinResult *cand) {
+    const Projections *pr = p->pr;
+    AssembleJob job;
+    memset(&job, 0, sizeof(job));
+    job.p = p;
+    job.xy = pr->xy;
+    job.mxy = pr->mxy;
+    job.nxy = pr->nxy;
+    job.nparts = (size_t)(p->pool ? p->pool->nthreads : 1) * 8;
+    if (job.nparts > pr->nxy) job.nparts = pr->nxy ? pr->nxy : 1;
+    job.count = (size_t *)calloc(job.nparts, sizeof(size_t));
+    job.found = (size_t *)calloc(job.nparts, sizeof(size_t));
+    job.ok = (int *)calloc(job.nparts, sizeof(int));
+    int ok = job.count && job.found && job.ok;
+
+    if (ok) {
+        run_tasks(p->pool, assemble_count_task, &job, job.nparts);
+        size_t total = 0;
+        for (size_t t = 0; t < job.nparts; t++) {
+            ok = ok && job.ok[t];
+            size_t c = job.count[t];
+            job.count[t] = total;
+            total += c;
+            cand->found += job.found[t];
+        }
+        job.out = ok ? (PointXYZ *)arena_alloc(p->arena, total * sizeof(PointXYZ)) : NULL;
+        ok = job.out != NULL;
+        if (ok) {
+            run_tasks(p->pool, assemble_fill_task, &job, job.nparts);
+            cand->pts = job.out;
+            cand->n = total;
+        }
+    }
+    free(job.count);
+    free(job.found);
+    free(job.ok);
+    return ok;
+}
+
+/* ----------------------------------------- */
+static void pipeline_free(Pipeline *p) {
+    for (size_t c = 0; c < p->nchunks; c++) free(p->chunks[c].pts);
+    free(p->chunks);
+    free(p->cur.pts);
+    for (int s = 0; s < PIPE_SHARDS; s++) {
+        free(p->shards[s].entries);
+        free(p->shards[s].table);
+        pthread_mutex_destroy(&p->shards[s].lock);
+    }
+    for (size_t w = 0; w < p->nworkers; w++) {
+        JoinWorker *jw = &p->workers[w];
+        free(jw->z);
+        free(jw->res);
+        free(jw->match);
+        free(jw->seen);
+    }
+    free(p->workers);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->not_full);
+    pthread_cond_destroy(&p->not_empty);
+}
+
+/* Обычный порядок этапов, как в try.c */
+static int run_sequential(WorkerPool *pool, Arena *arena, const char *filename,
+                          Projections *pr, WireIndex *wires, JoinResult *cand,
+                          StageTimes *t) {
+    timing_begin(t, STAGE_READ);
+    if (!parse_projections(pool, arena, filename, pr)) return 0;
+    timing_end(t, STAGE_READ);
+    if (pr->nxy == 0 || pr->nxz == 0 || pr->nyz == 0) return 1;
+
+    timing_begin(t, STAGE_WIRES);
+    if (!wire_index_build(wires, arena, pr)) return 0;
+    timing_end(t, STAGE_WIRES);
+    timing_begin(t, STAGE_SORT);
+    if (!sort_projections(pool, pr->xy, pr->nxy, pr->xz, pr->nxz, pr->yz, pr->nyz) ||
+        !compact_projections(pool, pr))
+        return 0;
+    timing_end(t, STAGE_SORT);
+    timing_begin(t, STAGE_JOIN);
+    if (!join_xyz(pool, arena, pr->xy, pr->mxy, pr->nxy, pr->xz, pr->mxz, pr->nxz,
+                  pr->yz, pr->nyz, cand))
+        return 0;
+    timing_end(t, STAGE_JOIN);
+    return 1;
+}
+
+int pipeline_run(WorkerPool *pool, Arena *arena, const char *filename,
+                 Projections *pr, WireIndex *wires, JoinResult *cand,
+                 StageTimes *t, PipelineStats *st) {
+    memset(pr, 0, sizeof(*pr));
+    pr->arena = arena;
+    memset(wires, 0, sizeof(*wires));
+    memset(cand, 0, sizeof(*cand));
+    cand->arena = arena;
+    memset(st, 0, sizeof(*st));
+
+    Pipeline p;
+    memset(&p, 0, sizeof(p));
+    p.pool = pool;
+    p.arena = arena;
+    p.pr = pr;
+    p.wires = wires;
+    p.t = t;
+    p.st = st;
+    p.nworkers = pool ? (size_t)pool->nthreads : 1;
+    p.workers = (JoinWorker *)calloc(p.nworkers, sizeof(JoinWorker));
+    if (!p.workers) p.nworkers = 0;
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.not_full, NULL);
+    pthread_cond_init(&p.not_empty, NULL);
+    for (int s = 0; s < PIPE_SHARDS; s++) pthread_mutex_init(&p.shards[s].lock, NULL);
+
+    // Разбор в вызывающем потоке; поток этапов запускается первой
+    // точкой topView (или после разбора, если её нет)
+    double t0 = timing_now();
+    Projections meta;
+    int ok = p.workers && parse_projections_stream(filename, pipe_sink, &p, &meta);
+    if (p.order_broken) ok = 1;
+    if (ok && !p.order_broken) ok = chunk_push(&p);
+    if (ok && !p.started) ok = stage_start(&p);
+    t->sec[STAGE_READ] += timing_now() - t0;
+
+    pthread_mutex_lock(&p.lock);
+    p.closed = 1;
+    pthread_cond_broadcast(&p.not_empty);
+    pthread_mutex_unlock(&p.lock);
+    if (p.started) pthread_join(p.stage, NULL);
+
+    if (p.order_broken) {
+        // Секция XZ или YZ после topView: всё заново обычным порядком.
+        // Массивы первой попытки остаются в арене до её сброса
+        pipeline_free(&p);
+        st->fallback = 1;
+        memset(pr, 0, sizeof(*pr));
+        memset(wires, 0, sizeof(*wires));
+        return run_sequential(pool, arena, filename, pr, wires, cand, t);
+    }
+
+    ok = ok && p.stage_ok;
+    for (size_t w = 0; w < p.nworkers && ok; w++) {
+        ok = p.workers[w].ok;
+        st->joined += p.workers[w].nres;
+        st->join_idle += p.workers[w].idle;
+    }
+    st->chunks = p.nchunks;
+
+    if (ok) {
+        memcpy(pr->lcs, meta.lcs, sizeof(pr->lcs));
+        pr->near_boundary = meta.near_boundary;
+        pr->nxy_raw = meta.nxy_raw;
+
+        // Вид сверху целиком: куски подряд в порядке файла
+        size_t n = 0;
+        for (size_t c = 0; c < p.nchunks; c++) n += p.chunks[c].n;
+        pr->xy = (PointXY *)arena_alloc(arena, n * sizeof(PointXY));
+        ok = pr->xy != NULL;
+        for (size_t c = 0; c < p.nchunks && ok; c++) {
+            memcpy(pr->xy + pr->nxy, p.chunks[c].pts, p.chunks[c].n * sizeof(PointXY));
+            pr->nxy += p.chunks[c].n;
+        }
+    }
+
+    if (ok) {
+        timing_begin(t, STAGE_WIRES);
+        ok = wire_view_build(wires, arena, pr, VIEW_TOP);
+        timing_end(t, STAGE_WIRES);
+    }
+    if (ok) {
+        timing_begin(t, STAGE_SORT);
+        ok = sort_projections(pool, pr->xy, pr->nxy, NULL, 0, NULL, 0) &&
+             compact_view(pr, VIEW_TOP);
+        timing_end(t, STAGE_SORT);
+    }
+    if (ok) {
+        timing_begin(t, STAGE_JOIN);
+        ok = assemble(&p, cand);
+        timing_end(t, STAGE_JOIN);
+    }
+
+    pipeline_free(&p);
+    return ok;
+}
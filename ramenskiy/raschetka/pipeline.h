@@ -0,0 +1,49 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include "arena.h"
+#include "join.h"
+#include "parse.h"
+#include "pool.h"
+#include "timing.h"
+#include "wires.h"
+
+/* Конвейерное восстановление: чтение, сортировка и соединение идут
+   одновременно. В чертеже секции frontView и profileView стоят перед
+   topView, поэтому к первой точке вида сверху XZ и YZ уже прочитаны:
+   поток этапов строит их графы отрезков, сортирует, сжимает и
+   индексирует, пока разбор читает topView. Точки XY идут кусками
+   через ограниченную очередь (разбор ждёт, если она полна) и
+   соединяются на пуле по мере чтения — каждое различное значение
+   (x, y) один раз. После чтения вид сверху сортируется и сжимается,
+   а кандидаты собираются в том же порядке, что у join_xyz.
+
+   Если точка XZ или YZ встретилась после начала topView, конвейер
+   неприменим: файл читается и восстанавливается обычным порядком
+   (parse_projections ... join_xyz), fallback в статистике */
+
+#define PIPE_CHUNK 16384   // точек XY в куске очереди
+#define PIPE_QUEUE 64      // кусков в очереди
+
+typedef struct {
+    double index_ready;    // от начала до готовности индексов XZ/YZ, с
+    double parse_stall;    // разбор ждал места в очереди, с
+    double join_idle;      // потоки соединения ждали кусков (сумма), с
+    size_t chunks;         // кусков XY прошло через очередь
+    size_t joined;         // различных точек XY соединено на лету
+    int fallback;          // порядок секций не подошёл
+} PipelineStats;
+
+/* Результат тот же, что у последовательности parse_projections,
+   wire_index_build, sort_projections, compact_projections и join_xyz:
+   pr — отсортированные и сжатые виды (массивы из arena), wires — графы
+   видов, cand — кандидаты с found. Пустой вид не ошибка: проверяются
+   pr->n*_raw, cand тогда пуст. Этапы перекрываются, поэтому времена
+   в t (READ, WIRES, SORT, JOIN — по каждому этапу отдельно) в сумме
+   больше общего. arena обязательна. Возвращает 1 при успехе */
+int pipeline_run(WorkerPool *pool, Arena *arena, const char *filename,
+                 Projections *pr, WireIndex *wires, JoinResult *cand,
+                 StageTimes *t, PipelineStats *st);
+
+#endif
@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "pointset.h"
+
+static inline size_t hash_cell(long long kx, long long ky, long long kz) {
+    uint64_t h = (uint64_t)kx * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)ky * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+    h ^= (uint64_t)kz * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+static PointCell *find_slot(PointCell *table, size_t mask,
+                            long long kx, long long ky, long long kz) {
+    size_t slot = hash_cell(kx, ky, kz) & mask;
+    while (table[slot].head) {
+        PointCell *c = &table[slot];
+        if (c->kx == kx && c->ky == ky && c->kz == kz) break;
+        slot = (slot + 1) & mask;
+    }
+    return &table[slot];
+}
+
+static int grow_table(PointSet *s) {
+    size_t cap = (s->mask + 1) * 2;
+    PointCell *table = (PointCell *)calloc(cap, sizeof(PointCell));
+    if (!table) return 0;
+
+    for (size_t i = 0; i <= s->mask; i++) {
+        PointCell *c = &s->table[i];
+        if (!c->head) continue;
+        *find_slot(table, cap - 1, c->kx, c->ky, c->kz) = *c;
+    }
+    free(s->table);
+    s->table = table;
+    s->mask = cap - 1;
+    return 1;
+}
+
+int pointset_init(PointSet *s, size_t expected) {
+    memset(s, 0, sizeof(*s));
+    s->inv_cell = grid_inv_cell();
+
+    s->cap = expected > 16 ? expected : 16;
+    s->pts = (PointXYZ *)malloc(s->cap * sizeof(PointXYZ));
+    s->next = (size_t *)malloc(s->cap * sizeof(size_t));
+
+    size_t tcap = 32;
+    while (tcap < 2 * s->cap) tcap *= 2;
+    s->table = (PointCell *)calloc(tcap, sizeof(PointCell));
+    s->mask = tcap - 1;
+
+    if (!s->pts || !s->next || !s->table) {
+        pointset_free(s);
+        return 0;
+    }
+    return 1;
+}
+
+void pointset_free(PointSet *s) {
+    free(s->pts);
+    free(s->next);
+    free(s->table);
+    memset(s, 0, sizeof(*s));
+}
+
+void pointset_clear(PointSet *s) {
+    if (s->ncells * 8 < s->mask + 1) {
+        // Таблица, выросшая на большом чертеже, почти пуста: обнуляются
+        // только занятые ячейки. Сначала все ячейки находятся (номера
+        // ложатся в next), затем обнуляются — иначе обнулённая ячейка
+        // оборвала бы цепочку поиска следующих
+        for (size_t i = 0; i < s->n; i++) {
+            const PointXYZ *p = &s->pts[i];
+            s->next[i] = (size_t)(find_slot(s->table, s->mask, grid_key(p->x, s->inv_cell),
+                                            grid_key(p->y, s->inv_cell),
+                                            grid_key(p->z, s->inv_cell)) - s->table);
+        }
+        for (size_t i = 0; i < s->n; i++) s->table[s->next[i]].head = 0;
+    } else {
+        memset(s->table, 0, (s->mask + 1) * sizeof(PointCell));
+    }
+    s->n = 0;
+    s->ncells = 0;
+    // Следующий чертёж может идти с другой EPS (контекст библиотеки,
+    // сервер): ячейка берётся по текущей, иначе поиск в соседних
+    // ячейках не достаёт до совпадающих точек
+    s->inv_cell = grid_inv_cell();
+}
+
+int pointset_contains(const PointSet *s, PointXYZ p) {
+    long long kx = grid_key(p.x, s->inv_cell);
+    long long ky = grid_key(p.y, s->inv_cell);
+    long long kz = grid_key(p.z, s->inv_cell);
+    long long r = grid_reach();
+
+    for (long long dx = -r; dx <= r; dx++) {
+        for (long long dy = -r; dy <= r; dy++) {
+            for (long long dz = -r; dz <= r; dz++) {
+                const PointCell *c = find_slot(s->table, s->mask,
+                                               kx + dx, ky + dy, kz + dz);
+                for (size_t k = c->head; k; k = s->next[k - 1]) {
+                    const PointXYZ *q = &s->pts[k - 1];
+                    if (approx_eq(q->x, p.x) && approx_eq(q->y, p.y) &&
+                        approx_eq(q->z, p.z))
+                        return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+long long pointset_find(const PointSet *s, PointXYZ p) {
+    long long kx = grid_key(p.x, s->inv_cell);
+    long long ky = grid_key(p.y, s->inv_cell);
+    long long kz = grid_key(p.z, s->inv_cell);
+    long long r = grid_reach();
+    long long best = -1;
+
+    for (long long dx = -r; dx <= r; dx++) {
+        for (long long dy = -r; dy <= r; dy++) {
+            for (long long dz = -r; dz <= r; dz++) {
+                const PointCell *c = find_slot(s->table, s->mask,
+                                               kx + dx, ky + dy, kz + dz);
+                for (size_t k = c->head; k; k = s->next[k - 1]) {
+                    const PointXYZ *q = &s->pts[k - 1];
+                    if (approx_eq(q->x, p.x) && approx_eq(q->y, p.y) &&
+                        approx_eq(q->z, p.z) && (best < 0 || (long long)(k - 1) < best))
+                        best = (long long)(k - 1);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int pointset_insert(PointSet *s, PointXYZ p) {
+    if (pointset_contains(s, p)) return 0;
+
+    if (s->n == s->cap) {
+        size_t cap = s->cap * 2;
+        PointXYZ *pts = (PointXYZ *)realloc(s->pts, cap * sizeof(PointXYZ));
+        if (!pts) return -1;
+        s->pts = pts;
+        size_t *next = (size_t *)realloc(s->next, cap * sizeof(size_t));
+        if (!next) return -1;
+        s->next = next;
+        s->cap = cap;
+    }
+    if (2 * (s->ncells + 1) > s->mask + 1 && !grow_table(s)) return -1;
+
+    long long kx = grid_key(p.x, s->inv_cell);
+    long long ky = grid_key(p.y, s->inv_cell);
+    long long kz = grid_key(p.z, s->inv_cell);
+    PointCell *c = find_slot(s->table, s->mask, kx, ky, kz);
+    if (!c->head) {
+        c->kx = kx;
+        c->ky = ky;
+        c->kz = kz;
+        s->ncells++;
+    }
+
+    s->pts[s->n] = p;
+    s->next[s->n] = c->head;
+    c->head = ++s->n;
+    return 1;
+}
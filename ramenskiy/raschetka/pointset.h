@@ -0,0 +1,47 @@
+#ifndef POINTSET_H
+#define POINTSET_H
+
+#include <stddef.h>
+#include "geom.h"
+
+/* Ячейка пространственного хеша: первая точка цепочки ячейки */
+typedef struct {
+    long long kx, ky, kz;
+    size_t head;         // номер точки + 1, 0 — пустой слот
+} PointCell;
+
+/* Множество уникальных 3D точек с точностью EPS.
+   Точки хранятся в порядке добавления, буфер растёт вдвое;
+   поиск соседей — по ячейкам размером ~EPS и 26 соседним ячейкам */
+typedef struct {
+    PointXYZ *pts;
+    size_t *next;        // следующая точка той же ячейки + 1, 0 — конец
+    size_t n, cap;
+
+    PointCell *table;
+    size_t ncells;
+    size_t mask;
+    double inv_cell;
+} PointSet;
+
+int pointset_init(PointSet *s, size_t expected);
+void pointset_free(PointSet *s);
+
+/* Делает множество пустым, сохраняя выделенную память, — для
+   восстановления нескольких чертежей подряд. Время — по числу точек,
+   а не по размеру таблицы, если та почти пуста. Размер ячейки
+   пересчитывается по текущей EPS */
+void pointset_clear(PointSet *s);
+
+/* Есть ли во множестве точка, совпадающая с p с точностью EPS */
+int pointset_contains(const PointSet *s, PointXYZ p);
+
+/* Номер точки, совпадающей с p с точностью EPS, или -1. Если таких
+   несколько (цепочка точек ближе EPS), — меньший номер */
+long long pointset_find(const PointSet *s, PointXYZ p);
+
+/* Добавляет p, если такой точки ещё нет.
+   Возвращает 1 — добавлена, 0 — уже была, -1 — нет памяти */
+int pointset_insert(PointSet *s, PointXYZ p);
+
+#endif
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pool.h"
+
+int pool_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* Берёт и выполняет задачи текущего запуска, пока они есть.
+   Вызывается с захваченным мьютексом */
+static void drain_tasks(WorkerPool *p) {
+    while (p->next_task < p->ntasks) {
+        size_t task = p->next_task++;
+        PoolTask fn = p->fn;
+        void *arg = p->arg;
+
+        pthread_mutex_unlock(&p->lock);
+        fn(arg, task);
+        pthread_mutex_lock(&p->lock);
+
+        if (++p->finished == p->ntasks)
+            pthread_cond_broadcast(&p->done);
+    }
+}
+
+static void* worker_main(void *arg) {
+    WorkerPool *p = (WorkerPool*)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!p->stop && p->generation == seen)
+            pthread_cond_wait(&p->wake, &p->lock);
+        if (p->stop) break;
+        seen = p->generation;
+        drain_tasks(p);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+int pool_init(WorkerPool *p, int nthreads) {
+    memset(p, 0, sizeof(*p));
+    if (nthreads < 1) nthreads = 1;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    pthread_cond_init(&p->done, NULL);
+
+    p->threads = (pthread_t *)malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!p->threads) {
+        pool_destroy(p);
+        return 0;
+    }
+
+    p->nthreads = 1;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&p->threads[i - 1], NULL, worker_main, p) != 0) {
+            perror("pthread_create");
+            pool_destroy(p);
+            return 0;
+        }
+        p->nthreads++;
+    }
+    return 1;
+}
+
+void pool_destroy(WorkerPool *p) {
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 1; i < p->nthreads; i++)
+        pthread_join(p->threads[i - 1], NULL);
+
+    free(p->threads);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->wake);
+    pthread_cond_destroy(&p->done);
+    memset(p, 0, sizeof(*p));
+}
+
+void pool_run(WorkerPool *p, PoolTask fn, void *arg, size_t ntasks) {
+    if (ntasks == 0) return;
+
+    pthread_mutex_lock(&p->lock);
+    p->fn = fn;
+    p->arg = arg;
+    p->ntasks = ntasks;
+    p->next_task = 0;
+    p->finished = 0;
+    p->generation++;
+    pthread_cond_broadcast(&p->wake);
+
+    drain_tasks(p);
+    while (p->finished < p->ntasks)
+        pthread_cond_wait(&p->done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+}
@@ -0,0 +1,38 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+/* Задача пула: fn(arg, номер_задачи) */
+typedef void (*PoolTask)(void *arg, size_t task);
+
+/* Пул рабочих потоков. Вызывающий поток тоже выполняет задачи,
+   поэтому пул на nthreads потоков создаёт nthreads-1 рабочих */
+typedef struct {
+    pthread_t *threads;
+    int nthreads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+
+    PoolTask fn;
+    void *arg;
+    size_t ntasks;
+    size_t next_task;      // следующая невыданная задача
+    size_t finished;       // завершённые задачи текущего запуска
+    unsigned long generation;
+    int stop;
+} WorkerPool;
+
+/* Число потоков по умолчанию — число доступных ядер */
+int pool_default_threads(void);
+
+int pool_init(WorkerPool *p, int nthreads);
+void pool_destroy(WorkerPool *p);
+
+/* Выполняет задачи 0..ntasks-1 и ждёт их завершения */
+void pool_run(WorkerPool *p, PoolTask fn, void *arg, size_t ntasks);
+
+#endif
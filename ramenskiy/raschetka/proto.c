@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "proto.h"
+#include "writer.h"
+
+int proto_send(int fd, const void *head, size_t head_len,
+               const void *body, size_t body_len) {
+    struct iovec iov[2] = {
+        {(void *)head, head_len},
+        {(void *)body, body_len}
+    };
+    struct iovec *v = iov;
+    int cnt = body_len ? 2 : 1;
+    while (cnt > 0) {
+        ssize_t w = writev(fd, v, cnt);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return 0;
+        size_t done = (size_t)w;
+        while (cnt > 0 && done >= v->iov_len) {
+            done -= v->iov_len;
+            v++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            v->iov_base = (char *)v->iov_base + done;
+            v->iov_len -= done;
+        }
+    }
+    return 1;
+}
+
+int proto_read_all(int fd, void *p, size_t n) {
+    char *c = (char *)p;
+    while (n > 0) {
+        ssize_t r = read(fd, c, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        c += r;
+        n -= (size_t)r;
+    }
+    return 1;
+}
+
+static int socket_addr(const char *path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Слишком длинный путь сокета: %s\n", path);
+        return 0;
+    }
+    strcpy(addr->sun_path, path);
+    return 1;
+}
+
+int proto_listen(const char *path, unsigned mode) {
+    struct sockaddr_un addr;
+    if (!socket_addr(path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    // bind создаёт файл с правами по umask: на время bind umask закрывает
+    // всё, кроме владельца, затем права ставятся точно. Вызывается до
+    // запуска потоков, поэтому смена umask процесса никому не мешает
+    mode_t old_mask = umask(077);
+    int bound = bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    umask(old_mask);
+    if (!bound || chmod(path, (mode_t)mode) != 0 || listen(fd, 128) != 0) {
+        perror(path);
+        if (bound) unlink(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int proto_connect(const char *path) {
+    struct sockaddr_un addr;
+    if (!socket_addr(path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int proto_parse_result(const void *buf, size_t len,
+                       const PointXYZ **pts, size_t *npts,
+                       const uint64_t **edges, size_t *nedges) {
+    const char *c = (const char *)buf;
+    uint32_t version[2];
+    uint64_t counts[2];
+    if (len < 32 || memcmp(c, RESULT_MAGIC, 8) != 0) return 0;
+    memcpy(version, c + 8, sizeof(version));
+    memcpy(counts, c + 16, sizeof(counts));
+    if (version[0] != RESULT_VERSION) return 0;
+    size_t rest = len - 32;
+    if (counts[0] > rest / sizeof(PointXYZ)) return 0;
+    rest -= counts[0] * sizeof(PointXYZ);
+    if (counts[1] > rest / (2 * sizeof(uint64_t)) ||
+        rest != counts[1] * 2 * sizeof(uint64_t))
+        return 0;
+    *pts = (const PointXYZ *)(c + 32);
+    *npts = (size_t)counts[0];
+    *edges = (const uint64_t *)(c + 32 + counts[0] * sizeof(PointXYZ));
+    *nedges = (size_t)counts[1];
+    return 1;
+}
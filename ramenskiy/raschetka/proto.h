@@ -0,0 +1,75 @@
+#ifndef PROTO_H
+#define PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "geom.h"
+
+/* Протокол сервера восстановления (serve) поверх потокового Unix-сокета.
+   Соединение постоянное: клиент шлёт запрос, ждёт ответ, шлёт следующий;
+   несколько запросов одновременно — несколько соединений.
+   Числа в порядке байтов машины (сокет только локальный).
+
+   Запрос: ProtoRequest, затем len байт:
+     PROTO_TEXT — текст чертежа в формате "X 2D.txt";
+     PROTO_PATH — путь к файлу чертежа (без '\0'), абсолютный или от
+       корня сервера. Сервер отображает файл в память сам, поэтому
+       чертёж, положенный в /dev/shm, передаётся через общую память без
+       копирования в сокет. Файлы вне корня сервера (serve -r, по
+       умолчанию PROTO_ROOT_DEFAULT) после раскрытия ссылок и ".."
+       не читаются.
+   Ответ: ProtoReply, затем len байт: при PROTO_OK — результат в формате
+   OUT_BIN (writer.h), иначе текст ошибки */
+
+#define PROTO_MAGIC 0x31505352u          // "RSP1"
+#define PROTO_SOCKET_DEFAULT "/tmp/raschetka.sock"
+#define PROTO_SOCKET_MODE 0600           // права файла сокета по умолчанию
+#define PROTO_ROOT_DEFAULT "/dev/shm"
+#define PROTO_MAX_REQUEST (64ULL << 20)  // больше — ошибка запроса (serve -l)
+
+enum {
+    PROTO_TEXT = 1,
+    PROTO_PATH = 2
+};
+
+enum {
+    PROTO_OK = 0,
+    PROTO_FAILED = 1,       // чертёж не восстановлен
+    PROTO_BAD_REQUEST = 2   // неверный заголовок или размер
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;
+    uint64_t len;
+} ProtoRequest;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t len;
+} ProtoReply;
+
+/* Запись заголовка и тела одним writev (с дозаписью остатка).
+   Возвращает 1 при успехе */
+int proto_send(int fd, const void *head, size_t head_len,
+               const void *body, size_t body_len);
+
+/* Чтение ровно n байт. Возвращает 1 — прочитано, 0 — соединение
+   закрыто или ошибка */
+int proto_read_all(int fd, void *p, size_t n);
+
+/* Слушающий сокет по пути path (старый файл сокета удаляется) с правами
+   mode — файл создаётся сразу с ними, без окна с правами по umask, — и
+   соединение с ним. Возвращают дескриптор или -1 */
+int proto_listen(const char *path, unsigned mode);
+int proto_connect(const char *path);
+
+/* Разбор результата OUT_BIN: вершины — указатель внутрь buf (buf
+   выровнен на 8), рёбра — пары uint64 там же. Возвращает 1, если
+   размеры сходятся */
+int proto_parse_result(const void *buf, size_t len,
+                       const PointXYZ **pts, size_t *npts,
+                       const uint64_t **edges, size_t *nedges);
+
+#endif
@@ -0,0 +1,176 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "geom.h"
+#include "pool.h"
+#include "recon.h"
+#include "raschetka.h"
+
+/* Вершины и рёбра отдаются наружу как массивы чисел — раскладка
+   структур должна совпадать с ними */
+_Static_assert(sizeof(PointXYZ) == 3 * sizeof(double), "PointXYZ — три double");
+_Static_assert(sizeof(PointXY) == 2 * sizeof(double) &&
+               sizeof(PointXZ) == 2 * sizeof(double) &&
+               sizeof(PointYZ) == 2 * sizeof(double), "точка вида — два double");
+_Static_assert(sizeof(Edge3D) == 2 * sizeof(size_t), "Edge3D — два size_t");
+
+struct RaschetkaContext {
+    RaschetkaOptions opt;
+    WorkerPool pool;
+    int have_pool;
+    Reconstruction rec;
+    int have_result;
+    char error[128];
+};
+
+RaschetkaContext *raschetka_create(const RaschetkaOptions *opt) {
+    RaschetkaContext *ctx = (RaschetkaContext *)calloc(1, sizeof(*ctx));
+    if (!ctx) return NULL;
+    if (opt) ctx->opt = *opt;
+    if (ctx->opt.eps == 0.0) ctx->opt.eps = EPS_DEFAULT;
+    if (ctx->opt.threads <= 0) ctx->opt.threads = pool_default_threads();
+    if (!(ctx->opt.eps > 0.0) || !isfinite(ctx->opt.eps) || !recon_init(&ctx->rec)) {
+        free(ctx);
+        return NULL;
+    }
+    // Пул на один поток ничего не даёт: этапы идут в вызывающем потоке
+    if (ctx->opt.threads > 1) {
+        if (!pool_init(&ctx->pool, ctx->opt.threads)) {
+            recon_free(&ctx->rec);
+            free(ctx);
+            return NULL;
+        }
+        ctx->have_pool = 1;
+    }
+    return ctx;
+}
+
+void raschetka_destroy(RaschetkaContext *ctx) {
+    if (!ctx) return;
+    if (ctx->have_pool) pool_destroy(&ctx->pool);
+    recon_free(&ctx->rec);
+    free(ctx);
+}
+
+/* Точность сравнения (geom_eps, geom_step) общая для процесса, а читают
+   её все этапы запуска, в том числе потоки пулов. Поэтому запуски
+   пропускаются через общий замок: с текущей точностью — одновременно,
+   с другой — по одному, когда идущие запуски закончились; тогда запуск
+   ставит свою точность. Пока кто-то ждёт смены, новые запуски с текущей
+   точностью его не обгоняют */
+static pthread_mutex_t precision_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t precision_change = PTHREAD_COND_INITIALIZER;
+static size_t precision_runs;       // идущих запусков
+static size_t precision_waiting;    // ждут смены точности
+
+static int precision_current(const RaschetkaContext *ctx) {
+    return ctx->opt.quantize ? geom_step == ctx->opt.eps :
+                               geom_step == 0.0 && geom_eps == ctx->opt.eps;
+}
+
+static void precision_enter(const RaschetkaContext *ctx) {
+    pthread_mutex_lock(&precision_lock);
+    int waiting = 0;
+    for (;;) {
+        if (precision_current(ctx)) {
+            if (waiting || precision_waiting == 0) break;
+        } else {
+            if (!waiting) {
+                waiting = 1;
+                precision_waiting++;
+            }
+            if (precision_runs == 0) {
+                if (ctx->opt.quantize) geom_set_quantized(ctx->opt.eps);
+                else geom_set_eps(ctx->opt.eps);
+                break;
+            }
+        }
+        pthread_cond_wait(&precision_change, &precision_lock);
+    }
+    if (waiting) {
+        precision_waiting--;
+        pthread_cond_broadcast(&precision_change);
+    }
+    precision_runs++;
+    pthread_mutex_unlock(&precision_lock);
+}
+
+static void precision_leave(void) {
+    pthread_mutex_lock(&precision_lock);
+    if (--precision_runs == 0) pthread_cond_broadcast(&precision_change);
+    pthread_mutex_unlock(&precision_lock);
+}
+
+static WorkerPool *context_pool(RaschetkaContext *ctx) {
+    return ctx->have_pool ? &ctx->pool : NULL;
+}
+
+/* Итог запуска и текст ошибки */
+static int finish_run(RaschetkaContext *ctx, int ok, const char *what) {
+    ctx->have_result = ok;
+    if (ok) {
+        ctx->error[0] = '\0';
+    } else if (ctx->rec.empty_view) {
+        snprintf(ctx->error, sizeof(ctx->error),
+                 "недостаточно данных: topView %zu, frontView %zu, profileView %zu",
+                 ctx->rec.nxy, ctx->rec.nxz, ctx->rec.nyz);
+    } else {
+        snprintf(ctx->error, sizeof(ctx->error), "%s", what);
+    }
+    return ok;
+}
+
+int raschetka_run_file(RaschetkaContext *ctx, const char *filename) {
+    precision_enter(ctx);
+    int ok = recon_run(&ctx->rec, context_pool(ctx), filename, ctx->opt.use_cache);
+    precision_leave();
+    return finish_run(ctx, ok, "ошибка чтения файла или недостаточно памяти");
+}
+
+int raschetka_run_text(RaschetkaContext *ctx, const char *text, size_t len) {
+    precision_enter(ctx);
+    int ok = recon_run_buf(&ctx->rec, context_pool(ctx), text, len);
+    precision_leave();
+    return finish_run(ctx, ok, "недостаточно памяти");
+}
+
+int raschetka_run_views(RaschetkaContext *ctx,
+                        const double *xy, size_t nxy,
+                        const double *xz, size_t nxz,
+                        const double *yz, size_t nyz) {
+    precision_enter(ctx);
+    int ok = recon_run_views(&ctx->rec, context_pool(ctx),
+                             (const PointXY *)xy, nxy, (const PointXZ *)xz, nxz,
+                             (const PointYZ *)yz, nyz);
+    precision_leave();
+    return finish_run(ctx, ok, "недостаточно памяти");
+}
+
+const double *raschetka_vertices(const RaschetkaContext *ctx, size_t *n) {
+    *n = ctx->have_result ? ctx->rec.verts.n : 0;
+    return *n ? (const double *)ctx->rec.verts.pts : NULL;
+}
+
+const size_t *raschetka_edges(const RaschetkaContext *ctx, size_t *n) {
+    *n = ctx->have_result ? ctx->rec.nedges : 0;
+    return *n ? (const size_t *)ctx->rec.edges : NULL;
+}
+
+void raschetka_stats(const RaschetkaContext *ctx, RaschetkaStats *s) {
+    const Reconstruction *r = &ctx->rec;
+    memset(s, 0, sizeof(*s));
+    s->nxy = r->nxy;
+    s->nxz = r->nxz;
+    s->nyz = r->nyz;
+    if (!ctx->have_result) return;
+    s->found = r->found;
+    s->vertices = r->verts.n;
+    s->edges = r->nedges;
+    s->from_cache = r->from_cache;
+    s->seconds = r->times.total;
+}
+
+const char *raschetka_error(const RaschetkaContext *ctx) {
+    return ctx->error;
+}
@@ -0,0 +1,83 @@
+#ifndef RASCHETKA_H
+#define RASCHETKA_H
+
+#include <stddef.h>
+
+/* Библиотека восстановления каркаса по трём видам чертежа для встраивания
+   в другие программы (make lib: libraschetka.a и libraschetka.so).
+   Заголовок самодостаточен и подключается из C и C++.
+
+   Контекст хранит пул потоков, арену (проекции, индексы, кандидаты,
+   рёбра) и множество вершин. Повторные запуски на одном контексте
+   переиспользуют всю эту память: после первых чертежей выделений
+   почти нет. Вершины и рёбра отдаются указателями на память контекста
+   без копирования и действительны до следующего запуска или
+   raschetka_destroy.
+
+   Контекст используется одним потоком за раз; разные контексты можно
+   запускать одновременно из разных потоков. Точность сравнения общая
+   для процесса, поэтому одновременно идут только запуски с одинаковыми
+   eps и quantize, а запуск с другой точностью ждёт, пока идущие
+   закончатся (новые запуски с прежней точностью его не обгоняют).
+
+   Функции запуска возвращают 1 при успехе, 0 — при ошибке, текст
+   ошибки даёт raschetka_error */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RaschetkaContext RaschetkaContext;
+
+typedef struct {
+    int threads;       // потоков; 0 — по числу ядер, 1 — всё в вызывающем потоке
+    double eps;        // точность сравнения; 0 — 0.001
+    int quantize;      // 1 — режим квантования с шагом eps (как try -q)
+    int use_cache;     // 1 — двоичный кэш рядом с файлом (только raschetka_run_file)
+} RaschetkaOptions;
+
+/* Итоги последнего запуска */
+typedef struct {
+    size_t nxy, nxz, nyz;   // точек видов
+    size_t found;           // всего совпадений при соединении
+    size_t vertices, edges;
+    int from_cache;
+    double seconds;         // время запуска
+} RaschetkaStats;
+
+/* opt == NULL — настройки по умолчанию. NULL — нет памяти или неверная eps */
+RaschetkaContext *raschetka_create(const RaschetkaOptions *opt);
+void raschetka_destroy(RaschetkaContext *ctx);
+
+/* Чертёж из файла в формате "X 2D.txt" */
+int raschetka_run_file(RaschetkaContext *ctx, const char *filename);
+
+/* Текст чертежа того же формата в памяти, len байт */
+int raschetka_run_text(RaschetkaContext *ctx, const char *text, size_t len);
+
+/* Точки видов парами чисел: xy — (x, y), xz — (x, z), yz — (y, z);
+   nxy и т. д. — число точек (чисел вдвое больше). Порядок — как
+   в чертеже: точки 2k и 2k+1 каждого вида — концы отрезка.
+   Массивы не изменяются и после вызова не нужны */
+int raschetka_run_views(RaschetkaContext *ctx,
+                        const double *xy, size_t nxy,
+                        const double *xz, size_t nxz,
+                        const double *yz, size_t nyz);
+
+/* Вершины последнего запуска тройками (x, y, z); *n — число вершин */
+const double *raschetka_vertices(const RaschetkaContext *ctx, size_t *n);
+
+/* Рёбра последнего запуска парами номеров вершин (с нуля, a < b);
+   *n — число рёбер */
+const size_t *raschetka_edges(const RaschetkaContext *ctx, size_t *n);
+
+void raschetka_stats(const RaschetkaContext *ctx, RaschetkaStats *s);
+
+/* Текст последней ошибки; "" — ошибок не было */
+const char *raschetka_error(const RaschetkaContext *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "compact.h"
+#include "join.h"
+#include "parse.h"
+#include "sort.h"
+#include "recon.h"
+
+int recon_init(Reconstruction *r) {
+    memset(r, 0, sizeof(*r));
+    return arena_init(&r->arena, 0) && pointset_init(&r->verts, 1024);
+}
+
+void recon_free(Reconstruction *r) {
+    pointset_free(&r->verts);
+    arena_free(&r->arena);
+    memset(r, 0, sizeof(*r));
+}
+
+/* Начало чертежа: прошлые вершины и рёбра отбрасываются, арена
+   сбрасывается с оценкой расхода estimate */
+static int recon_begin(Reconstruction *r, size_t estimate) {
+    pointset_clear(&r->verts);
+    r->edges = NULL;
+    r->nedges = 0;
+    r->found = 0;
+    r->from_cache = 0;
+    r->empty_view = 0;
+    r->nxy = r->nxz = r->nyz = 0;
+    memset(r->distinct, 0, sizeof(r->distinct));
+    r->near_boundary = 0;
+    memset(r->lcs, 0, sizeof(r->lcs));
+    r->estimate = estimate;
+    if (!arena_reset(&r->arena, estimate)) return 0;
+    timing_start(&r->times);
+    timing_begin(&r->times, STAGE_READ);
+    return 1;
+}
+
+/* Итоги чтения в r. Пустой вид — 0, pr и wires тогда освобождаются */
+static int recon_read_done(Reconstruction *r, Projections *pr, WireIndex *wires) {
+    r->nxy = pr->nxy_raw;
+    r->nxz = pr->nxz_raw;
+    r->nyz = pr->nyz_raw;
+    r->near_boundary = pr->near_boundary;
+    memcpy(r->lcs, pr->lcs, sizeof(r->lcs));
+    if (pr->nxy == 0 || pr->nxz == 0 || pr->nyz == 0) {
+        r->empty_view = 1;
+        projections_free(pr);
+        wire_index_free(wires);
+        return 0;
+    }
+    return 1;
+}
+
+/* Всё после соединения: отбор вершин из cand, рёбра. pr, wires и cand
+   освобождаются */
+static int recon_finish(Reconstruction *r, Projections *pr, WireIndex *wires,
+                        JoinResult *cand) {
+    r->distinct[VIEW_TOP] = pr->nxy;
+    r->distinct[VIEW_FRONT] = pr->nxz;
+    r->distinct[VIEW_PROFILE] = pr->nyz;
+    projections_free(pr);
+    r->found = cand->found;
+
+    int ok = 1;
+    timing_begin(&r->times, STAGE_DEDUP);
+    for (size_t c = 0; c < cand->n && ok; c++) {
+        ok = pointset_insert(&r->verts, cand->pts[c]) >= 0;
+    }
+    join_result_free(cand);
+    timing_end(&r->times, STAGE_DEDUP);
+
+    if (ok) {
+        timing_begin(&r->times, STAGE_WIRES);
+        ok = find_wires(wires, &r->arena, r->verts.pts, r->verts.n, &r->edges, &r->nedges);
+        timing_end(&r->times, STAGE_WIRES);
+    }
+    wire_index_free(wires);
+
+    timing_finish(&r->times);
+    return ok;
+}
+
+/* Всё после чтения: индекс отрезков, сортировка (если pr ещё не из
+   кэша), соединение, отбор вершин, рёбра. pr и wires освобождаются.
+   cache_file != NULL — отсортированные проекции записываются в кэш */
+static int recon_solve(Reconstruction *r, WorkerPool *pool, Projections *pr,
+                       WireIndex *wires, const char *cache_file, const char *file) {
+    timing_end(&r->times, STAGE_READ);
+    if (!recon_read_done(r, pr, wires)) return 0;
+
+    if (!r->from_cache) {
+        // Отрезки видов берутся из пар точек в порядке файла — до сортировки
+        timing_begin(&r->times, STAGE_WIRES);
+        if (!wire_index_build(wires, &r->arena, pr)) {
+            projections_free(pr);
+            return 0;
+        }
+        timing_end(&r->times, STAGE_WIRES);
+
+        timing_begin(&r->times, STAGE_SORT);
+        if (!sort_projections(pool, pr->xy, pr->nxy, pr->xz, pr->nxz, pr->yz, pr->nyz) ||
+            !compact_projections(pool, pr)) {
+            projections_free(pr);
+            wire_index_free(wires);
+            return 0;
+        }
+        timing_end(&r->times, STAGE_SORT);
+
+        if (cache_file && !cache_save(cache_file, file, pr, wires))
+            fprintf(stderr, "Предупреждение: не удалось записать кэш %s\n", cache_file);
+    }
+
+    timing_begin(&r->times, STAGE_JOIN);
+    JoinResult cand;
+    if (!join_xyz(pool, &r->arena, pr->xy, pr->mxy, pr->nxy, pr->xz, pr->mxz, pr->nxz,
+                  pr->yz, pr->nyz, &cand)) {
+        projections_free(pr);
+        wire_index_free(wires);
+        return 0;
+    }
+    timing_end(&r->times, STAGE_JOIN);
+    return recon_finish(r, pr, wires, &cand);
+}
+
+int recon_run(Reconstruction *r, WorkerPool *pool, const char *file, int use_cache) {
+    struct stat st;
+    size_t estimate = stat(file, &st) == 0 ? (size_t)st.st_size * RECON_ARENA_PER_BYTE : 0;
+    if (!recon_begin(r, estimate)) return 0;
+
+    Projections pr;
+    WireIndex wires;
+    memset(&wires, 0, sizeof(wires));
+    char cache_file[4096];
+    if (use_cache) {
+        cache_path(file, cache_file, sizeof(cache_file));
+        r->from_cache = cache_load(cache_file, file, &pr, &wires);
+    }
+    if (!r->from_cache && !parse_projections(pool, &r->arena, file, &pr)) return 0;
+    return recon_solve(r, pool, &pr, &wires, use_cache ? cache_file : NULL, file);
+}
+
+int recon_run_pipelined(Reconstruction *r, WorkerPool *pool, const char *file,
+                        PipelineStats *st) {
+    struct stat sb;
+    size_t estimate = stat(file, &sb) == 0 ? (size_t)sb.st_size * RECON_ARENA_PER_BYTE : 0;
+    if (!recon_begin(r, estimate)) return 0;
+
+    // Времена чтения, индекса, сортировки и соединения конвейер ставит сам
+    Projections pr;
+    WireIndex wires;
+    JoinResult cand;
+    memset(&wires, 0, sizeof(wires));
+    if (!pipeline_run(pool, &r->arena, file, &pr, &wires, &cand, &r->times, st)) return 0;
+    if (!recon_read_done(r, &pr, &wires)) {
+        join_result_free(&cand);
+        return 0;
+    }
+    return recon_finish(r, &pr, &wires, &cand);
+}
+
+int recon_run_buf(Reconstruction *r, WorkerPool *pool, const char *buf, size_t len) {
+    if (!recon_begin(r, len * RECON_ARENA_PER_BYTE)) return 0;
+    Projections pr;
+    WireIndex wires;
+    memset(&wires, 0, sizeof(wires));
+    if (!parse_projections_buf(pool, &r->arena, buf, len, &pr)) return 0;
+    return recon_solve(r, pool, &pr, &wires, NULL, NULL);
+}
+
+int recon_run_views(Reconstruction *r, WorkerPool *pool,
+                    const PointXY *xy, size_t nxy, const PointXZ *xz, size_t nxz,
+                    const PointYZ *yz, size_t nyz) {
+    size_t bytes = (nxy + nxz + nyz) * sizeof(PointXY);
+    if (!recon_begin(r, bytes * RECON_ARENA_PER_BYTE)) return 0;
+    Projections pr;
+    WireIndex wires;
+    memset(&wires, 0, sizeof(wires));
+    if (!projections_from_views(&r->arena, xy, nxy, xz, nxz, yz, nyz, &pr)) return 0;
+    return recon_solve(r, pool, &pr, &wires, NULL, NULL);
+}
@@ -0,0 +1,66 @@
+#ifndef RECON_H
+#define RECON_H
+
+#include <stddef.h>
+#include "arena.h"
+#include "geom.h"
+#include "pipeline.h"
+#include "pointset.h"
+#include "pool.h"
+#include "timing.h"
+#include "wires.h"
+
+/* Полное восстановление одного чертежа: чтение (или кэш), индекс
+   отрезков, сортировка, соединение видов, отбор вершин, рёбра.
+   Структура переиспользуется между чертежами: множество вершин
+   очищается, а не создаётся заново. Проекции, индексы и кандидаты
+   соединения берутся из арены, которая сбрасывается в начале
+   следующего чертежа; её основной блок заказывается по размеру файла
+   (RECON_ARENA_PER_BYTE) и в пакете дорастает до наибольшего расхода.
+   Рёбра тоже лежат в арене: они действительны до следующего запуска */
+/* Расход арены на байт текстового чертежа (измерено на случайных
+   моделях, с запасом) */
+#define RECON_ARENA_PER_BYTE 10
+
+typedef struct {
+    PointSet verts;
+    Edge3D *edges;
+    size_t nedges;
+    size_t nxy, nxz, nyz;
+    size_t distinct[VIEW_COUNT];    // различных точек видов после сжатия
+    size_t near_boundary;           // координат у середины между узлами квантования
+    double lcs[VIEW_COUNT][2];      // lcsX, lcsY каждого вида
+    size_t estimate;                // оценка расхода арены на этот чертёж, байт
+    size_t found;          // всего совпадений при соединении
+    int from_cache;
+    int empty_view;        // чертёж прочитан, но какой-то вид пуст
+    Arena arena;
+    StageTimes times;
+} Reconstruction;
+
+int recon_init(Reconstruction *r);
+void recon_free(Reconstruction *r);
+
+/* Восстановление чертежа file. pool == NULL — все этапы в вызывающем
+   потоке (так чертежи раздаются потокам пула целиком). use_cache —
+   читать и писать двоичный кэш (cache.h). Пустой вид — ошибка.
+   Возвращает 1 при успехе */
+int recon_run(Reconstruction *r, WorkerPool *pool, const char *file, int use_cache);
+
+/* То же конвейером (pipeline.h): чтение, сортировка и соединение
+   одновременно, без кэша. pool обязателен, st — статистика конвейера */
+int recon_run_pipelined(Reconstruction *r, WorkerPool *pool, const char *file,
+                        PipelineStats *st);
+
+/* То же для текста чертежа в памяти (без кэша) */
+int recon_run_buf(Reconstruction *r, WorkerPool *pool, const char *buf, size_t len);
+
+/* То же для готовых массивов видов в порядке чертежа: соседние пары
+   точек — отрезки (projections_from_views). Массивы не изменяются.
+   Оценка арены — та же RECON_ARENA_PER_BYTE на байт массивов: точка
+   в тексте чертежа занимает примерно столько же, сколько два double */
+int recon_run_views(Reconstruction *r, WorkerPool *pool,
+                    const PointXY *xy, size_t nxy, const PointXZ *xz, size_t nxz,
+                    const PointYZ *yz, size_t nyz);
+
+#endif
@@ -0,0 +1,406 @@
+#define _GNU_SOURCE   // accept4, pipe2
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "geom.h"
+#include "pool.h"
+#include "proto.h"
+#include "recon.h"
+#include "timing.h"
+#include "writer.h"
+#include "../common/log.h"
+
+/* Сервер восстановления: чертежи приходят по Unix-сокету (proto.h),
+   каждый поток держит свою Reconstruction и буфер ответа, поэтому
+   после первых запросов память не выделяется и потоки не создаются.
+   Главный поток ждёт в poll на всех соединениях; соединение, в котором
+   пришёл запрос, уходит в очередь, свободный поток читает запрос,
+   восстанавливает чертёж в одном потоке (как пакетный режим при многих
+   чертежах), отвечает и возвращает соединение главному потоку через pipe */
+
+/* Сколько ждать тела запроса, с: зависший клиент не держит поток вечно */
+#define SERVE_RECV_TIMEOUT 10
+
+/* Сокет доступен локальным пользователям, поэтому чертежи по пути
+   читаются только из корня (-r), кэш (-c) пишется только рядом с ними,
+   а размер запроса ограничен (-l): память под тело заказывается по
+   заголовку до чтения */
+
+typedef struct Server Server;
+
+typedef struct {
+    Server *srv;
+    pthread_t thread;
+    Reconstruction rec;
+    Writer out;            // ответ OUT_BIN, буфер переиспользуется
+    char *req;             // тело запроса
+    size_t req_cap;
+    char joined[PATH_MAX]; // путь запроса от корня
+    char path[PATH_MAX];   // он же после раскрытия ссылок
+    size_t served, failed;
+    double busy;           // время восстановления, с
+} ServeWorker;
+
+struct Server {
+    int use_cache;
+    char root[PATH_MAX];   // корень путей запросов, раскрытый
+    size_t root_len;
+    uint64_t max_request;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int *queue;            // соединения с пришедшим запросом, кольцо
+    size_t head, count, cap;
+    int stop;
+    int back[2];           // соединения, ждущие следующего запроса
+};
+
+static volatile sig_atomic_t stop_flag = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_flag = 1;
+}
+
+/* ----------------------------------------- */
+/* Очередь соединений */
+static int queue_push(Server *s, int fd) {
+    pthread_mutex_lock(&s->lock);
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 64;
+        int *resized = (int *)malloc(cap * sizeof(int));
+        if (!resized) {
+            pthread_mutex_unlock(&s->lock);
+            return 0;
+        }
+        for (size_t i = 0; i < s->count; i++) resized[i] = s->queue[(s->head + i) % s->cap];
+        free(s->queue);
+        s->queue = resized;
+        s->head = 0;
+        s->cap = cap;
+    }
+    s->queue[(s->head + s->count) % s->cap] = fd;
+    s->count++;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    return 1;
+}
+
+/* Следующее соединение; -1 — сервер останавливается */
+static int queue_pop(Server *s) {
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0 && !s->stop) pthread_cond_wait(&s->wake, &s->lock);
+    int fd = -1;
+    if (s->count > 0) {
+        fd = s->queue[s->head];
+        s->head = (s->head + 1) % s->cap;
+        s->count--;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return fd;
+}
+
+/* ----------------------------------------- */
+static int reply_error(int fd, uint32_t status, const char *msg) {
+    ProtoReply rp = {PROTO_MAGIC, status, strlen(msg)};
+    return proto_send(fd, &rp, sizeof(rp), msg, rp.len);
+}
+
+static int request_buffer(ServeWorker *w, size_t n) {
+    if (n <= w->req_cap) return 1;
+    size_t cap = w->req_cap ? w->req_cap : 1 << 16;
+    while (cap < n) cap *= 2;
+    char *resized = (char *)realloc(w->req, cap);
+    if (!resized) return 0;
+    w->req = resized;
+    w->req_cap = cap;
+    return 1;
+}
+
+/* Путь запроса PROTO_PATH: относительный берётся от корня, ссылки и ".."
+   раскрываются, итог должен лежать внутри корня. Возвращает раскрытый
+   путь (w->path) или NULL */
+static const char *request_path(ServeWorker *w, const char *req) {
+    const Server *srv = w->srv;
+    const char *p = req;
+    if (req[0] != '/') {
+        int n = snprintf(w->joined, sizeof(w->joined), "%s/%s", srv->root, req);
+        if (n < 0 || (size_t)n >= sizeof(w->joined)) return NULL;
+        p = w->joined;
+    }
+    if (!realpath(p, w->path)) return NULL;
+    size_t n = srv->root_len;
+    if (strncmp(w->path, srv->root, n) != 0 || (n > 1 && w->path[n] != '/')) return NULL;
+    return w->path;
+}
+
+/* Один запрос соединения fd. Возвращает 1, если соединение остаётся
+   открытым для следующего запроса */
+static int serve_request(ServeWorker *w, int fd) {
+    ProtoRequest rq;
+    if (!proto_read_all(fd, &rq, sizeof(rq))) return 0;   // клиент закрыл соединение
+    if (rq.magic != PROTO_MAGIC || (rq.kind != PROTO_TEXT && rq.kind != PROTO_PATH) ||
+        rq.len > w->srv->max_request) {
+        // Дальше поток не разобрать — соединение закрывается
+        reply_error(fd, PROTO_BAD_REQUEST, "неверный запрос");
+        return 0;
+    }
+    if (!request_buffer(w, (size_t)rq.len + 1)) {
+        reply_error(fd, PROTO_FAILED, "недостаточно памяти");
+        return 0;
+    }
+    if (!proto_read_all(fd, w->req, (size_t)rq.len)) return 0;
+    w->req[rq.len] = '\0';
+
+    const char *path = NULL;
+    if (rq.kind == PROTO_PATH && !(path = request_path(w, w->req))) {
+        w->served++;
+        w->failed++;
+        log_warn("Запрос %s: путь вне корня %s или файла нет\n", w->req, w->srv->root);
+        return reply_error(fd, PROTO_FAILED, "путь вне корня сервера или файла нет");
+    }
+
+    Reconstruction *r = &w->rec;
+    double started = timing_now();
+    int ok = rq.kind == PROTO_TEXT ?
+             recon_run_buf(r, NULL, w->req, (size_t)rq.len) :
+             recon_run(r, NULL, path, w->srv->use_cache);
+    if (ok) {
+        ResultData rd = {r->verts.pts, r->verts.n, r->edges, r->nedges, NULL, NULL};
+        writer_clear(&w->out);
+        ok = write_result(&w->out, OUT_BIN, &rd);
+    }
+    w->busy += timing_now() - started;
+    w->served++;
+
+    if (!ok) {
+        w->failed++;
+        char msg[160];
+        if (r->empty_view)
+            snprintf(msg, sizeof(msg), "недостаточно данных: topView %zu, frontView %zu, "
+                     "profileView %zu", r->nxy, r->nxz, r->nyz);
+        else
+            snprintf(msg, sizeof(msg), "ошибка чтения чертежа или недостаточно памяти");
+        log_warn("Запрос %s: %s\n", rq.kind == PROTO_PATH ? w->req : "(текст)", msg);
+        return reply_error(fd, PROTO_FAILED, msg);
+    }
+    ProtoReply rp = {PROTO_MAGIC, PROTO_OK, w->out.len};
+    return proto_send(fd, &rp, sizeof(rp), w->out.buf, w->out.len);
+}
+
+static void *serve_worker(void *arg) {
+    ServeWorker *w = (ServeWorker *)arg;
+    for (;;) {
+        int fd = queue_pop(w->srv);
+        if (fd < 0) break;
+        if (!serve_request(w, fd) ||
+            write(w->srv->back[1], &fd, sizeof(fd)) != (ssize_t)sizeof(fd))
+            close(fd);
+    }
+    return NULL;
+}
+
+/* ----------------------------------------- */
+/* Соединения, ждущие запроса, для poll; [0] — слушающий сокет,
+   [1] — возврат соединений от потоков */
+typedef struct {
+    struct pollfd *p;
+    size_t n, cap;
+} PollSet;
+
+static int pollset_add(PollSet *ps, int fd) {
+    if (ps->n == ps->cap) {
+        size_t cap = ps->cap ? ps->cap * 2 : 64;
+        struct pollfd *resized = (struct pollfd *)realloc(ps->p, cap * sizeof(*resized));
+        if (!resized) return 0;
+        ps->p = resized;
+        ps->cap = cap;
+    }
+    ps->p[ps->n++] = (struct pollfd){fd, POLLIN, 0};
+    return 1;
+}
+
+static void accept_all(int listen_fd, PollSet *ps) {
+    struct timeval tv = {SERVE_RECV_TIMEOUT, 0};
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) log_error("accept: %s\n", strerror(errno));
+            return;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (!pollset_add(ps, fd)) close(fd);
+    }
+}
+
+/* Главный цикл: до сигнала остановки */
+static void serve_loop(Server *srv, int listen_fd) {
+    PollSet ps = {NULL, 0, 0};
+    if (!pollset_add(&ps, listen_fd) || !pollset_add(&ps, srv->back[0])) {
+        log_error("Ошибка: недостаточно памяти\n");
+        free(ps.p);
+        return;
+    }
+
+    while (!stop_flag) {
+        if (poll(ps.p, ps.n, -1) < 0) {
+            if (errno == EINTR) continue;
+            log_error("poll: %s\n", strerror(errno));
+            break;
+        }
+        // Пришёл запрос или соединение закрыто — дальше его ведёт поток
+        for (size_t i = 2; i < ps.n;) {
+            if (ps.p[i].revents) {
+                if (!queue_push(srv, ps.p[i].fd)) close(ps.p[i].fd);
+                ps.p[i] = ps.p[--ps.n];
+            } else {
+                i++;
+            }
+        }
+        if (ps.p[1].revents & POLLIN) {
+            int fds[256];
+            ssize_t got = read(srv->back[0], fds, sizeof(fds));
+            for (ssize_t k = 0; k < got / (ssize_t)sizeof(int); k++) {
+                if (!pollset_add(&ps, fds[k])) close(fds[k]);
+            }
+        }
+        if (ps.p[0].revents & POLLIN) accept_all(listen_fd, &ps);
+    }
+
+    for (size_t i = 2; i < ps.n; i++) close(ps.p[i].fd);
+    free(ps.p);
+}
+
+/* ----------------------------------------- */
+int main(int argc, char *argv[]) {
+    const char *socket_path = PROTO_SOCKET_DEFAULT;
+    int nworkers = pool_default_threads();
+    double eps = EPS_DEFAULT;
+    int quantize = 0;
+    int use_cache = 0;
+    const char *root = PROTO_ROOT_DEFAULT;
+    unsigned mode = PROTO_SOCKET_MODE;
+    uint64_t max_request = PROTO_MAX_REQUEST;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            nworkers = atoi(argv[++i]);
+            if (nworkers < 1) nworkers = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            eps = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quantize") == 0) {
+            quantize = 1;
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cache") == 0) {
+            use_cache = 1;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            mode = (unsigned)strtoul(argv[++i], NULL, 8) & 0777;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            max_request = strtoull(argv[++i], NULL, 10);
+            if (max_request == 0) max_request = PROTO_MAX_REQUEST;
+        } else {
+            fprintf(stderr, "Использование: %s [-s сокет] [-m права] [-w потоков] [-e eps] "
+                    "[-q] [-c] [-r корень] [-l байт]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!(quantize ? geom_set_quantized(eps) : geom_set_eps(eps))) {
+        log_error("Неверная точность: %g\n", eps);
+        return 1;
+    }
+
+    Server srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.use_cache = use_cache;
+    srv.max_request = max_request;
+    if (!realpath(root, srv.root)) {
+        log_error("Корень путей %s: %s\n", root, strerror(errno));
+        return 1;
+    }
+    srv.root_len = strlen(srv.root);
+    pthread_mutex_init(&srv.lock, NULL);
+    pthread_cond_init(&srv.wake, NULL);
+
+    // Закрытый клиентом сокет — ошибка записи, а не завершение сервера
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    int listen_fd = proto_listen(socket_path, mode);
+    if (listen_fd < 0) return 1;
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    if (pipe2(srv.back, O_CLOEXEC) != 0) {
+        log_error("pipe: %s\n", strerror(errno));
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    ServeWorker *workers = (ServeWorker *)calloc((size_t)nworkers, sizeof(ServeWorker));
+    int started = 0, ok = workers != NULL;
+    for (int i = 0; i < nworkers && ok; i++) {
+        ServeWorker *w = &workers[i];
+        w->srv = &srv;
+        ok = recon_init(&w->rec) && writer_open_mem(&w->out) &&
+             pthread_create(&w->thread, NULL, serve_worker, w) == 0;
+        if (ok) started++;
+    }
+
+    if (ok) {
+        printf("Сервер восстановления: сокет %s (права %03o), потоков %d, EPS = %g%s\n"
+               "  пути от %s, запрос до %llu байт\n",
+               socket_path, mode, nworkers, EPS, geom_step > 0.0 ? " (квантование)" : "",
+               srv.root, (unsigned long long)max_request);
+        fflush(stdout);
+        serve_loop(&srv, listen_fd);
+    } else {
+        log_error("Ошибка запуска потоков сервера\n");
+    }
+
+    pthread_mutex_lock(&srv.lock);
+    srv.stop = 1;
+    pthread_cond_broadcast(&srv.wake);
+    pthread_mutex_unlock(&srv.lock);
+    size_t served = 0, failed = 0;
+    double busy = 0.0;
+    for (int i = 0; i < started; i++) pthread_join(workers[i].thread, NULL);
+    for (int i = 0; workers && i < nworkers; i++) {
+        served += workers[i].served;
+        failed += workers[i].failed;
+        busy += workers[i].busy;
+        recon_free(&workers[i].rec);
+        if (workers[i].out.buf) writer_close(&workers[i].out);
+        free(workers[i].req);
+    }
+    for (size_t i = 0; i < srv.count; i++) close(srv.queue[(srv.head + i) % srv.cap]);
+
+    printf("\nСервер остановлен: запросов %zu, с ошибками %zu, "
+           "восстановление в среднем %.3f мс\n",
+           served, failed, served ? busy * 1000.0 / (double)served : 0.0);
+    free(workers);
+    free(srv.queue);
+    close(srv.back[0]);
+    close(srv.back[1]);
+    close(listen_fd);
+    unlink(socket_path);
+    pthread_mutex_destroy(&srv.lock);
+    pthread_cond_destroy(&srv.wake);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "geom.h"
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+/* ----------------------------------------- */
+/* Обычный цикл */
+static size_t eps_filter_scalar(const double *a, size_t n, double v, size_t *out) {
+    size_t m = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (approx_eq(a[k], v)) out[m++] = k;
+    }
+    return m;
+}
+
+#ifdef SIMD_X86
+/* ----------------------------------------- */
+/* AVX2: |a - v| считается как в approx_eq — вычитание и сброс знака,
+   сравнение <= без учёта NaN, поэтому отбор совпадает побитово */
+__attribute__((target("avx2")))
+static size_t eps_filter_avx2(const double *a, size_t n, double v, size_t *out) {
+    const __m256d vv = _mm256_set1_pd(v);
+    const __m256d eps = _mm256_set1_pd(EPS);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t m = 0, k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a + k), vv));
+        unsigned bits = (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(d, eps, _CMP_LE_OQ));
+        while (bits) {
+            out[m++] = k + (size_t)__builtin_ctz(bits);
+            bits &= bits - 1;
+        }
+    }
+    for (; k < n; k++) {
+        if (approx_eq(a[k], v)) out[m++] = k;
+    }
+    return m;
+}
+
+/* ----------------------------------------- */
+/* AVX-512: хвост короче 8 чисел читается маскированной загрузкой */
+__attribute__((target("avx512f")))
+static size_t eps_filter_avx512(const double *a, size_t n, double v, size_t *out) {
+    const __m512d vv = _mm512_set1_pd(v);
+    const __m512d eps = _mm512_set1_pd(EPS);
+    size_t m = 0;
+    for (size_t k = 0; k < n; k += 8) {
+        __mmask8 load = n - k >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - k)) - 1);
+        __m512d d = _mm512_abs_pd(_mm512_sub_pd(_mm512_maskz_loadu_pd(load, a + k), vv));
+        unsigned bits = _mm512_mask_cmp_pd_mask(load, d, eps, _CMP_LE_OQ);
+        while (bits) {
+            out[m++] = k + (size_t)__builtin_ctz(bits);
+            bits &= bits - 1;
+        }
+    }
+    return m;
+}
+#endif
+
+/* ----------------------------------------- */
+/* Выбор варианта */
+typedef size_t (*FilterFn)(const double *, size_t, double, size_t *);
+
+static FilterFn filter_fn = eps_filter_scalar;
+static const char *level_name = "scalar";
+static pthread_once_t dispatch_once = PTHREAD_ONCE_INIT;
+
+static void simd_dispatch(void) {
+#ifdef SIMD_X86
+    const char *limit = getenv("RASCHETKA_SIMD");
+    int allow512 = !limit || strcmp(limit, "avx512") == 0;
+    int allow256 = allow512 || strcmp(limit, "avx2") == 0;
+
+    __builtin_cpu_init();
+    if (allow512 && __builtin_cpu_supports("avx512f")) {
+        filter_fn = eps_filter_avx512;
+        level_name = "avx512";
+    } else if (allow256 && __builtin_cpu_supports("avx2")) {
+        filter_fn = eps_filter_avx2;
+        level_name = "avx2";
+    }
+#endif
+}
+
+size_t eps_filter(const double *a, size_t n, double v, size_t *out) {
+    pthread_once(&dispatch_once, simd_dispatch);
+    return filter_fn(a, n, v, out);
+}
+
+const char *simd_level_name(void) {
+    pthread_once(&dispatch_once, simd_dispatch);
+    return level_name;
+}
@@ -0,0 +1,20 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+
+/* Отбор координат по EPS векторными командами.
+   Набор команд выбирается один раз при первом вызове по возможностям
+   процессора: AVX-512 (8 чисел за команду), AVX2 (4 числа) или обычный
+   цикл. Переменная окружения RASCHETKA_SIMD=scalar|avx2|avx512 ограничивает
+   выбор — для сравнения и отладки. Результаты всех вариантов совпадают
+   с approx_eq побитово */
+
+/* Номера k из [0, n) с |a[k] - v| <= EPS по возрастанию; out — не меньше n.
+   Возвращает количество */
+size_t eps_filter(const double *a, size_t n, double v, size_t *out);
+
+/* Название выбранного набора команд: "avx512", "avx2" или "scalar" */
+const char *simd_level_name(void);
+
+#endif
@@ -0,0 +1,323 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sort.h"
+
+/* Короткие массивы сортируются вставками */
+#define SMALL_SORT 64
+
+/* Минимальный размер блока, ради которого стоит отдельная задача пула */
+#define BLOCK_MIN (1 << 15)
+
+/* 16 проходов по 8 бит: младшие — ключ второй координаты, старшие — первой */
+#define RADIX_PASSES 16
+
+/* Ключ ячейки со сдвигом к нулю: порядок сохраняется и для отрицательных */
+static inline uint64_t cell_key(double v, double inv, long long min) {
+    return (uint64_t)grid_key(v, inv) - (uint64_t)min;
+}
+
+/* Сортировка одного массива, разбитого на блоки */
+typedef struct {
+    int view;                   // VIEW_TOP, VIEW_FRONT или VIEW_PROFILE
+    void *a, *tmp;
+    void *src, *dst;            // источник и приёмник текущего прохода
+    size_t n;
+    size_t nblocks;
+    double inv;
+    long long min_a, min_b;
+    long long (*block_min)[2];  // [nblocks]
+    size_t (*hist)[RADIX_PASSES][256];  // [nblocks]: все проходы сразу
+    size_t (*offset)[256];      // [nblocks]: смещения текущего прохода
+    size_t count[RADIX_PASSES][256];
+} SortView;
+
+typedef struct {
+    SortView *views;
+    int nviews;
+    size_t ntasks;
+    int pass;
+} SortJob;
+
+/* Типизированные операции над блоком для структуры TYPE с полями A
+   (старший ключ) и B (младший ключ). Элементы переносятся присваиванием */
+#define DEFINE_VIEW_OPS(NAME, TYPE, A, B)                                     \
+static void NAME##_insertion(TYPE *a, size_t n, double inv) {                \
+    for (size_t i = 1; i < n; i++) {                                          \
+        TYPE v = a[i];                                                        \
+        long long va = grid_key(v.A, inv), vb = grid_key(v.B, inv);           \
+        size_t j = i;                                                         \
+        while (j > 0) {                                                       \
+            long long pa = grid_key(a[j-1].A, inv);                           \
+            long long pb = grid_key(a[j-1].B, inv);                           \
+            if (pa < va || (pa == va && pb <= vb)) break;                     \
+            a[j] = a[j-1];                                                    \
+            j--;                                                              \
+        }                                                                     \
+        a[j] = v;                                                             \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void NAME##_min(SortView *v, size_t lo, size_t hi, long long *m) {     \
+    const TYPE *a = (const TYPE *)v->a;                                       \
+    m[0] = grid_key(a[lo].A, v->inv);                                         \
+    m[1] = grid_key(a[lo].B, v->inv);                                         \
+    for (size_t i = lo + 1; i < hi; i++) {                                    \
+        long long ka = grid_key(a[i].A, v->inv);                              \
+        long long kb = grid_key(a[i].B, v->inv);                              \
+        if (ka < m[0]) m[0] = ka;                                             \
+        if (kb < m[1]) m[1] = kb;                                             \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void NAME##_hist(SortView *v, size_t lo, size_t hi,                   \
+                        size_t (*h)[256]) {                                   \
+    const TYPE *a = (const TYPE *)v->a;                                       \
+    for (size_t i = lo; i < hi; i++) {                                        \
+        uint64_t kb = cell_key(a[i].B, v->inv, v->min_b);                     \
+        uint64_t ka = cell_key(a[i].A, v->inv, v->min_a);                     \
+        for (int p = 0; p < 8; p++) {                                         \
+            h[p][(kb >> (8 * p)) & 0xFF]++;                                   \
+            h[p + 8][(ka >> (8 * p)) & 0xFF]++;                               \
+        }                                                                     \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void NAME##_scatter(SortView *v, size_t lo, size_t hi, int pass,      \
+                           size_t *off) {                                     \
+    const TYPE *src = (const TYPE *)v->src;                                   \
+    TYPE *dst = (TYPE *)v->dst;                                               \
+    int shift = 8 * (pass & 7);                                               \
+    for (size_t i = lo; i < hi; i++) {                                        \
+        uint64_t k = pass < 8 ? cell_key(src[i].B, v->inv, v->min_b)          \
+                              : cell_key(src[i].A, v->inv, v->min_a);         \
+        dst[off[(k >> shift) & 0xFF]++] = src[i];                             \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void NAME##_pass_hist(SortView *v, size_t lo, size_t hi, int pass,    \
+                             size_t *h) {                                     \
+    const TYPE *src = (const TYPE *)v->src;                                   \
+    int shift = 8 * (pass & 7);                                               \
+    memset(h, 0, 256 * sizeof(size_t));                                       \
+    for (size_t i = lo; i < hi; i++) {                                        \
+        uint64_t k = pass < 8 ? cell_key(src[i].B, v->inv, v->min_b)          \
+                              : cell_key(src[i].A, v->inv, v->min_a);         \
+        h[(k >> shift) & 0xFF]++;                                             \
+    }                                                                         \
+}
+
+DEFINE_VIEW_OPS(xy, PointXY, x, y)
+DEFINE_VIEW_OPS(xz, PointXZ, x, z)
+DEFINE_VIEW_OPS(yz, PointYZ, y, z)
+
+/* Выбор типизированной операции по виду */
+#define VIEW_CALL(v, OP, ...)                                                 \
+    do {                                                                      \
+        if ((v)->view == VIEW_TOP) xy_##OP(__VA_ARGS__);                      \
+        else if ((v)->view == VIEW_FRONT) xz_##OP(__VA_ARGS__);               \
+        else yz_##OP(__VA_ARGS__);                                            \
+    } while (0)
+
+/* ----------------------------------------- */
+/* Задачи пула: номер задачи — сквозной номер блока по всем массивам */
+static SortView *task_block(SortJob *job, size_t task, size_t *lo, size_t *hi,
+                            size_t *block) {
+    *lo = *hi = *block = 0;
+    for (int i = 0; i < job->nviews; i++) {
+        SortView *v = &job->views[i];
+        if (task < v->nblocks) {
+            *block = task;
+            *lo = task * v->n / v->nblocks;
+            *hi = (task + 1) * v->n / v->nblocks;
+            return v;
+        }
+        task -= v->nblocks;
+    }
+    return NULL;
+}
+
+static void min_task(void *arg, size_t task) {
+    size_t lo, hi, b;
+    SortView *v = task_block((SortJob*)arg, task, &lo, &hi, &b);
+    VIEW_CALL(v, min, v, lo, hi, v->block_min[b]);
+}
+
+static void hist_task(void *arg, size_t task) {
+    size_t lo, hi, b;
+    SortView *v = task_block((SortJob*)arg, task, &lo, &hi, &b);
+    VIEW_CALL(v, hist, v, lo, hi, v->hist[b]);
+}
+
+static int pass_trivial(const SortView *v, int pass) {
+    for (int b = 0; b < 256; b++) {
+        if (v->count[pass][b] == v->n) return 1;
+    }
+    return 0;
+}
+
+static void pass_hist_task(void *arg, size_t task) {
+    SortJob *job = (SortJob*)arg;
+    size_t lo, hi, b;
+    SortView *v = task_block(job, task, &lo, &hi, &b);
+    if (pass_trivial(v, job->pass)) return;
+    VIEW_CALL(v, pass_hist, v, lo, hi, job->pass, v->offset[b]);
+}
+
+static void scatter_task(void *arg, size_t task) {
+    SortJob *job = (SortJob*)arg;
+    size_t lo, hi, b;
+    SortView *v = task_block(job, task, &lo, &hi, &b);
+    if (pass_trivial(v, job->pass)) return;
+    VIEW_CALL(v, scatter, v, lo, hi, job->pass, v->offset[b]);
+}
+
+static void run_tasks(WorkerPool *pool, PoolTask fn, SortJob *job) {
+    if (pool) {
+        pool_run(pool, fn, job, job->ntasks);
+    } else {
+        for (size_t t = 0; t < job->ntasks; t++) fn(job, t);
+    }
+}
+
+/* Гистограммы блоков текущего прохода -> смещения блоков в приёмнике.
+   Блок b получает участок корзины после всех блоков с меньшим номером,
+   поэтому сортировка остаётся устойчивой */
+static void pass_offsets(SortView *v) {
+    size_t sum = 0;
+    for (int k = 0; k < 256; k++) {
+        for (size_t b = 0; b < v->nblocks; b++) {
+            size_t c = v->offset[b][k];
+            v->offset[b][k] = sum;
+            sum += c;
+        }
+    }
+}
+
+static void view_free(SortView *v) {
+    free(v->tmp);
+    free(v->block_min);
+    free(v->hist);
+    free(v->offset);
+    v->tmp = NULL;
+    v->block_min = NULL;
+    v->hist = NULL;
+    v->offset = NULL;
+}
+
+static int view_init(SortView *v, int view, void *a, size_t n, int nthreads) {
+    memset(v, 0, sizeof(*v));
+    v->view = view;
+    v->a = a;
+    v->n = n;
+    v->inv = grid_inv_cell();
+    if (n <= SMALL_SORT) {
+        // Блоков нет — массив сортируется сразу
+        VIEW_CALL(v, insertion, a, n, v->inv);
+        return 1;
+    }
+
+    v->nblocks = n / BLOCK_MIN;
+    if (v->nblocks > (size_t)nthreads) v->nblocks = (size_t)nthreads;
+    if (v->nblocks < 1) v->nblocks = 1;
+
+    size_t elem = view == VIEW_TOP ? sizeof(PointXY) :
+                  view == VIEW_FRONT ? sizeof(PointXZ) : sizeof(PointYZ);
+    v->tmp = malloc(n * elem);
+    v->block_min = calloc(v->nblocks, sizeof(*v->block_min));
+    v->hist = calloc(v->nblocks, sizeof(*v->hist));
+    v->offset = calloc(v->nblocks, sizeof(*v->offset));
+    if (!v->tmp || !v->block_min || !v->hist || !v->offset) {
+        view_free(v);
+        return 0;
+    }
+    return 1;
+}
+
+static int sort_views(WorkerPool *pool, SortView *views, int nviews) {
+    SortJob job = {views, nviews, 0, 0};
+    for (int i = 0; i < nviews; i++) job.ntasks += views[i].nblocks;
+    if (job.ntasks == 0) return 1;
+
+    run_tasks(pool, min_task, &job);
+    for (int i = 0; i < nviews; i++) {
+        SortView *v = &views[i];
+        for (size_t b = 0; b < v->nblocks; b++) {
+            if (b == 0 || v->block_min[b][0] < v->min_a) v->min_a = v->block_min[b][0];
+            if (b == 0 || v->block_min[b][1] < v->min_b) v->min_b = v->block_min[b][1];
+        }
+    }
+
+    run_tasks(pool, hist_task, &job);
+    for (int i = 0; i < nviews; i++) {
+        SortView *v = &views[i];
+        for (size_t b = 0; b < v->nblocks; b++) {
+            for (int p = 0; p < RADIX_PASSES; p++) {
+                for (int k = 0; k < 256; k++) v->count[p][k] += v->hist[b][p][k];
+            }
+        }
+        v->src = v->a;
+        v->dst = v->tmp;
+    }
+
+    for (int p = 0; p < RADIX_PASSES; p++) {
+        int active = 0;
+        for (int i = 0; i < nviews; i++) {
+            if (views[i].nblocks && !pass_trivial(&views[i], p)) active = 1;
+        }
+        if (!active) continue;
+
+        job.pass = p;
+        run_tasks(pool, pass_hist_task, &job);
+        for (int i = 0; i < nviews; i++) {
+            if (views[i].nblocks && !pass_trivial(&views[i], p)) pass_offsets(&views[i]);
+        }
+        run_tasks(pool, scatter_task, &job);
+        for (int i = 0; i < nviews; i++) {
+            SortView *v = &views[i];
+            if (!v->nblocks || pass_trivial(v, p)) continue;
+            void *t = v->src;
+            v->src = v->dst;
+            v->dst = t;
+        }
+    }
+
+    for (int i = 0; i < nviews; i++) {
+        SortView *v = &views[i];
+        if (v->nblocks && v->src != v->a) {
+            size_t elem = v->view == VIEW_TOP ? sizeof(PointXY) :
+                          v->view == VIEW_FRONT ? sizeof(PointXZ) : sizeof(PointYZ);
+            memcpy(v->a, v->src, v->n * elem);
+        }
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+static int sort_one(int view, void *a, size_t n) {
+    SortView v;
+    if (!view_init(&v, view, a, n, 1)) return 0;
+    int ok = sort_views(NULL, &v, 1);
+    view_free(&v);
+    return ok;
+}
+
+int sort_xy(PointXY *a, size_t n) { return sort_one(VIEW_TOP, a, n); }
+int sort_xz(PointXZ *a, size_t n) { return sort_one(VIEW_FRONT, a, n); }
+int sort_yz(PointYZ *a, size_t n) { return sort_one(VIEW_PROFILE, a, n); }
+
+int sort_projections(WorkerPool *pool,
+                     PointXY *xy, size_t nxy,
+                     PointXZ *xz, size_t nxz,
+                     PointYZ *yz, size_t nyz) {
+    int nthreads = pool ? pool->nthreads : 1;
+    SortView views[3];
+    int ok = view_init(&views[0], VIEW_TOP, xy, nxy, nthreads);
+    ok = view_init(&views[1], VIEW_FRONT, xz, nxz, nthreads) && ok;
+    ok = view_init(&views[2], VIEW_PROFILE, yz, nyz, nthreads) && ok;
+
+    if (ok) ok = sort_views(pool, views, 3);
+
+    for (int i = 0; i < 3; i++) view_free(&views[i]);
+    return ok;
+}
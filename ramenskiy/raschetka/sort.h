@@ -0,0 +1,28 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include "geom.h"
+#include "pool.h"
+
+/* Сортировка точек проекций по квантованным ключам (номерам ячеек
+   сетки EPS): сначала по первой координате, затем по второй.
+   Порядок — строгий и транзитивный, точки с одинаковыми ключами
+   сохраняют исходный порядок (сортировка устойчивая).
+   Поразрядная LSD-сортировка, O(n) на проход, проходы по байтам
+   с одинаковым значением у всех ключей пропускаются.
+   Возвращают 1 при успехе, 0 — нет памяти под буфер */
+int sort_xy(PointXY *a, size_t n);
+int sort_xz(PointXZ *a, size_t n);
+int sort_yz(PointYZ *a, size_t n);
+
+/* Параллельная сортировка всех трёх проекций на общем пуле:
+   каждый массив режется на блоки, на каждом проходе блоки всех массивов
+   строят гистограммы и раскладываются параллельно. Результат тот же,
+   что у sort_xy/sort_xz/sort_yz, при любом числе потоков */
+int sort_projections(WorkerPool *pool,
+                     PointXY *xy, size_t nxy,
+                     PointXZ *xz, size_t nxz,
+                     PointYZ *yz, size_t nyz);
+
+#endif
@@ -0,0 +1,97 @@
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "timing.h"
+
+static const char *stage_names[STAGE_COUNT] = {
+    "read", "sort", "join", "dedup", "wires"
+};
+
+double timing_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+long timing_peak_rss_kb(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+    return ru.ru_maxrss;   // в Linux — килобайты
+}
+
+void timing_start(StageTimes *t) {
+    memset(t, 0, sizeof(*t));
+    t->run_started = timing_now();
+}
+
+void timing_begin(StageTimes *t, int stage) {
+    t->stage_started[stage] = timing_now();
+}
+
+void timing_end(StageTimes *t, int stage) {
+    t->sec[stage] += timing_now() - t->stage_started[stage];
+}
+
+void timing_finish(StageTimes *t) {
+    t->total = timing_now() - t->run_started;
+    t->peak_rss_kb = timing_peak_rss_kb();
+}
+
+void timing_print_text(FILE *f, const StageTimes *t) {
+    // "3D points" эталона — всё от отсортированных видов до вершин
+    double points = t->sec[STAGE_SORT] + t->sec[STAGE_JOIN] + t->sec[STAGE_DEDUP];
+    fprintf(f, "Algorithm (sec)\n%.3f\n", t->total);
+    fprintf(f, "Read plot (sec)\n%.3f\n", t->sec[STAGE_READ]);
+    fprintf(f, "3D points (sec)\n%.3f\n", points);
+    fprintf(f, "Get wires (sec)\n%.3f\n", t->sec[STAGE_WIRES]);
+
+    fprintf(f, "Этапы (сек):");
+    for (int i = 0; i < STAGE_COUNT; i++)
+        fprintf(f, " %s %.6f%s", stage_names[i], t->sec[i], i + 1 < STAGE_COUNT ? "," : "\n");
+    fprintf(f, "Пиковая память: %ld КБ\n", t->peak_rss_kb);
+}
+
+static void write_json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; s && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20) fprintf(f, "\\u%04x", c);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+void timing_write_json(FILE *f, const StageTimes *t, const RunStats *s) {
+    fprintf(f, "{\"input\": ");
+    write_json_string(f, s->input);
+    fprintf(f, ", \"threads\": %d, \"xy\": %zu, \"xz\": %zu, \"yz\": %zu",
+            s->threads, s->nxy, s->nxz, s->nyz);
+    fprintf(f, ", \"found\": %zu, \"points\": %zu, \"edges\": %zu",
+            s->found, s->points, s->edges);
+    for (int i = 0; i < STAGE_COUNT; i++)
+        fprintf(f, ", \"%s_sec\": %.6f", stage_names[i], t->sec[i]);
+    fprintf(f, ", \"total_sec\": %.6f, \"peak_rss_kb\": %ld}\n",
+            t->total, t->peak_rss_kb);
+}
+
+void timing_write_csv(FILE *f, const StageTimes *t, const RunStats *s) {
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0) {
+        fprintf(f, "input,threads,xy,xz,yz,found,points,edges");
+        for (int i = 0; i < STAGE_COUNT; i++) fprintf(f, ",%s_sec", stage_names[i]);
+        fprintf(f, ",total_sec,peak_rss_kb\n");
+    }
+
+    // Имя файла в кавычках, кавычки внутри удваиваются
+    fputc('"', f);
+    for (const char *c = s->input; c && *c; c++) {
+        if (*c == '"') fputc('"', f);
+        fputc(*c, f);
+    }
+    fputc('"', f);
+    fprintf(f, ",%d,%zu,%zu,%zu,%zu,%zu,%zu",
+            s->threads, s->nxy, s->nxz, s->nyz, s->found, s->points, s->edges);
+    for (int i = 0; i < STAGE_COUNT; i++) fprintf(f, ",%.6f", t->sec[i]);
+    fprintf(f, ",%.6f,%ld\n", t->total, t->peak_rss_kb);
+}
@@ -0,0 +1,57 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Этапы восстановления */
+enum {
+    STAGE_READ,
+    STAGE_SORT,
+    STAGE_JOIN,
+    STAGE_DEDUP,
+    STAGE_WIRES,
+    STAGE_COUNT
+};
+
+/* Время этапов одного запуска */
+typedef struct {
+    double sec[STAGE_COUNT];
+    double stage_started[STAGE_COUNT];
+    double run_started;
+    double total;
+    long peak_rss_kb;
+} StageTimes;
+
+/* Размеры данных запуска для отчёта */
+typedef struct {
+    const char *input;
+    int threads;
+    size_t nxy, nxz, nyz;
+    size_t found;
+    size_t points;
+    size_t edges;
+} RunStats;
+
+/* Монотонное время в секундах */
+double timing_now(void);
+
+/* Пиковый объём резидентной памяти процесса, КБ */
+long timing_peak_rss_kb(void);
+
+void timing_start(StageTimes *t);
+void timing_begin(StageTimes *t, int stage);
+void timing_end(StageTimes *t, int stage);
+/* Завершение запуска: общее время и пик памяти */
+void timing_finish(StageTimes *t);
+
+/* Текст: поля "(sec)" как в эталонных чертежах и разбивка по этапам */
+void timing_print_text(FILE *f, const StageTimes *t);
+
+/* Одна JSON-строка на запуск */
+void timing_write_json(FILE *f, const StageTimes *t, const RunStats *s);
+
+/* CSV: заголовок пишется, если файл пуст */
+void timing_write_csv(FILE *f, const StageTimes *t, const RunStats *s);
+
+#endif
@@ -1,429 +1,396 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <math.h>
-#include <pthread.h>
+#include <sys/stat.h>
 
-#define EPS 0.001
-// #define EPS 0.000000
-#define LINE_BUF 256
-
-/* Структуры точек для каждой проекции */
-typedef struct {
-    double x, y;  // для XY (topView)
-} PointXY;
-
-typedef struct {
-    double x, z;  // для XZ (frontView)
-} PointXZ;
-
-typedef struct {
-    double y, z;  // для YZ (profileView)
-} PointYZ;
-
-typedef struct {
-    double x, y, z;
-} PointXYZ;
-
-/* Аргументы для потока сортировки */
-typedef struct {
-    void *base;
-    size_t nmemb;
-    size_t size;
-    int (*compar)(const void*, const void*);
-    const char *name;
-} SortThreadArg;
+#include "arena.h"
+#include "batch.h"
+#include "cache.h"
+#include "geom.h"
+#include "incr.h"
+#include "ooc.h"
+#include "parse.h"
+#include "pipeline.h"
+#include "pointset.h"
+#include "simd.h"
+#include "timing.h"
+#include "pool.h"
+#include "recon.h"
+#include "wires.h"
+#include "writer.h"
+#include "../common/log.h"
 
 /* ----------------------------------------- */
-/* Функции сравнения для сортировки */
-int cmp_xy(const void *a, const void *b) {
-    const PointXY *pa = (const PointXY*)a;
-    const PointXY *pb = (const PointXY*)b;
-    if (fabs(pa->x - pb->x) <= EPS) {
-        if (fabs(pa->y - pb->y) <= EPS) return 0;
-        return (pa->y < pb->y) ? -1 : 1;
+/* Отчёт о времени в файл, если он задан */
+static void append_report(const char *file, int csv, const StageTimes *t, const RunStats *s) {
+    if (!file) return;
+    FILE *f = fopen(file, "a");
+    if (!f) {
+        log_error("%s: %s\n", file, strerror(errno));
+        return;
     }
-    return (pa->x < pb->x) ? -1 : 1;
+    if (csv) timing_write_csv(f, t, s);
+    else timing_write_json(f, t, s);
+    fclose(f);
 }
 
-int cmp_xz(const void *a, const void *b) {
-    const PointXZ *pa = (const PointXZ*)a;
-    const PointXZ *pb = (const PointXZ*)b;
-    if (fabs(pa->x - pb->x) <= EPS) {
-        if (fabs(pa->z - pb->z) <= EPS) return 0;
-        return (pa->z < pb->z) ? -1 : 1;
+/* Режим внешней памяти (-m): виды сортируются прогонами на диске,
+   соединение — слияниями в пределах бюджета; строятся только вершины */
+static int run_out_of_core(const char *input_file, size_t budget_mb,
+                           const char *out_file, OutFormat out_format,
+                           const char *json_file, const char *csv_file) {
+    printf("Внешняя память: бюджет %zu МБ\n", budget_mb);
+    printf("Чтение файла %s...\n", input_file);
+    StageTimes times;
+    timing_start(&times);
+    OocResult r;
+    if (!ooc_reconstruct(input_file, budget_mb << 20, &r, &times)) {
+        if (r.data_error)
+            log_error("Ошибка чтения файла или недостаточно данных: "
+                      "topView %zu, frontView %zu, profileView %zu\n",
+                      r.nxy_raw, r.nxz_raw, r.nyz_raw);
+        else
+            log_error("Ошибка: недостаточно памяти или места для временных файлов\n");
+        return 1;
     }
-    return (pa->x < pb->x) ? -1 : 1;
-}
+    timing_finish(&times);
 
-int cmp_yz(const void *a, const void *b) {
-    const PointYZ *pa = (const PointYZ*)a;
-    const PointYZ *pb = (const PointYZ*)b;
-    if (fabs(pa->y - pb->y) <= EPS) {
-        if (fabs(pa->z - pb->z) <= EPS) return 0;
-        return (pa->z < pb->z) ? -1 : 1;
-    }
-    return (pa->y < pb->y) ? -1 : 1;
-}
+    printf("\nИтоги чтения:\n");
+    if (geom_step > 0.0 && r.near_boundary)
+        printf("  Предупреждение: %zu координат у середины между узлами — "
+               "их узел зависит от округления в записи числа\n", r.near_boundary);
+    printf("  topView (X,Y): %zu точек\n", r.nxy_raw);
+    printf("  frontView (X,Z): %zu точек\n", r.nxz_raw);
+    printf("  profileView (Y,Z): %zu точек\n", r.nyz_raw);
+    printf("Различных точек: XY %zu, XZ %zu, YZ %zu\n", r.nxy, r.nxz, r.nyz);
 
-/* ----------------------------------------- */
-/* Реализация быстрой сортировки */
-static void swap(void *a, void *b, size_t size) {
-    char *pa = (char*)a;
-    char *pb = (char*)b;
-    char tmp;
-    for (size_t i = 0; i < size; i++) {
-        tmp = pa[i];
-        pa[i] = pb[i];
-        pb[i] = tmp;
+    Writer w;
+    ResultData rd = {r.verts.pts, r.verts.n, NULL, 0,
+                     (const double (*)[2])r.lcs, &times};
+    int written = 0;
+    if (writer_open(&w, out_file)) {
+        written = write_result(&w, out_format, &rd);
+        written = writer_close(&w) && written;
     }
-}
+    if (!written)
+        log_error("Ошибка записи результата%s%s\n",
+                  out_file ? " в " : "", out_file ? out_file : "");
+    else if (out_file)
+        printf("Результат записан в %s\n", out_file);
 
-static void quicksort_impl(void *base, size_t lo, size_t hi, size_t size,
-                           int (*compar)(const void*, const void*)) {
-    if (lo >= hi) return;
-    
-    char *arr = (char*)base;
-    
-    // Медиана из трёх для лучшей производительности
-    size_t mid = lo + (hi - lo) / 2;
-    if (compar(arr + lo*size, arr + mid*size) > 0)
-        swap(arr + lo*size, arr + mid*size, size);
-    if (compar(arr + lo*size, arr + hi*size) > 0)
-        swap(arr + lo*size, arr + hi*size, size);
-    if (compar(arr + mid*size, arr + hi*size) > 0)
-        swap(arr + mid*size, arr + hi*size, size);
-    
-    // Ставим медиану в конец как опорный элемент
-    swap(arr + mid*size, arr + hi*size, size);
-    
-    size_t pivot = hi;
-    size_t i = lo;
-    
-    for (size_t j = lo; j < hi; j++) {
-        if (compar(arr + j*size, arr + pivot*size) <= 0) {
-            swap(arr + i*size, arr + j*size, size);
-            i++;
-        }
-    }
-    swap(arr + i*size, arr + pivot*size, size);
-    
-    if (i > lo) quicksort_impl(base, lo, i-1, size, compar);
-    if (i < hi) quicksort_impl(base, i+1, hi, size, compar);
-}
+    printf("\n========================================================\n");
+    printf("РЕЗУЛЬТАТЫ:\n");
+    printf("  Всего совпадений: %zu\n", r.found);
+    printf("  Уникальных 3D точек: %zu\n", r.verts.n);
+    printf("  3D рёбер: не строятся во внешней памяти\n");
+    printf("  Точность сравнения: EPS = %g%s\n", EPS,
+           geom_step > 0.0 ? " (совпадение узлов сетки)" : "");
+    printf("  Временные файлы: записано %.1f МБ, прочитано %.1f МБ "
+           "(прогонов %zu, проходов слияния %zu)\n",
+           r.spilled / 1048576.0, r.read_back / 1048576.0, r.runs, r.passes);
+    printf("========================================================\n");
+    timing_print_text(stdout, &times);
 
-void quicksort(void *base, size_t nmemb, size_t size,
-               int (*compar)(const void*, const void*)) {
-    if (nmemb <= 1) return;
-    quicksort_impl(base, 0, nmemb-1, size, compar);
-}
+    RunStats stats = {input_file, 1, r.nxy_raw, r.nxz_raw, r.nyz_raw,
+                      r.found, r.verts.n, 0};
+    append_report(json_file, 0, &times, &stats);
+    append_report(csv_file, 1, &times, &stats);
 
-/* Потоковая функция для сортировки */
-void* sort_thread(void *arg) {
-    SortThreadArg *ta = (SortThreadArg*)arg;
-    printf("[%s] Начало сортировки %zu элементов...\n", ta->name, ta->nmemb);
-    quicksort(ta->base, ta->nmemb, ta->size, ta->compar);
-    printf("[%s] Сортировка завершена\n", ta->name);
-    return NULL;
+    ooc_result_free(&r);
+    return written ? 0 : 1;
 }
 
-/* ----------------------------------------- */
-/* Функция чтения данных из файла */
-int read_projections(const char *filename, 
-                     PointXY **xy_out, size_t *nxy_out,
-                     PointXZ **xz_out, size_t *nxz_out,
-                     PointYZ **yz_out, size_t *nyz_out) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror("fopen");
-        return 0;
+/* Инкрементальный режим (-i): восстанавливается только то, что задела
+   правка с прошлого запуска; выводятся добавленные и удалённые вершины */
+static int run_incremental(const char *input_file, const char *state_file, int nthreads,
+                           const char *out_file, const char *json_file, const char *csv_file) {
+    StageTimes times;
+    timing_start(&times);
+    WorkerPool pool;
+    if (!pool_init(&pool, nthreads)) {
+        log_error("Ошибка создания пула потоков\n");
+        return 1;
     }
-    
-    int xy_cap = 1024;
-    int xz_cap = 1024;
-    int yz_cap = 1024;
-    
-    PointXY *xy = (PointXY *)malloc((size_t)xy_cap * sizeof(PointXY));
-    PointXZ *xz = (PointXZ *)malloc((size_t)xz_cap * sizeof(PointXZ));
-    PointYZ *yz = (PointYZ *)malloc((size_t)yz_cap * sizeof(PointYZ));
-    
-    if (!xy || !xz || !yz) {
-        fclose(fp);
-        free(xy); free(xz); free(yz);
-        return 0;
+    printf("Потоков: %d\n", pool.nthreads);
+    struct stat st;
+    size_t estimate = stat(input_file, &st) == 0 ? (size_t)st.st_size * RECON_ARENA_PER_BYTE : 0;
+    Arena arena;
+    if (!arena_init(&arena, estimate)) {
+        log_error("Ошибка: недостаточно памяти для арены\n");
+        pool_destroy(&pool);
+        return 1;
     }
-    
-    int nxy = 0, nxz = 0, nyz = 0;
-    
-    char line[LINE_BUF];
-    int block = 0;          // 1-frontView, 2-profileView, 3-topView
-    int waiting_second = 0;
-    double saved = 0.0;
-    
-    printf("Чтение файла %s...\n", filename);
-    
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\n")] = '\0';
-        
-        if (line[0] == '\0') continue;
-        
-        if (strstr(line, "frontView")) {
-            block = 1;
-            waiting_second = 0;
-            printf("Найдена секция frontView (X,Z)\n");
-            continue;
-        }
-        if (strstr(line, "profileView")) {
-            block = 2;
-            waiting_second = 0;
-            printf("Найдена секция profileView (Y,Z)\n");
-            continue;
-        }
-        if (strstr(line, "topView")) {
-            block = 3;
-            waiting_second = 0;
-            printf("Найдена секция topView (X,Y)\n");
-            continue;
-        }
-        
-        if (strstr(line, "3D points")) {
-            break;
-        }
-        
-        if (strstr(line, "lcsX") || strstr(line, "lcsY") ||
-            strstr(line, "3D edges") || strstr(line, "Algorithm") ||
-            strstr(line, "Read plot") || strstr(line, "Get wires")) {
-            continue;
-        }
-        
-        char *comma = strchr(line, ',');
-        if (comma) {
-            *comma = '.';
-        }
-        
-        double value;
-        if (sscanf(line, "%lf", &value) != 1) {
-            continue;
-        }
-        
-        if (!waiting_second) {
-            saved = value;
-            waiting_second = 1;
-            continue;
-        }
-        
-        if (block == 1) {
-            if (nxz >= xz_cap) {
-                xz_cap *= 2;
-                PointXZ *resized = (PointXZ *)realloc(xz, (size_t)xz_cap * sizeof(PointXZ));
-                if (!resized) {
-                    fclose(fp);
-                    free(xy); free(xz); free(yz);
-                    return 0;
-                }
-                xz = resized;
-            }
-            xz[nxz].x = saved;
-            xz[nxz].z = value;
-            nxz++;
-        } 
-        else if (block == 2) {
-            if (nyz >= yz_cap) {
-                yz_cap *= 2;
-                PointYZ *resized = (PointYZ *)realloc(yz, (size_t)yz_cap * sizeof(PointYZ));
-                if (!resized) {
-                    fclose(fp);
-                    free(xy); free(xz); free(yz);
-                    return 0;
-                }
-                yz = resized;
-            }
-            yz[nyz].y = saved;
-            yz[nyz].z = value;
-            nyz++;
-        } 
-        else if (block == 3) {
-            if (nxy >= xy_cap) {
-                xy_cap *= 2;
-                PointXY *resized = (PointXY *)realloc(xy, (size_t)xy_cap * sizeof(PointXY));
-                if (!resized) {
-                    fclose(fp);
-                    free(xy); free(xz); free(yz);
-                    return 0;
-                }
-                xy = resized;
-            }
-            xy[nxy].x = saved;
-            xy[nxy].y = value;
-            nxy++;
-        }
-        
-        waiting_second = 0;
+
+    printf("Чтение файла %s (состояние %s)...\n", input_file, state_file);
+    IncrResult r;
+    int ran = incr_run(&pool, &arena, input_file, state_file, &r, &times);
+    pool_destroy(&pool);
+    arena_free(&arena);
+    if (!ran) {
+        log_error("Ошибка чтения файла или недостаточно памяти\n");
+        return 1;
     }
-    
-    fclose(fp);
-    
+    if (r.nxy_raw == 0 || r.nxz_raw == 0 || r.nyz_raw == 0) {
+        log_error("Ошибка: недостаточно данных в файле\n");
+        log_error("topView: %zu, frontView: %zu, profileView: %zu\n",
+                  r.nxy_raw, r.nxz_raw, r.nyz_raw);
+        return 1;
+    }
+    timing_finish(&times);
+
     printf("\nИтоги чтения:\n");
-    printf("  topView (X,Y): %d точек\n", nxy);
-    printf("  frontView (X,Z): %d точек\n", nxz);
-    printf("  profileView (Y,Z): %d точек\n", nyz);
-    
-    *xy_out = xy;
-    *nxy_out = nxy;
-    *xz_out = xz;
-    *nxz_out = nxz;
-    *yz_out = yz;
-    *nyz_out = nyz;
-    
-    return 1;
-}
+    printf("  topView (X,Y): %zu точек\n", r.nxy_raw);
+    printf("  frontView (X,Z): %zu точек\n", r.nxz_raw);
+    printf("  profileView (Y,Z): %zu точек\n", r.nyz_raw);
+    if (r.full) {
+        printf("Состояния нет или оно от другой точности — полное восстановление\n");
+    } else {
+        printf("Правка: XY +%zu/-%zu, XZ +%zu/-%zu, YZ +%zu/-%zu различных точек\n",
+               r.added[VIEW_TOP], r.removed[VIEW_TOP], r.added[VIEW_FRONT],
+               r.removed[VIEW_FRONT], r.added[VIEW_PROFILE], r.removed[VIEW_PROFILE]);
+        printf("Соединено заново: %zu из %zu значений XY\n", r.rejoined, r.nxy);
+    }
+    if (!r.saved)
+        log_warn("Предупреждение: не удалось записать состояние %s\n", state_file);
 
-/* ----------------------------------------- */
-/* Проверка двух чисел на равенство с EPS */
-static inline int approx_eq(double a, double b) {
-    return fabs(a - b) <= EPS;
+    Writer w;
+    int written = 0;
+    if (writer_open(&w, out_file)) {
+        written = write_delta(&w, r.vadd, r.nvadd, r.vdel, r.nvdel);
+        written = writer_close(&w) && written;
+    }
+    if (!written)
+        log_error("Ошибка записи результата%s%s\n",
+                  out_file ? " в " : "", out_file ? out_file : "");
+    else if (out_file)
+        printf("Изменение записано в %s\n", out_file);
+
+    printf("\n========================================================\n");
+    printf("РЕЗУЛЬТАТЫ:\n");
+    printf("  Кандидатов: +%zu, -%zu\n", r.cand_added, r.cand_removed);
+    printf("  3D точек: +%zu, -%zu, всего %zu\n", r.nvadd, r.nvdel, r.vertices);
+    printf("  3D рёбер: не строятся в инкрементальном режиме\n");
+    printf("  Точность сравнения: EPS = %g%s\n", EPS,
+           geom_step > 0.0 ? " (совпадение узлов сетки)" : "");
+    printf("========================================================\n");
+    timing_print_text(stdout, &times);
+
+    RunStats stats = {input_file, nthreads, r.nxy_raw, r.nxz_raw, r.nyz_raw,
+                      r.cand_added, r.vertices, 0};
+    append_report(json_file, 0, &times, &stats);
+    append_report(csv_file, 1, &times, &stats);
+
+    incr_result_free(&r);
+    return written ? 0 : 1;
 }
 
 /* ----------------------------------------- */
 int main(int argc, char *argv[]) {
     const char *input_file = "polyhedral 2D.txt";
-    
-    if (argc >= 2) {
-        input_file = argv[1];
-    } else {
-        printf("Использование: %s <input_file>\n", argv[0]);
-        printf("Используется файл по умолчанию: %s\n", input_file);
+    const char *json_file = NULL;
+    const char *csv_file = NULL;
+    int nthreads = pool_default_threads();
+    int have_input = 0;
+    int use_cache = 0;
+    const char *batch_source = NULL;
+    const char *out_file = NULL;
+    const char *format_name = NULL;
+    double eps = EPS_DEFAULT;
+    int quantize = 0;
+    long budget_mb = 0;
+    int pipelined = 0;
+    const char *state_file = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+            if (nthreads < 1) nthreads = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            eps = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quantize") == 0) {
+            quantize = 1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            budget_mb = atol(argv[++i]);
+            if (budget_mb < 1) budget_mb = 1;
+        } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--pipeline") == 0) {
+            pipelined = 1;
+        } else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--incremental") == 0) &&
+                   i + 1 < argc) {
+            state_file = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cache") == 0) {
+            use_cache = 1;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_source = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            format_name = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_file = argv[++i];
+        } else {
+            input_file = argv[i];
+            have_input = 1;
+        }
     }
     
-    // Чтение данных
-    PointXY *xy = NULL;
-    PointXZ *xz = NULL;
-    PointYZ *yz = NULL;
-    size_t nxy, nxz, nyz;
-    
-    if (!read_projections(input_file, &xy, &nxy, &xz, &nxz, &yz, &nyz)) {
-        fprintf(stderr, "Ошибка чтения файла\n");
+    // Точность задаётся до чтения: в режиме квантования координаты
+    // заменяются узлами сетки прямо при разборе
+    if (!(quantize ? geom_set_quantized(eps) : geom_set_eps(eps))) {
+        log_error("Неверная точность EPS: %g\n", eps);
         return 1;
     }
     
-    if (nxy == 0 || nxz == 0 || nyz == 0) {
-        fprintf(stderr, "Ошибка: недостаточно данных в файле\n");
-        fprintf(stderr, "topView: %zu, frontView: %zu, profileView: %zu\n", nxy, nxz, nyz);
-        free(xy); free(xz); free(yz);
+    // Формат результата: по умолчанию список на экран, в файл — как "X 3D.txt"
+    OutFormat out_format = out_file ? OUT_POINTS : OUT_LIST;
+    if (format_name && !out_format_parse(format_name, &out_format)) {
+        log_error("Неизвестный формат: %s (list, points, ply, obj, bin)\n", format_name);
         return 1;
     }
     
-    printf("\nЗагружено: %zu точек XY, %zu точек XZ, %zu точек YZ\n", nxy, nxz, nyz);
-    
-    // Подготовка аргументов для потоков
-    SortThreadArg arg_xy = {xy, nxy, sizeof(PointXY), cmp_xy, "XY"};
-    SortThreadArg arg_xz = {xz, nxz, sizeof(PointXZ), cmp_xz, "XZ"};
-    SortThreadArg arg_yz = {yz, nyz, sizeof(PointYZ), cmp_yz, "YZ"};
+    // Пакетный режим: каталог или файл-список, один процесс и общий пул
+    if (batch_source) {
+        if (format_name || budget_mb || pipelined || state_file) {
+            log_error("Формат -f, внешняя память -m, конвейер -p и состояние -i "
+                      "задаются только для одного чертежа\n");
+            return 1;
+        }
+        BatchOptions opt = {batch_source, nthreads, use_cache, out_file, json_file, csv_file};
+        return batch_run(&opt);
+    }
     
-    pthread_t thread_xy, thread_xz, thread_yz;
+    if (!have_input) {
+        printf("Использование: %s [-t потоки] [-e eps] [-q] [-c] [-m МБ] [-p] [-i состояние] [-o файл] [-f формат] [--json файл] [--csv файл] <input_file>\n", argv[0]);
+        printf("          или: %s --batch <каталог | файл-список> [-o результаты] [-t потоки] [-c] ...\n", argv[0]);
+        printf("Используется файл по умолчанию: %s\n", input_file);
+    }
     
-    printf("\n=== Запуск параллельной сортировки ===\n");
+    if (state_file) {
+        if (use_cache || budget_mb || pipelined || format_name) {
+            log_error("Состояние -i не используется вместе с -c, -m, -p и -f\n");
+            return 1;
+        }
+        return run_incremental(input_file, state_file, nthreads, out_file, json_file, csv_file);
+    }
+    if (pipelined && (use_cache || budget_mb)) {
+        log_error("Конвейер -p не используется вместе с кэшем -c и внешней памятью -m\n");
+        return 1;
+    }
+    if (budget_mb) {
+        if (use_cache) {
+            log_error("Кэш -c не используется вместе с внешней памятью -m\n");
+            return 1;
+        }
+        return run_out_of_core(input_file, (size_t)budget_mb, out_file, out_format,
+                               json_file, csv_file);
+    }
     
-    // Создание потоков для сортировки каждого массива
-    if (pthread_create(&thread_xy, NULL, sort_thread, &arg_xy) != 0) {
-        perror("pthread_create xy");
-        free(xy); free(xz); free(yz);
+    WorkerPool pool;
+    if (!pool_init(&pool, nthreads)) {
+        log_error("Ошибка создания пула потоков\n");
         return 1;
     }
-    if (pthread_create(&thread_xz, NULL, sort_thread, &arg_xz) != 0) {
-        perror("pthread_create xz");
-        pthread_cancel(thread_xy);
-        free(xy); free(xz); free(yz);
+    printf("Потоков: %d\n", pool.nthreads);
+    Reconstruction r;
+    if (!recon_init(&r)) {
+        log_error("Ошибка: недостаточно памяти\n");
+        pool_destroy(&pool);
         return 1;
     }
-    if (pthread_create(&thread_yz, NULL, sort_thread, &arg_yz) != 0) {
-        perror("pthread_create yz");
-        pthread_cancel(thread_xy);
-        pthread_cancel(thread_xz);
-        free(xy); free(xz); free(yz);
+
+    // Чтение (файл отображается в память, секции видов разбираются
+    // параллельно), сортировка, соединение, отбор вершин и рёбра — recon.h.
+    // Конвейер: XZ и YZ сортируются и индексируются, пока читается
+    // topView, точки XY соединяются по мере чтения
+    printf("Чтение файла %s...\n", input_file);
+    if (pipelined) printf("Конвейер: чтение, сортировка и соединение одновременно\n");
+    PipelineStats pst;
+    int ok = pipelined ? recon_run_pipelined(&r, &pool, input_file, &pst)
+                       : recon_run(&r, &pool, input_file, use_cache);
+    pool_destroy(&pool);
+    if (!ok && !r.empty_view) {
+        log_error("Ошибка чтения файла или недостаточно памяти\n");
+        recon_free(&r);
         return 1;
     }
-    
-    // Ожидание завершения всех потоков
-    pthread_join(thread_xy, NULL);
-    pthread_join(thread_xz, NULL);
-    pthread_join(thread_yz, NULL);
-    
-    printf("\n=== Сортировка завершена ===\n");
-    
-    // Вывод первых 5 отсортированных точек для проверки
-    printf("\nПервые 5 отсортированных точек:\n");
-    printf("XY (x,y): ");
-    for (size_t i = 0; i < (nxy < 5 ? nxy : 5); i++) {
-        printf("(%.3f,%.3f) ", xy[i].x, xy[i].y);
+    if (r.from_cache) {
+        char cache_file[4096];
+        cache_path(input_file, cache_file, sizeof(cache_file));
+        printf("Проекции загружены из кэша %s\n", cache_file);
     }
-    printf("\nXZ (x,z): ");
-    for (size_t i = 0; i < (nxz < 5 ? nxz : 5); i++) {
-        printf("(%.3f,%.3f) ", xz[i].x, xz[i].z);
+
+    printf("\nИтоги чтения:\n");
+    if (geom_step > 0.0) {
+        printf("  Координаты приведены к узлам сетки с шагом %g\n", geom_step);
+        if (r.near_boundary)
+            printf("  Предупреждение: %zu координат у середины между узлами — "
+                   "их узел зависит от округления в записи числа\n", r.near_boundary);
     }
-    printf("\nYZ (y,z): ");
-    for (size_t i = 0; i < (nyz < 5 ? nyz : 5); i++) {
-        printf("(%.3f,%.3f) ", yz[i].y, yz[i].z);
+    printf("  topView (X,Y): %zu точек\n", r.nxy);
+    printf("  frontView (X,Z): %zu точек\n", r.nxz);
+    printf("  profileView (Y,Z): %zu точек\n", r.nyz);
+    
+    if (r.empty_view) {
+        log_error("Ошибка: недостаточно данных в файле\n");
+        log_error("topView: %zu, frontView: %zu, profileView: %zu\n", r.nxy, r.nxz, r.nyz);
+        recon_free(&r);
+        return 1;
+    }
+    
+    printf("\nЗагружено: %zu точек XY, %zu точек XZ, %zu точек YZ\n", r.nxy, r.nxz, r.nyz);
+    printf("Различных точек: XY %zu, XZ %zu, YZ %zu\n",
+           r.distinct[VIEW_TOP], r.distinct[VIEW_FRONT], r.distinct[VIEW_PROFILE]);
+    if (pipelined && pst.fallback) {
+        printf("Конвейер: секция XZ или YZ после topView — восстановление обычным порядком\n");
+    } else if (pipelined) {
+        printf("Конвейер: индексы XZ/YZ готовы через %.3f с, кусков XY %zu, "
+               "соединено при чтении %zu значений XY\n",
+               pst.index_ready, pst.chunks, pst.joined);
+        printf("Конвейер: чтение ждало очередь %.3f с, соединение ждало куски %.3f с\n",
+               pst.parse_stall, pst.join_idle);
     }
-    printf("\n");
     
-    // Поиск уникальных 3D точек
     printf("\n========================================================\n");
-    printf("ПОИСК 3D ТОЧЕК (x, y, z) с точностью EPS = %.3f\n", EPS);
+    printf("3D ТОЧКИ И РЁБРА (x, y, z) с точностью EPS = %g\n", EPS);
+    printf("Отбор по EPS: %s\n", simd_level_name());
     printf("========================================================\n");
     
-    PointXYZ *unique_points = NULL;
-    int unique_count = 0;
-    int found_count = 0;
-    
-    for (size_t i = 0; i < nxy; i++) {
-        double x = xy[i].x;
-        double y = xy[i].y;
-        
-        for (size_t j = 0; j < nxz; j++) {
-            if (approx_eq(xz[j].x, x)) {
-                double z = xz[j].z;
-                
-                for (size_t k = 0; k < nyz; k++) {
-                    if (approx_eq(yz[k].y, y) && approx_eq(yz[k].z, z)) {
-                        found_count++;
-                        
-                        // Проверка на уникальность
-                        int exists = 0;
-                        for (int t = 0; t < unique_count; t++) {
-                            if (approx_eq(unique_points[t].x, x) &&
-                                approx_eq(unique_points[t].y, y) &&
-                                approx_eq(unique_points[t].z, z)) {
-                                exists = 1;
-                                break;
-                            }
-                        }
-                        
-                        if (!exists) {
-                            unique_count++;
-                            unique_points = realloc(unique_points, unique_count * sizeof(PointXYZ));
-                            unique_points[unique_count-1] = (PointXYZ){x, y, z};
-                            printf("Точка %d: (%.6f, %.6f, %.6f)\n", unique_count, x, y, z);
-                        }
-                        break;
-                    }
-                }
-            }
-        }
+    // Точки и рёбра — одним буферизованным проходом после замера времени
+    Writer w;
+    ResultData rd = {r.verts.pts, r.verts.n, r.edges, r.nedges,
+                     (const double (*)[2])r.lcs, &r.times};
+    int written = 0;
+    if (writer_open(&w, out_file)) {
+        written = write_result(&w, out_format, &rd);
+        written = writer_close(&w) && written;
     }
+    if (!written)
+        log_error("Ошибка записи результата%s%s\n",
+                  out_file ? " в " : "", out_file ? out_file : "");
+    else if (out_file)
+        printf("Результат записан в %s\n", out_file);
     
     printf("\n========================================================\n");
     printf("РЕЗУЛЬТАТЫ:\n");
-    printf("  Всего совпадений: %d\n", found_count);
-    printf("  Уникальных 3D точек: %d\n", unique_count);
-    printf("  Точность сравнения: EPS = %.3f\n", EPS);
+    printf("  Всего совпадений: %zu\n", r.found);
+    printf("  Уникальных 3D точек: %zu\n", r.verts.n);
+    printf("  3D рёбер: %zu\n", r.nedges);
+    printf("  Точность сравнения: EPS = %g%s\n", EPS,
+           geom_step > 0.0 ? " (совпадение узлов сетки)" : "");
+    printf("  Арена: %.1f МБ (оценка %.1f МБ)\n",
+           r.arena.peak / 1048576.0, r.estimate / 1048576.0);
     printf("========================================================\n");
+    timing_print_text(stdout, &r.times);
     
-    // Освобождение памяти
-    free(xy);
-    free(xz);
-    free(yz);
-    free(unique_points);
+    // Машиночитаемый отчёт о времени — для сравнения между версиями
+    RunStats stats = {input_file, nthreads, r.nxy, r.nxz, r.nyz,
+                      r.found, r.verts.n, r.nedges};
+    append_report(json_file, 0, &r.times, &stats);
+    append_report(csv_file, 1, &r.times, &stats);
     
-    return 0;
-}
\ No newline at end of file
+    recon_free(&r);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,1100 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "wires.h"
+
+static inline size_t hash_cell2(long long a, long long b) {
+    uint64_t h = (uint64_t)a * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)b + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+static inline size_t hash_u64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    return (size_t)k;
+}
+
+static inline uint64_t seg_key(size_t a, size_t b) {
+    return a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+}
+
+/* ----------------------------------------- */
+/* Точки вида */
+static size_t cell_slot(const ViewGraph *g, long long ku, long long kv) {
+    size_t slot = hash_cell2(ku, kv) & g->cell_mask;
+    while (g->cells[slot] &&
+           (g->cell_keys[slot][0] != ku || g->cell_keys[slot][1] != kv))
+        slot = (slot + 1) & g->cell_mask;
+    return slot;
+}
+
+long long view_graph_find(const ViewGraph *g, double u, double v) {
+    long long ku = grid_key(u, g->inv_cell);
+    long long kv = grid_key(v, g->inv_cell);
+    long long r = grid_reach();
+    long long best = -1;
+
+    // При цепочках точек ближе EPS друг к другу берётся меньший номер,
+    // чтобы результат не зависел от порядка обхода ячеек
+    for (long long du = -r; du <= r; du++) {
+        for (long long dv = -r; dv <= r; dv++) {
+            size_t slot = cell_slot(g, ku + du, kv + dv);
+            for (size_t k = g->cells[slot]; k; k = g->next[k - 1]) {
+                const Point2D *p = &g->pts[k - 1];
+                if (approx_eq(p->u, u) && approx_eq(p->v, v) &&
+                    (best < 0 || (long long)(k - 1) < best))
+                    best = (long long)(k - 1);
+            }
+        }
+    }
+    return best;
+}
+
+int view_graph_has_segment(const ViewGraph *g, size_t a, size_t b) {
+    uint64_t key = seg_key(a, b) + 1;
+    size_t slot = hash_u64(key) & g->seg_mask;
+    while (g->segs[slot]) {
+        if (g->segs[slot] == key) return 1;
+        slot = (slot + 1) & g->seg_mask;
+    }
+    return 0;
+}
+
+static void view_graph_free(ViewGraph *g) {
+    Arena *a = g->arena;
+    arena_or_free(a, g->pts);
+    arena_or_free(a, g->next);
+    arena_or_free(a, g->cells);
+    arena_or_free(a, g->cell_keys);
+    arena_or_free(a, g->segs);
+    arena_or_free(a, g->seg_list);
+    arena_or_free(a, g->adj_begin);
+    arena_or_free(a, g->adj);
+    memset(g, 0, sizeof(*g));
+}
+
+static int view_graph_build(ViewGraph *g, Arena *arena, const Point2D *raw, size_t n) {
+    memset(g, 0, sizeof(*g));
+    g->arena = arena;
+    g->inv_cell = grid_inv_cell();
+
+    size_t cap = 16;
+    while (cap < 2 * n) cap *= 2;
+    size_t nseg = n / 2;
+
+    g->pts = (Point2D *)arena_or_malloc(arena, n * sizeof(Point2D));
+    g->next = (size_t *)arena_or_malloc(arena, n * sizeof(size_t));
+    g->cells = (size_t *)arena_or_calloc(arena, cap, sizeof(size_t));
+    g->cell_keys = arena_or_calloc(arena, cap, sizeof(*g->cell_keys));
+    g->segs = (uint64_t *)arena_or_calloc(arena, cap, sizeof(uint64_t));
+    g->adj_begin = (size_t *)arena_or_calloc(arena, n + 1, sizeof(size_t));
+    size_t *ids = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+    g->seg_list = (uint64_t *)arena_or_malloc(arena, nseg * sizeof(uint64_t));
+    if (!g->pts || !g->next || !g->cells || !g->cell_keys || !g->segs ||
+        !g->seg_list || !g->adj_begin || !ids) {
+        free(ids);
+        view_graph_free(g);
+        return 0;
+    }
+    g->cell_mask = cap - 1;
+    g->seg_mask = cap - 1;
+
+    // Слияние совпадающих с точностью EPS точек: первая встреченная
+    // точка становится представителем
+    for (size_t i = 0; i < n; i++) {
+        long long id = view_graph_find(g, raw[i].u, raw[i].v);
+        if (id < 0) {
+            long long ku = grid_key(raw[i].u, g->inv_cell);
+            long long kv = grid_key(raw[i].v, g->inv_cell);
+            size_t slot = cell_slot(g, ku, kv);
+            g->cell_keys[slot][0] = ku;
+            g->cell_keys[slot][1] = kv;
+            g->pts[g->npts] = raw[i];
+            g->next[g->npts] = g->cells[slot];
+            g->cells[slot] = ++g->npts;
+            id = (long long)(g->npts - 1);
+        }
+        ids[i] = (size_t)id;
+    }
+
+    // Отрезки: пары соседних точек, вырожденные и повторные отбрасываются
+    for (size_t k = 0; k < nseg; k++) {
+        size_t a = ids[2 * k], b = ids[2 * k + 1];
+        if (a == b) continue;
+        uint64_t key = seg_key(a, b) + 1;
+        size_t slot = hash_u64(key) & g->seg_mask;
+        while (g->segs[slot] && g->segs[slot] != key)
+            slot = (slot + 1) & g->seg_mask;
+        if (g->segs[slot]) continue;
+        g->segs[slot] = key;
+        g->seg_list[g->nsegs++] = key - 1;
+        g->adj_begin[a + 1]++;
+        g->adj_begin[b + 1]++;
+    }
+    free(ids);
+
+    for (size_t i = 0; i < g->npts; i++) g->adj_begin[i + 1] += g->adj_begin[i];
+    g->adj = (uint32_t *)arena_or_malloc(arena, (2 * g->nsegs + 1) * sizeof(uint32_t));
+    size_t *fill = (size_t *)malloc((g->npts + 1) * sizeof(size_t));
+    if (!g->adj || !fill) {
+        free(fill);
+        view_graph_free(g);
+        return 0;
+    }
+    memcpy(fill, g->adj_begin, (g->npts + 1) * sizeof(size_t));
+    for (size_t s = 0; s < g->nsegs; s++) {
+        uint32_t a = (uint32_t)(g->seg_list[s] >> 32), b = (uint32_t)g->seg_list[s];
+        g->adj[fill[a]++] = b;
+        g->adj[fill[b]++] = a;
+    }
+    free(fill);
+    return 1;
+}
+
+int view_graph_compact(ViewGraph *g) {
+    size_t cap = 16, seg_cap = 16;
+    while (cap < 2 * g->npts) cap *= 2;
+    while (seg_cap < 2 * g->nsegs) seg_cap *= 2;
+
+    Arena *a = g->arena;
+    size_t *cells = (size_t *)arena_or_calloc(a, cap, sizeof(size_t));
+    long long (*cell_keys)[2] = arena_or_calloc(a, cap, sizeof(*cell_keys));
+    uint64_t *segs = (uint64_t *)arena_or_calloc(a, seg_cap, sizeof(uint64_t));
+    if (!cells || !cell_keys || !segs) {
+        if (cells) arena_or_free(a, cells);
+        if (cell_keys) arena_or_free(a, cell_keys);
+        if (segs) arena_or_free(a, segs);
+        return 0;
+    }
+    arena_or_free(a, g->cells);
+    arena_or_free(a, g->cell_keys);
+    arena_or_free(a, g->segs);
+    g->cells = cells;
+    g->cell_keys = cell_keys;
+    g->segs = segs;
+    g->cell_mask = cap - 1;
+    g->seg_mask = seg_cap - 1;
+
+    // Точки вставляются в порядке номеров — цепочки ячеек те же
+    for (size_t i = 0; i < g->npts; i++) {
+        long long ku = grid_key(g->pts[i].u, g->inv_cell);
+        long long kv = grid_key(g->pts[i].v, g->inv_cell);
+        size_t slot = cell_slot(g, ku, kv);
+        g->cell_keys[slot][0] = ku;
+        g->cell_keys[slot][1] = kv;
+        g->next[i] = g->cells[slot];
+        g->cells[slot] = i + 1;
+    }
+    for (size_t s = 0; s < g->nsegs; s++) {
+        uint64_t key = g->seg_list[s] + 1;
+        size_t slot = hash_u64(key) & g->seg_mask;
+        while (g->segs[slot]) slot = (slot + 1) & g->seg_mask;
+        g->segs[slot] = key;
+    }
+    return 1;
+}
+
+/* ----------------------------------------- */
+int wire_view_build(WireIndex *w, Arena *arena, const Projections *pr, int view) {
+    size_t n = view == VIEW_TOP ? pr->nxy : view == VIEW_FRONT ? pr->nxz : pr->nyz;
+    Point2D *raw = (Point2D *)malloc((n ? n : 1) * sizeof(Point2D));
+    if (!raw) return 0;
+    for (size_t i = 0; i < n; i++) {
+        raw[i] = view == VIEW_TOP ? (Point2D){pr->xy[i].x, pr->xy[i].y} :
+                 view == VIEW_FRONT ? (Point2D){pr->xz[i].x, pr->xz[i].z} :
+                 (Point2D){pr->yz[i].y, pr->yz[i].z};
+    }
+    int ok = view_graph_build(&w->views[view], arena, raw, n);
+    free(raw);
+    return ok;
+}
+
+int wire_index_build(WireIndex *w, Arena *arena, const Projections *pr) {
+    memset(w, 0, sizeof(*w));
+    int ok = wire_view_build(w, arena, pr, VIEW_FRONT) &&
+             wire_view_build(w, arena, pr, VIEW_PROFILE) &&
+             wire_view_build(w, arena, pr, VIEW_TOP);
+    if (!ok) wire_index_free(w);
+    return ok;
+}
+
+void wire_index_free(WireIndex *w) {
+    if (w->map) {
+        munmap(w->map, w->map_len);
+        memset(w, 0, sizeof(*w));
+        return;
+    }
+    for (int v = 0; v < VIEW_COUNT; v++) view_graph_free(&w->views[v]);
+}
+
+/* ----------------------------------------- */
+/* Покрытие вида. Ребро не обязательно нарисовано одним отрезком с концами
+   в проекциях своих вершин: линию разбивают точки других рёбер, а конец
+   ребра может упираться в середину чужого отрезка. Проекция a-b покрыта,
+   если отрезки чертежа, оба конца которых не дальше EPS от прямой a-b,
+   своими положениями вдоль a-b без разрывов больше EPS закрывают весь
+   [0, |ab|]. Отрезки для проверки берутся у точек вида вдоль a-b и из
+   отрезков, проходящих у a.
+   Кандидаты подбираются по частям: отрезки режутся лежащими на них (не
+   дальше COVER_TOL) точками вида, и от проекции вершины в виде сверху
+   идёт поиск по цепочкам частей. Концы покрывающих отрезков лежат не
+   дальше EPS от a-b, точки на них — не дальше COVER_TOL от отрезков,
+   поэтому все точки цепочки не дальше CONE_TOL от a-b */
+#define COVER_TOL (2.0 * EPS)
+#define CONE_TOL (3.0 * EPS)
+
+/* Множество пар точек: открытая адресация по ключу (min << 32 | max) + 1
+   и список пар в порядке добавления. Временное, через malloc */
+typedef struct {
+    uint64_t *slots;
+    size_t mask;
+    uint64_t *keys;        // min << 32 | max
+    size_t n;
+} PairSet;
+
+static void pairset_free(PairSet *s) {
+    free(s->slots);
+    free(s->keys);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Таблица вдвое больше, заполнение не выше половины */
+static int pairset_grow(PairSet *s) {
+    size_t cap = s->slots ? 2 * (s->mask + 1) : 1024;
+    uint64_t *slots = (uint64_t *)calloc(cap, sizeof(uint64_t));
+    uint64_t *keys = (uint64_t *)realloc(s->keys, cap / 2 * sizeof(uint64_t));
+    if (keys) s->keys = keys;
+    if (!slots || !keys) {
+        free(slots);
+        return 0;
+    }
+    free(s->slots);
+    s->slots = slots;
+    s->mask = cap - 1;
+    for (size_t k = 0; k < s->n; k++) {
+        size_t slot = hash_u64(s->keys[k] + 1) & s->mask;
+        while (s->slots[slot]) slot = (slot + 1) & s->mask;
+        s->slots[slot] = s->keys[k] + 1;
+    }
+    return 1;
+}
+
+/* Добавляет пару, если её ещё нет. Возвращает 0 при нехватке памяти */
+static int pairset_add(PairSet *s, size_t a, size_t b) {
+    if (!s->slots || 2 * (s->n + 1) > s->mask + 1) {
+        if (!pairset_grow(s)) return 0;
+    }
+    uint64_t key = seg_key(a, b) + 1;
+    size_t slot = hash_u64(key) & s->mask;
+    while (s->slots[slot]) {
+        if (s->slots[slot] == key) return 1;
+        slot = (slot + 1) & s->mask;
+    }
+    s->slots[slot] = key;
+    s->keys[s->n++] = key - 1;
+    return 1;
+}
+
+/* Пара есть в множестве */
+static int pairset_has(const PairSet *s, size_t a, size_t b) {
+    if (!s->slots) return 0;
+    uint64_t key = seg_key(a, b) + 1;
+    size_t slot = hash_u64(key) & s->mask;
+    while (s->slots[slot]) {
+        if (s->slots[slot] == key) return 1;
+        slot = (slot + 1) & s->mask;
+    }
+    return 0;
+}
+
+/* Смежность точек по парам множества, CSR (через malloc) */
+static int pairs_csr(const PairSet *s, size_t npts, size_t **begin, uint32_t **nbr) {
+    *begin = (size_t *)calloc(npts + 1, sizeof(size_t));
+    *nbr = (uint32_t *)malloc((2 * s->n + 1) * sizeof(uint32_t));
+    size_t *fill = (size_t *)malloc((npts + 1) * sizeof(size_t));
+    if (!*begin || !*nbr || !fill) {
+        free(fill);
+        return 0;
+    }
+    for (size_t k = 0; k < s->n; k++) {
+        (*begin)[(s->keys[k] >> 32) + 1]++;
+        (*begin)[(uint32_t)s->keys[k] + 1]++;
+    }
+    for (size_t i = 0; i < npts; i++) (*begin)[i + 1] += (*begin)[i];
+    memcpy(fill, *begin, (npts + 1) * sizeof(size_t));
+    for (size_t k = 0; k < s->n; k++) {
+        uint32_t a = (uint32_t)(s->keys[k] >> 32), b = (uint32_t)s->keys[k];
+        (*nbr)[fill[a]++] = b;
+        (*nbr)[fill[b]++] = a;
+    }
+    free(fill);
+    return 1;
+}
+
+/* Точка p не дальше COVER_TOL от отрезка a-b */
+static int near_segment(Point2D a, Point2D b, Point2D p) {
+    double du = b.u - a.u, dv = b.v - a.v;
+    double len2 = du * du + dv * dv;
+    double t = len2 > 0.0 ? ((p.u - a.u) * du + (p.v - a.v) * dv) / len2 : 0.0;
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;
+    double eu = a.u + t * du - p.u, ev = a.v + t * dv - p.v;
+    return eu * eu + ev * ev <= COVER_TOL * COVER_TOL;
+}
+
+/* p лежит строго внутри отрезка a-b: поперёк не дальше COVER_TOL, вдоль —
+   между концами и не совпадает с ними. *t — положение вдоль отрезка */
+static int inside_segment(Point2D a, Point2D b, Point2D p, double *t) {
+    double du = b.u - a.u, dv = b.v - a.v;
+    double len2 = du * du + dv * dv;
+    if (len2 == 0.0) return 0;
+    if ((approx_eq(p.u, a.u) && approx_eq(p.v, a.v)) ||
+        (approx_eq(p.u, b.u) && approx_eq(p.v, b.v)))
+        return 0;
+    *t = ((p.u - a.u) * du + (p.v - a.v) * dv) / len2;
+    if (*t <= 0.0 || *t >= 1.0) return 0;
+    return fabs((p.u - a.u) * dv - (p.v - a.v) * du) <= COVER_TOL * sqrt(len2);
+}
+
+/* Грубая сетка вида для поиска точек на отрезках и отрезков вдоль
+   проекций рёбер: ячеек примерно вчетверо больше, чем точек; ячейки
+   строки лежат подряд */
+typedef struct {
+    double min_u, min_v, h;
+    long long nu, nv;
+    size_t *begin;         // точки ячейки по строкам, CSR
+    uint32_t *ids;
+} CoarseGrid;
+
+static void coarse_free(CoarseGrid *c) {
+    free(c->begin);
+    free(c->ids);
+}
+
+static long long coarse_cell(const CoarseGrid *c, double x, double min, long long n) {
+    long long k = (long long)floor((x - min) / c->h);
+    return k < 0 ? 0 : k >= n ? n - 1 : k;
+}
+
+/* Размеры сетки по габаритам точек вида */
+static void coarse_size(CoarseGrid *c, const ViewGraph *g) {
+    memset(c, 0, sizeof(*c));
+    double max_u = g->pts[0].u, max_v = g->pts[0].v;
+    c->min_u = max_u;
+    c->min_v = max_v;
+    for (size_t i = 1; i < g->npts; i++) {
+        if (g->pts[i].u < c->min_u) c->min_u = g->pts[i].u;
+        if (g->pts[i].u > max_u) max_u = g->pts[i].u;
+        if (g->pts[i].v < c->min_v) c->min_v = g->pts[i].v;
+        if (g->pts[i].v > max_v) max_v = g->pts[i].v;
+    }
+    double side = fmax(max_u - c->min_u, max_v - c->min_v);
+    c->h = fmax(side / ceil(2.0 * sqrt((double)g->npts)), EPS);
+    c->nu = (long long)((max_u - c->min_u) / c->h) + 1;
+    c->nv = (long long)((max_v - c->min_v) / c->h) + 1;
+}
+
+static int coarse_build(CoarseGrid *c, const ViewGraph *g) {
+    coarse_size(c, g);
+    size_t ncells = (size_t)(c->nu * c->nv);
+    c->begin = (size_t *)calloc(ncells + 1, sizeof(size_t));
+    c->ids = (uint32_t *)malloc(g->npts * sizeof(uint32_t));
+    size_t *fill = (size_t *)malloc((ncells + 1) * sizeof(size_t));
+    if (!c->begin || !c->ids || !fill) {
+        free(fill);
+        coarse_free(c);
+        return 0;
+    }
+    for (size_t i = 0; i < g->npts; i++) {
+        long long cu = coarse_cell(c, g->pts[i].u, c->min_u, c->nu);
+        long long cv = coarse_cell(c, g->pts[i].v, c->min_v, c->nv);
+        c->begin[cv * c->nu + cu + 1]++;
+    }
+    for (size_t k = 0; k < ncells; k++) c->begin[k + 1] += c->begin[k];
+    memcpy(fill, c->begin, (ncells + 1) * sizeof(size_t));
+    for (size_t i = 0; i < g->npts; i++) {
+        long long cu = coarse_cell(c, g->pts[i].u, c->min_u, c->nu);
+        long long cv = coarse_cell(c, g->pts[i].v, c->min_v, c->nv);
+        c->ids[fill[cv * c->nu + cu]++] = (uint32_t)i;
+    }
+    free(fill);
+    return 1;
+}
+
+/* Строки сетки, над которыми проходит отрезок a-b с запасом m */
+static void coarse_rows(const CoarseGrid *c, Point2D a, Point2D b, double m,
+                        long long *r0, long long *r1) {
+    *r0 = coarse_cell(c, fmin(a.v, b.v) - m, c->min_v, c->nv);
+    *r1 = coarse_cell(c, fmax(a.v, b.v) + m, c->min_v, c->nv);
+}
+
+/* Ячейки [*c0, *c1] строки row, над которыми проходит отрезок a-b
+   с запасом m. Точка не дальше m от отрезка отстоит от какой-то его точки
+   не больше чем на m по каждой оси, поэтому её ячейка среди них.
+   0 — отрезок над строкой не проходит */
+static int coarse_row_cells(const CoarseGrid *c, Point2D a, Point2D b, double m,
+                            long long row, long long *c0, long long *c1) {
+    double vlo = fmin(a.v, b.v), vhi = fmax(a.v, b.v);
+    double lo = fmax(c->min_v + (double)row * c->h - m, vlo);
+    double hi = fmin(c->min_v + (double)(row + 1) * c->h + m, vhi);
+    if (lo > hi) return 0;
+    double u0 = a.u, u1 = b.u;
+    if (b.v != a.v) {
+        u0 = a.u + (b.u - a.u) * (lo - a.v) / (b.v - a.v);
+        u1 = a.u + (b.u - a.u) * (hi - a.v) / (b.v - a.v);
+    }
+    *c0 = coarse_cell(c, fmin(u0, u1) - m, c->min_u, c->nu);
+    *c1 = coarse_cell(c, fmax(u0, u1) + m, c->min_u, c->nu);
+    return 1;
+}
+
+/* Точка вида на отрезке и её положение вдоль него */
+typedef struct {
+    double t;
+    uint32_t id;
+} SegHit;
+
+static int cmp_hit(const void *a, const void *b) {
+    double x = ((const SegHit *)a)->t, y = ((const SegHit *)b)->t;
+    return (x > y) - (x < y);
+}
+
+/* Части отрезков вида между соседними точками на них и отрезки у каждой
+   точки (near_segment), CSR: *near_begin [npts + 1], *near_segs. В каждой
+   строке сетки точек c просматриваются только ячейки, над которыми
+   проходит отрезок, с запасом COVER_TOL */
+static int split_segments(const ViewGraph *g, const CoarseGrid *c, PairSet *parts,
+                          size_t **near_begin, uint32_t **near_segs) {
+    SegHit *hits = NULL;
+    size_t cap = 0;
+    uint64_t *near = NULL;     // точка << 32 | отрезок
+    size_t nnear = 0, near_cap = 0;
+    int ok = 1;
+
+    for (size_t s = 0; s < g->nsegs && ok; s++) {
+        uint32_t ia = (uint32_t)(g->seg_list[s] >> 32), ib = (uint32_t)g->seg_list[s];
+        Point2D a = g->pts[ia], b = g->pts[ib];
+        long long r0, r1, c0, c1;
+        coarse_rows(c, a, b, COVER_TOL, &r0, &r1);
+        size_t n = 0;
+        for (long long row = r0; row <= r1 && ok; row++) {
+            if (!coarse_row_cells(c, a, b, COVER_TOL, row, &c0, &c1)) continue;
+            size_t first = c->begin[row * c->nu + c0], last = c->begin[row * c->nu + c1 + 1];
+            for (size_t m = first; m < last; m++) {
+                double t;
+                if (!near_segment(a, b, g->pts[c->ids[m]])) continue;
+                if (nnear == near_cap) {
+                    size_t new_cap = near_cap ? near_cap * 2 : 1024;
+                    uint64_t *resized = (uint64_t *)realloc(near, new_cap * sizeof(uint64_t));
+                    if (!resized) {
+                        ok = 0;
+                        break;
+                    }
+                    near = resized;
+                    near_cap = new_cap;
+                }
+                near[nnear++] = (uint64_t)c->ids[m] << 32 | s;
+                if (!inside_segment(a, b, g->pts[c->ids[m]], &t)) continue;
+                if (n == cap) {
+                    size_t new_cap = cap ? cap * 2 : 64;
+                    SegHit *resized = (SegHit *)realloc(hits, new_cap * sizeof(SegHit));
+                    if (!resized) {
+                        ok = 0;
+                        break;
+                    }
+                    hits = resized;
+                    cap = new_cap;
+                }
+                hits[n++] = (SegHit){t, c->ids[m]};
+            }
+        }
+        if (!ok) break;
+
+        if (n > 1) qsort(hits, n, sizeof(SegHit), cmp_hit);
+        uint32_t prev = ia;
+        for (size_t k = 0; k <= n && ok; k++) {
+            uint32_t cur = k < n ? hits[k].id : ib;
+            if (cur != prev) ok = pairset_add(parts, prev, cur);
+            prev = cur;
+        }
+    }
+    free(hits);
+
+    // Пары уже идут по возрастанию отрезка, раскладка по точкам его сохраняет
+    *near_begin = ok ? (size_t *)calloc(g->npts + 1, sizeof(size_t)) : NULL;
+    *near_segs = ok ? (uint32_t *)malloc((nnear + 1) * sizeof(uint32_t)) : NULL;
+    size_t *fill = ok ? (size_t *)malloc((g->npts + 1) * sizeof(size_t)) : NULL;
+    ok = ok && *near_begin && *near_segs && fill;
+    if (ok) {
+        for (size_t k = 0; k < nnear; k++) (*near_begin)[(near[k] >> 32) + 1]++;
+        for (size_t i = 0; i < g->npts; i++) (*near_begin)[i + 1] += (*near_begin)[i];
+        memcpy(fill, *near_begin, (g->npts + 1) * sizeof(size_t));
+        for (size_t k = 0; k < nnear; k++) (*near_segs)[fill[near[k] >> 32]++] = (uint32_t)near[k];
+    }
+    free(fill);
+    free(near);
+    return ok;
+}
+
+/* Растущий временный список точек */
+typedef struct {
+    uint32_t *ids;
+    size_t n, cap;
+} IdList;
+
+static int id_push(IdList *l, uint32_t id) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 1024;
+        uint32_t *resized = (uint32_t *)realloc(l->ids, cap * sizeof(uint32_t));
+        if (!resized) return 0;
+        l->ids = resized;
+        l->cap = cap;
+    }
+    l->ids[l->n++] = id;
+    return 1;
+}
+
+/* Части отрезков вида: смежность точек, CSR */
+typedef struct {
+    size_t *begin;         // [npts + 1]
+    uint32_t *nbr;
+} ViewParts;
+
+static void parts_free(ViewParts *vp) {
+    free(vp->begin);
+    free(vp->nbr);
+    memset(vp, 0, sizeof(*vp));
+}
+
+/* Из a есть часть к b: её второй конец не дальше CONE_TOL от прямой a-b
+   и не позади a. У покрытой проекции так начинается цепочка частей */
+static int part_towards(const ViewGraph *g, const ViewParts *vp, size_t a, size_t b) {
+    Point2D pa = g->pts[a], pb = g->pts[b];
+    double du = pb.u - pa.u, dv = pb.v - pa.v;
+    double len = sqrt(du * du + dv * dv);
+    for (size_t m = vp->begin[a]; m < vp->begin[a + 1]; m++) {
+        const Point2D *x = &g->pts[vp->nbr[m]];
+        double wu = x->u - pa.u, wv = x->v - pa.v;
+        if (wu * du + wv * dv >= -CONE_TOL * len && fabs(wu * dv - wv * du) <= CONE_TOL * len)
+            return 1;
+    }
+    return 0;
+}
+
+/* Угол направлений [lo, hi] в радианах; не уже 2*pi — не ограничен */
+typedef struct {
+    double lo, hi;
+} Arc;
+
+#define ARC_FULL ((Arc){-2.0 * M_PI, 2.0 * M_PI})
+
+static int arc_full(Arc a) {
+    return a.hi - a.lo >= 2.0 * M_PI;
+}
+
+/* x, сдвинутый на кратное 2*pi в (ref - pi, ref + pi] */
+static double arc_align(double x, double ref) {
+    while (x > ref + M_PI) x -= 2.0 * M_PI;
+    while (x <= ref - M_PI) x += 2.0 * M_PI;
+    return x;
+}
+
+/* Часть a, отстоящая от направления phi не больше чем на w; 0 — пусто */
+static int arc_cut(Arc a, double phi, double w, Arc *out) {
+    if (arc_full(a)) {
+        *out = (Arc){phi - w, phi + w};
+        return 1;
+    }
+    phi = arc_align(phi, 0.5 * (a.lo + a.hi));
+    out->lo = fmax(a.lo, phi - w);
+    out->hi = fmin(a.hi, phi + w);
+    return out->lo <= out->hi;
+}
+
+/* a целиком внутри b */
+static int arc_within(Arc a, Arc b) {
+    if (arc_full(b)) return 1;
+    if (arc_full(a)) return 0;
+    double shift = arc_align(0.5 * (a.lo + a.hi), 0.5 * (b.lo + b.hi)) - 0.5 * (a.lo + a.hi);
+    return a.lo + shift >= b.lo && a.hi + shift <= b.hi;
+}
+
+static Arc arc_hull(Arc a, Arc b) {
+    if (arc_full(a) || arc_full(b)) return ARC_FULL;
+    double shift = arc_align(0.5 * (b.lo + b.hi), 0.5 * (a.lo + a.hi)) - 0.5 * (b.lo + b.hi);
+    Arc h = {fmin(a.lo, b.lo + shift), fmax(a.hi, b.hi + shift)};
+    return arc_full(h) ? ARC_FULL : h;
+}
+
+/* Поиск кандидатов по частям вида сверху из точки a: точка x годится,
+   если есть цепочка частей от a до x, все точки которой не дальше
+   CONE_TOL от прямой a-x. Для каждой точки хранится угол направлений
+   от a, допустимый после пройденных точек; точка просматривается заново,
+   только если пришли к ней с более широким углом. Найденные точки
+   дописываются в near (кроме отмеченных в seen значением mark) */
+typedef struct {
+    Arc arc;               // если mark — текущий поиск
+    double phi, w;         // направление от a и полуширина угла, если dir — текущий
+    size_t mark, dir;
+} ConePoint;
+
+typedef struct {
+    ConePoint *pts;        // [npts]
+    IdList stack;
+} ConeSearch;
+
+static int cone_search(ConeSearch *cs, const ViewGraph *g, const ViewParts *vp, size_t a,
+                       size_t mark, size_t *seen, IdList *near) {
+    Point2D pa = g->pts[a];
+    cs->stack.n = 0;
+    cs->pts[a].mark = mark;
+    cs->pts[a].arc = ARC_FULL;
+    if (!id_push(&cs->stack, (uint32_t)a)) return 0;
+    while (cs->stack.n > 0) {
+        size_t c = cs->stack.ids[--cs->stack.n];
+        Arc cur = cs->pts[c].arc;
+        // Отсечка без atan2 и asin: направление, отстоящее от середины
+        // узкой дуги больше чем на полуширину плюс asin(CONE_TOL / d),
+        // дугу не задевает; синус суммы углов не больше суммы синусов
+        int narrow = !arc_full(cur) && cur.hi - cur.lo < M_PI;
+        double mu = 0.0, mv = 0.0, sin_half = 0.0, cos_half = 0.0;
+        if (narrow) {
+            double mid = 0.5 * (cur.lo + cur.hi), half = 0.5 * (cur.hi - cur.lo);
+            mu = cos(mid);
+            mv = sin(mid);
+            sin_half = sin(half);
+            cos_half = cos(half);
+        }
+        for (size_t m = vp->begin[c]; m < vp->begin[c + 1]; m++) {
+            size_t x = vp->nbr[m];
+            ConePoint *px = &cs->pts[x];
+            if (narrow) {
+                double wu = g->pts[x].u - pa.u, wv = g->pts[x].v - pa.v;
+                double d = sqrt(wu * wu + wv * wv);
+                double along = wu * mu + wv * mv, across = fabs(wu * mv - wv * mu);
+                if (along > 0.0 ? across > d * sin_half + CONE_TOL + EPS
+                                : d * cos_half > CONE_TOL + EPS)
+                    continue;
+            }
+            // Угол до x не зависит от пути: считается при первом проходе
+            if (px->dir != mark) {
+                double wu = g->pts[x].u - pa.u, wv = g->pts[x].v - pa.v;
+                double d = sqrt(wu * wu + wv * wv);
+                px->dir = mark;
+                px->phi = atan2(wv, wu);
+                px->w = d > CONE_TOL ? asin(CONE_TOL / d) : -1.0;
+            }
+            Arc next = cur;
+            if (px->w >= 0.0 && !arc_cut(cur, px->phi, px->w, &next)) continue;
+            if (px->mark == mark) {
+                if (arc_within(next, px->arc)) continue;
+                px->arc = arc_hull(px->arc, next);
+            } else {
+                px->mark = mark;
+                px->arc = next;
+                if (seen[x] != mark) {
+                    seen[x] = mark;
+                    if (!id_push(near, (uint32_t)x)) return 0;
+                }
+            }
+            if (!id_push(&cs->stack, (uint32_t)x)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Положение отрезка вдоль проверяемой проекции */
+typedef struct {
+    double t0, t1;
+} Span;
+
+/* Для каждой точки вида — отрезки, проходящие от неё не дальше
+   COVER_TOL (CSR), точки вида в ячейках грубой сетки, рабочий массив
+   проверки покрытия и её итоги: пару точек вида проверяют многие пары
+   вершин над ними */
+typedef struct {
+    size_t *begin;         // [npts + 1]
+    uint32_t *segs;
+    CoarseGrid pts;
+    Span *spans;
+    PairSet covered, open;
+} CoverIndex;
+
+static void cover_index_free(CoverIndex *ci) {
+    free(ci->begin);
+    free(ci->segs);
+    coarse_free(&ci->pts);
+    pairset_free(&ci->covered);
+    pairset_free(&ci->open);
+    free(ci->spans);
+    memset(ci, 0, sizeof(*ci));
+}
+
+/* Сетка точек, части отрезков vp и отрезки у точек вида — за один проход
+   по отрезкам */
+static int cover_index_build(CoverIndex *ci, ViewParts *vp, const ViewGraph *g) {
+    memset(ci, 0, sizeof(*ci));
+    memset(vp, 0, sizeof(*vp));
+    if (g->npts == 0) return 1;
+    PairSet parts;
+    memset(&parts, 0, sizeof(parts));
+    ci->spans = (Span *)malloc((g->nsegs + 1) * sizeof(Span));
+    int ok = ci->spans && coarse_build(&ci->pts, g) &&
+             split_segments(g, &ci->pts, &parts, &ci->begin, &ci->segs) &&
+             pairs_csr(&parts, g->npts, &vp->begin, &vp->nbr);
+    pairset_free(&parts);
+    if (!ok) {
+        cover_index_free(ci);
+        parts_free(vp);
+    }
+    return ok;
+}
+
+static int cmp_span(const void *a, const void *b) {
+    double x = ((const Span *)a)->t0, y = ((const Span *)b)->t0;
+    return (x > y) - (x < y);
+}
+
+/* Положение отрезка p-q вдоль прямой из a по (du, dv) длины len, если оба
+   его конца не дальше EPS от неё */
+static inline int seg_span(Point2D p, Point2D q, Point2D a,
+                           double du, double dv, double len, Span *sp) {
+    if (fabs((p.u - a.u) * dv - (p.v - a.v) * du) > EPS * len ||
+        fabs((q.u - a.u) * dv - (q.v - a.v) * du) > EPS * len)
+        return 0;
+    double t0 = ((p.u - a.u) * du + (p.v - a.v) * dv) / len;
+    double t1 = ((q.u - a.u) * du + (q.v - a.v) * dv) / len;
+    *sp = t0 < t1 ? (Span){t0, t1} : (Span){t1, t0};
+    return 1;
+}
+
+/* Точка p не дальше EPS от прямой из a по (du, dv) и не дальше EPS
+   за концами отрезка длины len на ней */
+static inline int on_line(Point2D p, Point2D a, double du, double dv, double len) {
+    double t = ((p.u - a.u) * du + (p.v - a.v) * dv) / len;
+    return fabs((p.u - a.u) * dv - (p.v - a.v) * du) <= EPS * len &&
+           t >= -EPS && t <= len + EPS;
+}
+
+static inline Point2D seg_end(const ViewGraph *g, size_t s, int second) {
+    return g->pts[second ? (uint32_t)g->seg_list[s] : g->seg_list[s] >> 32];
+}
+
+/* Есть отрезок прямой a-b, с которого покрытие может начаться (at_b == 0:
+   начало не дальше EPS от a, конец дальше a) или на котором закончиться
+   (at_b: конец не ближе |ab| - EPS, начало ближе |ab|). Такой отрезок
+   проходит не дальше sqrt(2) EPS от a или b, поэтому хватает отрезков
+   у этой точки. Без него a-b не покрыта. 2 — начальный отрезок один
+   закрывает всю a-b (длинный отрезок через несколько точек) */
+static int seg_at_end(const CoverIndex *ci, const ViewGraph *g, size_t ia, size_t ib,
+                      double len, int at_b) {
+    Point2D a = g->pts[ia], b = g->pts[ib];
+    size_t e = at_b ? ib : ia;
+    double du = b.u - a.u, dv = b.v - a.v;
+    int found = 0;
+    for (size_t m = ci->begin[e]; m < ci->begin[e + 1]; m++) {
+        Span sp;
+        if (!seg_span(seg_end(g, ci->segs[m], 0), seg_end(g, ci->segs[m], 1), a, du, dv, len,
+                      &sp))
+            continue;
+        if (at_b) {
+            if (sp.t1 >= len - EPS && sp.t0 < len) return 1;
+        } else if (sp.t0 <= EPS && sp.t1 > 0.0) {
+            if (sp.t1 >= len - EPS) return 2;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+/* Проекция a-b покрыта отрезками вида (см. начало раздела). Отрезок,
+   положение которого вдоль a-b не задевает [0, |ab|], итог не меняет.
+   У задевающего либо есть конец на a-b (on_line) — такие берутся
+   из смежности точек вида в ячейках проекции с запасом COVER_TOL, —
+   либо он проходит над a и есть среди отрезков у a. Длинные отрезки
+   чужих прямых так не просматриваются. Проверка идёт, только если
+   у обоих концов есть отрезки, с которых покрытие начинается и на
+   которых заканчивается. Прямая берётся от точки с меньшим номером,
+   итог запоминается. Возвращает 1 или 0, -1 при нехватке памяти */
+static int seg_covered(CoverIndex *ci, const ViewGraph *g, size_t ia, size_t ib) {
+    if (!ci->spans) return 0;
+    if (pairset_has(&ci->covered, ia, ib)) return 1;
+    if (pairset_has(&ci->open, ia, ib)) return 0;
+    if (ia > ib) {
+        size_t t = ia;
+        ia = ib;
+        ib = t;
+    }
+    Point2D a = g->pts[ia], b = g->pts[ib];
+    double du = b.u - a.u, dv = b.v - a.v;
+    double len = sqrt(du * du + dv * dv);
+    int covered = len <= EPS ? 2 : seg_at_end(ci, g, ia, ib, len, 0);
+    if (covered == 1) covered = seg_at_end(ci, g, ia, ib, len, 1);
+    if (covered == 1) {
+        size_t n = 0;
+        for (size_t m = ci->begin[ia]; m < ci->begin[ia + 1]; m++) {
+            Point2D p = seg_end(g, ci->segs[m], 0), q = seg_end(g, ci->segs[m], 1);
+            if (on_line(p, a, du, dv, len) || on_line(q, a, du, dv, len)) continue;
+            if (seg_span(p, q, a, du, dv, len, &ci->spans[n])) n++;
+        }
+        // Отрезок с обоими концами на a-b берётся у конца с меньшим номером
+        const CoarseGrid *c = &ci->pts;
+        long long r0, r1, c0, c1;
+        coarse_rows(c, a, b, COVER_TOL, &r0, &r1);
+        for (long long row = r0; row <= r1; row++) {
+            if (!coarse_row_cells(c, a, b, COVER_TOL, row, &c0, &c1)) continue;
+            size_t first = c->begin[row * c->nu + c0], last = c->begin[row * c->nu + c1 + 1];
+            for (size_t m = first; m < last; m++) {
+                uint32_t p = c->ids[m];
+                if (!on_line(g->pts[p], a, du, dv, len)) continue;
+                for (size_t k = g->adj_begin[p]; k < g->adj_begin[p + 1]; k++) {
+                    uint32_t x = g->adj[k];
+                    if (x < p && on_line(g->pts[x], a, du, dv, len)) continue;
+                    if (seg_span(g->pts[p], g->pts[x], a, du, dv, len, &ci->spans[n])) n++;
+                }
+            }
+        }
+        qsort(ci->spans, n, sizeof(Span), cmp_span);
+        double reach = 0.0;
+        for (size_t i = 0; i < n && ci->spans[i].t0 <= reach + EPS; i++) {
+            if (ci->spans[i].t1 > reach) reach = ci->spans[i].t1;
+        }
+        covered = reach >= len - EPS;
+    }
+    if (!pairset_add(covered ? &ci->covered : &ci->open, ia, ib)) return -1;
+    return covered != 0;
+}
+
+/* Проекция ребра на вид: вырождается в точку, совпадает с отрезком
+   чертежа или покрыта отрезками одной прямой. Точная проверка — только
+   если из обоих концов есть части друг к другу. -1 при нехватке памяти */
+static inline int view_allows(const ViewGraph *g, const ViewParts *vp, CoverIndex *ci,
+                              long long a, long long b) {
+    if (a == b || view_graph_has_segment(g, (size_t)a, (size_t)b)) return 1;
+    if (!part_towards(g, vp, (size_t)a, (size_t)b) ||
+        !part_towards(g, vp, (size_t)b, (size_t)a))
+        return 0;
+    return seg_covered(ci, g, (size_t)a, (size_t)b);
+}
+
+/* r лежит строго внутри ребра p-q */
+static int inside_edge(const PointXYZ *p, const PointXYZ *q, const PointXYZ *r) {
+    double d[3] = {q->x - p->x, q->y - p->y, q->z - p->z};
+    double w[3] = {r->x - p->x, r->y - p->y, r->z - p->z};
+    double len2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    double t = (w[0] * d[0] + w[1] * d[1] + w[2] * d[2]) / len2;
+    if (len2 == 0.0 || t <= 0.0 || t >= 1.0) return 0;
+    double c[3] = {w[1] * d[2] - w[2] * d[1], w[2] * d[0] - w[0] * d[2],
+                   w[0] * d[1] - w[1] * d[0]};
+    return sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]) <= EPS * sqrt(len2);
+}
+
+static int cmp_edge(const void *a, const void *b) {
+    const Edge3D *x = (const Edge3D *)a, *y = (const Edge3D *)b;
+    if (x->a != y->a) return x->a < y->a ? -1 : 1;
+    if (x->b != y->b) return x->b < y->b ? -1 : 1;
+    return 0;
+}
+
+/* Рёбра, составленные из двух других: через середину ребра p-q проходит
+   вершина r, и рёбра p-r и r-q тоже найдены. Такие рёбра выбрасываются,
+   остальные сдвигаются к началу с сохранением порядка. Возвращает
+   новое число рёбер или (size_t)-1 при нехватке памяти */
+static size_t drop_composite(Arena *arena, const PointXYZ *verts, size_t nverts,
+                             Edge3D *res, size_t cnt) {
+    size_t *begin = (size_t *)arena_or_calloc(arena, nverts + 1, sizeof(size_t));
+    size_t *adj = (size_t *)arena_or_malloc(arena, (2 * cnt + 1) * sizeof(size_t));
+    size_t *fill = (size_t *)malloc((nverts + 1) * sizeof(size_t));
+    unsigned char *drop = (unsigned char *)calloc(cnt + 1, 1);
+    size_t kept = (size_t)-1;
+    if (!begin || !adj || !fill || !drop) goto done;
+
+    for (size_t e = 0; e < cnt; e++) {
+        begin[res[e].a + 1]++;
+        begin[res[e].b + 1]++;
+    }
+    for (size_t i = 0; i < nverts; i++) begin[i + 1] += begin[i];
+    memcpy(fill, begin, (nverts + 1) * sizeof(size_t));
+    for (size_t e = 0; e < cnt; e++) {
+        adj[fill[res[e].a]++] = res[e].b;
+        adj[fill[res[e].b]++] = res[e].a;
+    }
+
+    for (size_t e = 0; e < cnt; e++) {
+        size_t p = res[e].a, q = res[e].b;
+        for (size_t k = begin[p]; k < begin[p + 1] && !drop[e]; k++) {
+            size_t r = adj[k];
+            if (r == q || !inside_edge(&verts[p], &verts[q], &verts[r])) continue;
+            for (size_t m = begin[r]; m < begin[r + 1]; m++) {
+                if (adj[m] == q) {
+                    drop[e] = 1;
+                    break;
+                }
+            }
+        }
+    }
+    kept = 0;
+    for (size_t e = 0; e < cnt; e++) {
+        if (!drop[e]) res[kept++] = res[e];
+    }
+
+done:
+    arena_or_free(arena, begin);
+    arena_or_free(arena, adj);
+    free(fill);
+    free(drop);
+    return kept;
+}
+
+int find_wires(const WireIndex *w, Arena *arena, const PointXYZ *verts, size_t nverts,
+               Edge3D **edges, size_t *nedges) {
+    *edges = NULL;
+    *nedges = 0;
+
+    const ViewGraph *front = &w->views[VIEW_FRONT];
+    const ViewGraph *profile = &w->views[VIEW_PROFILE];
+    const ViewGraph *top = &w->views[VIEW_TOP];
+
+    ViewParts parts[VIEW_COUNT];
+    CoverIndex cover[VIEW_COUNT];
+    memset(parts, 0, sizeof(parts));
+    memset(cover, 0, sizeof(cover));
+    long long (*ids)[VIEW_COUNT] = arena_or_malloc(arena, nverts * sizeof(*ids));
+    size_t *by_top_begin = (size_t *)arena_or_calloc(arena, top->npts + 2, sizeof(size_t));
+    size_t *by_top = (size_t *)arena_or_malloc(arena, nverts * sizeof(size_t));
+    size_t *seen = (size_t *)arena_or_calloc(arena, top->npts + 1, sizeof(size_t));
+    ConeSearch cone = {NULL, {NULL, 0, 0}};
+    cone.pts = (ConePoint *)arena_or_calloc(arena, top->npts + 1, sizeof(ConePoint));
+    IdList near = {NULL, 0, 0};
+    int ok = ids && by_top_begin && by_top && seen && cone.pts;
+    for (int v = 0; v < VIEW_COUNT && ok; v++)
+        ok = cover_index_build(&cover[v], &parts[v], &w->views[v]);
+    if (!ok) {
+        for (int v = 0; v < VIEW_COUNT; v++) {
+            parts_free(&parts[v]);
+            cover_index_free(&cover[v]);
+        }
+        arena_or_free(arena, cone.pts);
+        arena_or_free(arena, ids);
+        arena_or_free(arena, by_top_begin);
+        arena_or_free(arena, by_top);
+        arena_or_free(arena, seen);
+        return 0;
+    }
+
+    // Проекции вершин на точки видов и обратное отображение
+    // "точка вида сверху -> вершины над ней"
+    for (size_t i = 0; i < nverts; i++) {
+        ids[i][VIEW_FRONT] = view_graph_find(front, verts[i].x, verts[i].z);
+        ids[i][VIEW_PROFILE] = view_graph_find(profile, verts[i].y, verts[i].z);
+        ids[i][VIEW_TOP] = view_graph_find(top, verts[i].x, verts[i].y);
+        if (ids[i][VIEW_TOP] >= 0) by_top_begin[ids[i][VIEW_TOP] + 2]++;
+    }
+    for (size_t t = 0; t < top->npts; t++) by_top_begin[t + 2] += by_top_begin[t + 1];
+    for (size_t i = 0; i < nverts; i++) {
+        if (ids[i][VIEW_TOP] >= 0) by_top[by_top_begin[ids[i][VIEW_TOP] + 1]++] = i;
+    }
+
+    Edge3D *res = NULL;
+    size_t cnt = 0, cap = 0;
+
+    // Поиск соседей и проверка вида сверху зависят только от точки вида
+    // сверху, поэтому идут один раз на точку, а не на каждую вершину над ней
+    for (size_t t = 0; t < top->npts && ok; t++) {
+        if (by_top_begin[t] == by_top_begin[t + 1]) continue;
+
+        // Сама точка вида сверху (вертикальное ребро), соседи по отрезкам
+        // чертежа и точки цепочек частей из неё; каждая точка берётся один раз
+        near.n = 0;
+        seen[t] = t + 1;
+        ok = id_push(&near, (uint32_t)t);
+        for (size_t k = top->adj_begin[t]; k < top->adj_begin[t + 1] && ok; k++) {
+            uint32_t nb = top->adj[k];
+            if (seen[nb] == t + 1) continue;
+            seen[nb] = t + 1;
+            ok = id_push(&near, nb);
+        }
+        if (ok && parts[VIEW_TOP].begin)
+            ok = cone_search(&cone, top, &parts[VIEW_TOP], t, t + 1, seen, &near);
+        for (size_t k = 0; k < near.n && ok; k++) {
+            size_t nb = near.ids[k];
+            int top_ok = 2;     // вид сверху проверяется при первой паре
+            for (size_t i = by_top_begin[t]; i < by_top_begin[t + 1] && ok; i++) {
+                size_t p = by_top[i];
+                if (ids[p][VIEW_FRONT] < 0 || ids[p][VIEW_PROFILE] < 0) continue;
+                for (size_t m = by_top_begin[nb]; m < by_top_begin[nb + 1]; m++) {
+                    size_t q = by_top[m];
+                    if (q <= p || ids[q][VIEW_FRONT] < 0 || ids[q][VIEW_PROFILE] < 0)
+                        continue;
+                    if (ids[q][VIEW_FRONT] == ids[p][VIEW_FRONT] &&
+                        ids[q][VIEW_PROFILE] == ids[p][VIEW_PROFILE] && nb == t)
+                        continue;
+                    if (top_ok == 2)
+                        top_ok = view_allows(top, &parts[VIEW_TOP], &cover[VIEW_TOP],
+                                             (long long)t, (long long)nb);
+                    if (top_ok <= 0) break;
+                    int allows = view_allows(front, &parts[VIEW_FRONT], &cover[VIEW_FRONT],
+                                             ids[p][VIEW_FRONT], ids[q][VIEW_FRONT]);
+                    if (allows > 0)
+                        allows = view_allows(profile, &parts[VIEW_PROFILE],
+                                             &cover[VIEW_PROFILE], ids[p][VIEW_PROFILE],
+                                             ids[q][VIEW_PROFILE]);
+                    if (allows < 0) {
+                        ok = 0;
+                        break;
+                    }
+                    if (!allows) continue;
+
+                    if (cnt == cap) {
+                        size_t new_cap = cap ? cap * 2 : 1024;
+                        // Массив рёбер выдаётся последним и растёт в арене на месте
+                        Edge3D *resized = arena ?
+                            (Edge3D *)arena_grow(arena, res, cap * sizeof(Edge3D),
+                                                 new_cap * sizeof(Edge3D)) :
+                            (Edge3D *)realloc(res, new_cap * sizeof(Edge3D));
+                        if (!resized) {
+                            ok = 0;
+                            break;
+                        }
+                        res = resized;
+                        cap = new_cap;
+                    }
+                    res[cnt++] = (Edge3D){p, q};
+                }
+                if (top_ok < 0) ok = 0;
+                if (top_ok <= 0) break;
+            }
+        }
+    }
+
+    if (ok) {
+        cnt = drop_composite(arena, verts, nverts, res, cnt);
+        ok = cnt != (size_t)-1;
+    }
+    // Рёбра идут по точкам вида сверху; порядок выдачи — по вершинам
+    if (ok) qsort(res, cnt, sizeof(Edge3D), cmp_edge);
+
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        parts_free(&parts[v]);
+        cover_index_free(&cover[v]);
+    }
+    free(near.ids);
+    free(cone.stack.ids);
+    arena_or_free(arena, cone.pts);
+    arena_or_free(arena, ids);
+    arena_or_free(arena, by_top_begin);
+    arena_or_free(arena, by_top);
+    arena_or_free(arena, seen);
+
+    if (!ok) {
+        arena_or_free(arena, res);
+        return 0;
+    }
+    *edges = res;
+    *nedges = cnt;
+    return 1;
+}
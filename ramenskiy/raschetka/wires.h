@@ -0,0 +1,89 @@
+#ifndef WIRES_H
+#define WIRES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "geom.h"
+#include "parse.h"
+
+/* Точка вида в его собственных координатах (u, v) */
+typedef struct {
+    double u, v;
+} Point2D;
+
+/* Граф одного вида: различные (с точностью EPS) точки вида и отрезки
+   между ними. Отрезки берутся из пар соседних точек секции в порядке
+   файла: каждый отрезок чертежа записан двумя концами подряд */
+typedef struct {
+    Point2D *pts;          // различные точки вида
+    size_t npts;
+    size_t *next;          // цепочки точек одной ячейки сетки
+    size_t *cells;         // открытая адресация: номер точки + 1
+    long long (*cell_keys)[2];
+    size_t cell_mask;
+    double inv_cell;
+
+    uint64_t *segs;        // множество отрезков: (min << 32 | max) + 1
+    size_t seg_mask;
+    uint64_t *seg_list;    // отрезки в порядке чертежа: min << 32 | max
+    size_t nsegs;
+
+    size_t *adj_begin;     // смежность точек вида, CSR: [npts + 1]
+    uint32_t *adj;
+    Arena *arena;          // откуда массивы (NULL — malloc)
+} ViewGraph;
+
+/* Индекс отрезков всех трёх видов */
+typedef struct {
+    ViewGraph views[VIEW_COUNT];
+    void *map;             // массивы графов лежат в отображённом кэше (cache.h)
+    size_t map_len;
+} WireIndex;
+
+/* Ребро каркаса: номера вершин, a < b */
+typedef struct {
+    size_t a, b;
+} Edge3D;
+
+/* Строится по проекциям в порядке файла, то есть до сортировки.
+   arena != NULL — массивы графов выдаются из неё */
+int wire_index_build(WireIndex *w, Arena *arena, const Projections *pr);
+
+/* Граф одного вида (view — VIEW_*) в w->views[view]; остальные виды не
+   трогаются. Так виды строятся по мере чтения (pipeline.h) */
+int wire_view_build(WireIndex *w, Arena *arena, const Projections *pr, int view);
+void wire_index_free(WireIndex *w);
+
+/* Ужимает хеш-таблицы точек и отрезков до размера по числу различных
+   точек и отрезков (при построении они рассчитаны на все точки чертежа).
+   Поиск даёт те же результаты; старые таблицы графа из арены остаются
+   в ней до сброса. Возвращает 1 при успехе */
+int view_graph_compact(ViewGraph *g);
+
+/* Номер точки вида, совпадающей с (u, v) с точностью EPS, или -1 */
+long long view_graph_find(const ViewGraph *g, double u, double v);
+
+/* Есть ли в виде отрезок между точками a и b (в любом направлении) */
+int view_graph_has_segment(const ViewGraph *g, size_t a, size_t b);
+
+/* Рёбра между восстановленными вершинами. Проекции вершины в видах —
+   точки видов, совпадающие с ними с точностью EPS. В каждом виде проекции
+   концов ребра совпадают или проекция ребра покрыта отрезками чертежа:
+   отрезки, оба конца которых не дальше EPS от прямой a-b, своими
+   положениями вдоль a-b без разрывов больше EPS закрывают весь [0, |ab|].
+   Ребро на чертеже часто разбито точками других рёбер или упирается
+   концом в середину чужого отрезка, поэтому кандидаты — точки вида
+   сверху, до которых от проекции вершины идёт цепочка частей отрезков
+   (отрезков, разрезанных лежащими на них точками вида) вблизи одной
+   прямой, а покрытие проверяется точно по отрезкам у точек вида на ней.
+   Ребро, через середину которого проходит другая вершина с рёбрами
+   до обоих концов, не выдаётся: его заменяют два коротких. Рёбра
+   упорядочены по (a, b).
+   arena != NULL — рабочие массивы и сами рёбра выдаются из неё (рёбра
+   живут до сброса арены), иначе рёбра освобождаются через free.
+   Возвращает 1 при успехе */
+int find_wires(const WireIndex *w, Arena *arena, const PointXYZ *verts, size_t nverts,
+               Edge3D **edges, size_t *nedges);
+
+#endif
@@ -0,0 +1,334 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "writer.h"
+
+#define WRITER_BUF (1 << 20)
+
+/* Окно, в котором v * 10^decimals представимо с погрешностью меньше 0.002:
+   тогда округление до целого совпадает с округлением точного значения,
+   если дробная часть не у самой середины */
+#define FIXED_FAST_LIMIT 8.0e12
+#define FIXED_TIE_MARGIN 0.01
+
+static const double pow10_tab[10] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+int writer_open(Writer *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    if (!path || strcmp(path, "-") == 0) {
+        w->f = stdout;
+    } else {
+        w->f = fopen(path, "wb");
+        if (!w->f) {
+            perror(path);
+            return 0;
+        }
+        w->owns = 1;
+    }
+    w->cap = WRITER_BUF;
+    w->buf = (char *)malloc(w->cap);
+    w->ok = w->buf != NULL;
+    if (!w->ok && w->owns) fclose(w->f);
+    return w->ok;
+}
+
+int writer_open_mem(Writer *w) {
+    memset(w, 0, sizeof(*w));
+    w->cap = WRITER_BUF;
+    w->buf = (char *)malloc(w->cap);
+    w->ok = w->buf != NULL;
+    return w->ok;
+}
+
+void writer_clear(Writer *w) {
+    w->len = 0;
+    w->ok = w->buf != NULL;
+}
+
+static void writer_flush(Writer *w) {
+    if (!w->f) return;
+    if (w->ok && w->len && fwrite(w->buf, 1, w->len, w->f) != w->len) w->ok = 0;
+    w->len = 0;
+}
+
+/* Рост буфера вывода в память до n байт сверх записанного */
+static void writer_grow(Writer *w, size_t n) {
+    size_t cap = w->cap;
+    while (cap < w->len + n) cap *= 2;
+    char *resized = (char *)realloc(w->buf, cap);
+    if (!resized) {
+        w->ok = 0;
+        return;
+    }
+    w->buf = resized;
+    w->cap = cap;
+}
+
+int writer_close(Writer *w) {
+    writer_flush(w);
+    if (w->owns) {
+        if (fclose(w->f) != 0) w->ok = 0;
+    } else if (w->f && fflush(w->f) != 0) {
+        w->ok = 0;
+    }
+    free(w->buf);
+    int ok = w->ok;
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+/* Место под n байт в буфере; NULL при ошибке записи */
+static char *writer_reserve(Writer *w, size_t n) {
+    if (w->len + n > w->cap) {
+        if (w->f) writer_flush(w);
+        else if (w->ok) writer_grow(w, n);
+    }
+    return w->ok ? w->buf + w->len : NULL;
+}
+
+void writer_bytes(Writer *w, const void *p, size_t n) {
+    if (n > w->cap && w->f) {
+        // Большой блок идёт мимо буфера
+        writer_flush(w);
+        if (w->ok && fwrite(p, 1, n, w->f) != n) w->ok = 0;
+        return;
+    }
+    char *dst = writer_reserve(w, n);
+    if (!dst) return;
+    memcpy(dst, p, n);
+    w->len += n;
+}
+
+void writer_str(Writer *w, const char *s) {
+    writer_bytes(w, s, strlen(s));
+}
+
+static size_t format_uint(char *out, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+void writer_uint(Writer *w, uint64_t v) {
+    char *dst = writer_reserve(w, 20);
+    if (dst) w->len += format_uint(dst, v);
+}
+
+size_t format_fixed(char *out, double v, int decimals, char point) {
+    double scaled = fabs(v) * pow10_tab[decimals];
+    double whole = floor(scaled);
+    double frac = scaled - whole;
+    if (!(scaled < FIXED_FAST_LIMIT) || fabs(frac - 0.5) < FIXED_TIE_MARGIN) {
+        int n = snprintf(out, FIXED_MAX, "%.*f", decimals, v);
+        if (point != '.') {
+            char *dot = strchr(out, '.');
+            if (dot) *dot = point;
+        }
+        return (size_t)n;
+    }
+
+    uint64_t r = (uint64_t)whole + (frac > 0.5);
+    uint64_t unit = (uint64_t)pow10_tab[decimals];
+    size_t n = 0;
+    if (signbit(v)) out[n++] = '-';
+    n += format_uint(out + n, r / unit);
+    if (decimals > 0) {
+        out[n++] = point;
+        uint64_t f = r % unit;
+        for (int d = decimals - 1; d >= 0; d--) {
+            out[n + (size_t)d] = (char)('0' + f % 10);
+            f /= 10;
+        }
+        n += (size_t)decimals;
+    }
+    return n;
+}
+
+void writer_fixed(Writer *w, double v, int decimals, char point) {
+    char *dst = writer_reserve(w, FIXED_MAX);
+    if (dst) w->len += format_fixed(dst, v, decimals, point);
+}
+
+int out_format_parse(const char *name, OutFormat *f) {
+    static const char *names[] = {"list", "points", "ply", "obj", "bin"};
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *f = (OutFormat)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ----------------------------------------- */
+/* Форматы */
+static void write_list(Writer *w, const ResultData *r) {
+    for (size_t i = 0; i < r->npts; i++) {
+        writer_str(w, "Точка ");
+        writer_uint(w, i + 1);
+        writer_str(w, ": (");
+        writer_fixed(w, r->pts[i].x, 6, '.');
+        writer_str(w, ", ");
+        writer_fixed(w, r->pts[i].y, 6, '.');
+        writer_str(w, ", ");
+        writer_fixed(w, r->pts[i].z, 6, '.');
+        writer_str(w, ")\n");
+    }
+    for (size_t e = 0; e < r->nedges; e++) {
+        writer_str(w, "Ребро ");
+        writer_uint(w, e + 1);
+        writer_str(w, ": ");
+        writer_uint(w, r->edges[e].a + 1);
+        writer_str(w, " - ");
+        writer_uint(w, r->edges[e].b + 1);
+        writer_str(w, "\n");
+    }
+}
+
+/* Знаков после запятой: 3, как в эталонах, больше при более мелкой сетке */
+static int points_decimals(void) {
+    double step = geom_step > 0.0 ? geom_step : EPS;
+    int d = 3;
+    while (d < 9 && pow10_tab[d] * step < 1.0) d++;
+    return d;
+}
+
+/* Координаты точек построчно, как в секции "3D points" */
+static void write_triples(Writer *w, const PointXYZ *pts, size_t n) {
+    int d = points_decimals();
+    for (size_t i = 0; i < n; i++) {
+        writer_fixed(w, pts[i].x, d, ',');
+        writer_str(w, "\r\n");
+        writer_fixed(w, pts[i].y, d, ',');
+        writer_str(w, "\r\n");
+        writer_fixed(w, pts[i].z, d, ',');
+        writer_str(w, "\r\n");
+    }
+}
+
+static void write_points(Writer *w, const ResultData *r) {
+    static const char *views[VIEW_COUNT] = {"frontView", "profileView", "topView"};
+    writer_str(w, "start\r\n");
+    for (int v = 0; v < VIEW_COUNT; v++) {
+        writer_str(w, views[v]);
+        writer_str(w, "\r\nlcsX= ");
+        writer_fixed(w, r->lcs ? r->lcs[v][0] : 0.0, 5, ',');
+        writer_str(w, "\r\nlcsY= ");
+        writer_fixed(w, r->lcs ? r->lcs[v][1] : 0.0, 5, ',');
+        writer_str(w, "\r\n");
+    }
+
+    writer_str(w, "3D points\r\n");
+    write_triples(w, r->pts, r->npts);
+    // "3d" в чертежах исходной программы — число вершин, а не рёбер:
+    // секция "3D edges" у неё пустая (так же пишет gen.c)
+    writer_str(w, "3D edges\r\n3d ");
+    writer_uint(w, r->npts);
+    writer_str(w, "\r\n");
+
+    if (r->times) {
+        // Поля времени — те же, что печатает timing_print_text
+        const StageTimes *t = r->times;
+        double sec[4] = {
+            t->total, t->sec[STAGE_READ],
+            t->sec[STAGE_SORT] + t->sec[STAGE_JOIN] + t->sec[STAGE_DEDUP],
+            t->sec[STAGE_WIRES]
+        };
+        static const char *names[4] = {
+            "Algorithm (sec)", "Read plot (sec)", "3D points (sec)", "Get wires (sec)"
+        };
+        for (int k = 0; k < 4; k++) {
+            writer_str(w, names[k]);
+            writer_str(w, "\r\n");
+            writer_fixed(w, sec[k], 3, '.');
+            writer_str(w, "\r\n");
+        }
+    }
+}
+
+int write_delta(Writer *w, const PointXYZ *added, size_t nadded,
+                const PointXYZ *removed, size_t nremoved) {
+    writer_str(w, "3D points added\r\n");
+    write_triples(w, added, nadded);
+    writer_str(w, "3D points removed\r\n");
+    write_triples(w, removed, nremoved);
+    return w->ok;
+}
+
+static int host_little_endian(void) {
+    const uint16_t one = 1;
+    return *(const unsigned char *)&one == 1;
+}
+
+static int write_ply(Writer *w, const ResultData *r) {
+    if (r->npts > INT32_MAX) return 0;
+    writer_str(w, "ply\nformat ");
+    writer_str(w, host_little_endian() ? "binary_little_endian" : "binary_big_endian");
+    writer_str(w, " 1.0\nelement vertex ");
+    writer_uint(w, r->npts);
+    writer_str(w, "\nproperty double x\nproperty double y\nproperty double z\n"
+                  "element edge ");
+    writer_uint(w, r->nedges);
+    writer_str(w, "\nproperty int vertex1\nproperty int vertex2\nend_header\n");
+
+    for (size_t i = 0; i < r->npts; i++) {
+        double v[3] = {r->pts[i].x, r->pts[i].y, r->pts[i].z};
+        writer_bytes(w, v, sizeof(v));
+    }
+    for (size_t e = 0; e < r->nedges; e++) {
+        int32_t ab[2] = {(int32_t)r->edges[e].a, (int32_t)r->edges[e].b};
+        writer_bytes(w, ab, sizeof(ab));
+    }
+    return 1;
+}
+
+static void write_obj(Writer *w, const ResultData *r) {
+    for (size_t i = 0; i < r->npts; i++) {
+        writer_str(w, "v ");
+        writer_fixed(w, r->pts[i].x, 6, '.');
+        writer_str(w, " ");
+        writer_fixed(w, r->pts[i].y, 6, '.');
+        writer_str(w, " ");
+        writer_fixed(w, r->pts[i].z, 6, '.');
+        writer_str(w, "\n");
+    }
+    for (size_t e = 0; e < r->nedges; e++) {
+        writer_str(w, "l ");
+        writer_uint(w, r->edges[e].a + 1);
+        writer_str(w, " ");
+        writer_uint(w, r->edges[e].b + 1);
+        writer_str(w, "\n");
+    }
+}
+
+static void write_bin(Writer *w, const ResultData *r) {
+    uint32_t version[2] = {RESULT_VERSION, 0};
+    uint64_t counts[2] = {r->npts, r->nedges};
+    writer_bytes(w, RESULT_MAGIC, 8);
+    writer_bytes(w, version, sizeof(version));
+    writer_bytes(w, counts, sizeof(counts));
+    // PointXYZ — три double подряд без выравнивания между ними
+    writer_bytes(w, r->pts, r->npts * sizeof(PointXYZ));
+    for (size_t e = 0; e < r->nedges; e++) {
+        uint64_t ab[2] = {r->edges[e].a, r->edges[e].b};
+        writer_bytes(w, ab, sizeof(ab));
+    }
+}
+
+int write_result(Writer *w, OutFormat f, const ResultData *r) {
+    switch (f) {
+    case OUT_LIST:   write_list(w, r); break;
+    case OUT_POINTS: write_points(w, r); break;
+    case OUT_PLY:    if (!write_ply(w, r)) return 0; break;
+    case OUT_OBJ:    write_obj(w, r); break;
+    case OUT_BIN:    write_bin(w, r); break;
+    }
+    return w->ok;
+}
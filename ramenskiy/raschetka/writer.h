@@ -0,0 +1,85 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "geom.h"
+#include "timing.h"
+#include "wires.h"
+
+/* Форматы результата восстановления */
+typedef enum {
+    OUT_LIST,      // "Точка N: (x, y, z)" и "Ребро N: a - b" — вывод try
+    OUT_POINTS,    // как "X 3D.txt": заголовок видов, "3D points", "3D edges", время
+    OUT_PLY,       // PLY, двоичный в порядке байтов машины: вершины и рёбра
+    OUT_OBJ,       // Wavefront OBJ: "v x y z" и "l a b"
+    OUT_BIN        // сырые массивы, см. ниже
+} OutFormat;
+
+/* Двоичный формат OUT_BIN (порядок байтов машины):
+   "RSRESULT", uint32 версия, uint32 0, uint64 число вершин,
+   uint64 число рёбер, вершины по три double, рёбра парами uint64
+   (номера вершин с нуля) */
+#define RESULT_MAGIC "RSRESULT"
+#define RESULT_VERSION 1
+
+/* Буферизованный вывод: текст собирается в большом буфере и уходит
+   в файл крупными блоками. Без файла (writer_open_mem) буфер растёт
+   и весь результат остаётся в buf[0, len) */
+typedef struct {
+    FILE *f;             // NULL — вывод в память
+    int owns;            // файл открыт writer_open и закрывается им
+    char *buf;
+    size_t len, cap;
+    int ok;
+} Writer;
+
+/* path == NULL или "-" — стандартный вывод. Возвращает 1 при успехе */
+int writer_open(Writer *w, const char *path);
+/* Вывод в память; буфер переиспользуется после writer_clear.
+   Возвращает 1 при успехе */
+int writer_open_mem(Writer *w);
+/* Пустой буфер вывода в память (выделенная память остаётся) */
+void writer_clear(Writer *w);
+/* Сброс буфера и закрытие; возвращает 1, если всё записано */
+int writer_close(Writer *w);
+
+void writer_bytes(Writer *w, const void *p, size_t n);
+void writer_str(Writer *w, const char *s);
+void writer_uint(Writer *w, uint64_t v);
+/* Число с decimals знаками после разделителя point, как printf("%.*f") */
+void writer_fixed(Writer *w, double v, int decimals, char point);
+
+/* Самая длинная запись format_fixed: 309 цифр double, знак, точка, 9 знаков */
+#define FIXED_MAX 336
+
+/* Запись v с decimals (0..9) знаками после point в out (не меньше
+   FIXED_MAX байт). Без printf, если число достаточно мало, чтобы
+   округление было однозначным; иначе через snprintf — результат всегда
+   как у "%.*f". Возвращает длину */
+size_t format_fixed(char *out, double v, int decimals, char point);
+
+/* "points", "ply", "obj", "bin" или "list"; 0 — неизвестный формат */
+int out_format_parse(const char *name, OutFormat *f);
+
+/* Результат восстановления для записи */
+typedef struct {
+    const PointXYZ *pts;
+    size_t npts;
+    const Edge3D *edges;
+    size_t nedges;
+    const double (*lcs)[2];      // lcs видов для OUT_POINTS, NULL — нули
+    const StageTimes *times;     // время этапов для OUT_POINTS, NULL — нет
+} ResultData;
+
+/* Запись результата в выбранном формате. Возвращает 1 при успехе */
+int write_result(Writer *w, OutFormat f, const ResultData *r);
+
+/* Изменение вершин после правки чертежа (incr.h): секции
+   "3D points added" и "3D points removed" с координатами, как
+   "3D points" формата points. Возвращает 1 при успехе */
+int write_delta(Writer *w, const PointXYZ *added, size_t nadded,
+                const PointXYZ *removed, size_t nremoved);
+
+#endif